@@ -10,8 +10,13 @@ Stratux AHRS Display
 #include <QFont>
 #include <QLinearGradient>
 #include <QLineF>
+#include <QDateTime>
+#include <QSettings>
+#include <QTransform>
+#include <QFontMetrics>
 
 #include <math.h>
+#include <stdarg.h>
 
 #include "AHRSCanvas.h"
 #include "BugSelector.h"
@@ -19,17 +24,28 @@ Stratux AHRS Display
 #include "AHRSMainWin.h"
 #include "StreamReader.h"
 #include "Builder.h"
+#include "PixmapCache.h"
+#include "StringTable.h"
+#include "AllocCounter.h"
 
 
 extern bool g_bEmulated;
 
 
+#define RadarMargin 1.5     // NEXRAD raster range as a multiple of the heading dial range so it isn't rebuilt every time ownship moves
+#define READOUT_LEN 32      // Room reserved in each of the formatted readout strings
+#define ReplayLeads 4       // Attitude leads the predictor's recent samples are replayed at on the GPS details page
+#define GPSLines    9       // Lines of text on the GPS details page
+#define LadderRungs 20      // Pitch ladder rungs each way from the horizon, 2.5 deg apart
+
+
 AHRSCanvas::AHRSCanvas( QWidget *parent )
     : QWidget( parent ),
       m_pCanvas( 0 ),
       m_bInitialized( false ),
       m_iHeadBugAngle( -1 ),
       m_iWindBugAngle( -1 ),
+      m_iAltBug( -1 ),
       m_pRollIndicator( 0 ),
       m_pHeadIndicator( 0 ),
       m_pAltTape( 0 ),
@@ -37,15 +53,33 @@ AHRSCanvas::AHRSCanvas( QWidget *parent )
       m_pVertSpeedTape( 0 ),
       m_eTrafficDisp( AHRS::AllTraffic ),
       m_bHideGPSLocation( false ),
+      m_iDispTimer( 0 ),
+      m_iFrameTimer( 0 ),
       m_bUpdated( false ),
       m_bShowWeather( false ),
-      m_bShowGPSDetails( false )
+      m_bShowGPSDetails( false ),
+      m_iIdentICAO( -1 ),
+      m_iFrames( 0 ),
+      m_iFrameNs( 0 ),
+      m_iMaxFrameNs( 0 ),
+      m_iFrameAllocs( 0 ),
+      m_iMaxFrameAllocs( 0 ),
+      m_iClock( 0 ),
+      m_iTrafficListWidth( 0 ),
+      m_iHead( -1 ),
+      m_iHeadWidth( 0 )
 {
-    // Initialize weather and AHRS settings
-    // No need to init the traffic because it starts out as an empty QMap.
-    StreamReader::initWeather( m_weather );
+    // Initialize AHRS settings
+    // No need to init the traffic or weather because their stores start out empty.
     StreamReader::initSituation( m_situation );
 
+    // How far ahead of the last AHRS sample to draw the attitude to make up for the sensor and network latency
+    QSettings config;
+
+    config.beginGroup( "Global" );
+    m_predictor.setHorizon( config.value( "AttitudeHorizonMs", 100 ).toInt() );
+    config.endGroup();
+
     // Preload the fancier icons that are impractical to paint programmatically
     m_planeIcon.load( ":/graphics/resources/Plane.png" );
     m_headIcon.load( ":/icons/resources/HeadingIcon.png" );
@@ -97,34 +131,120 @@ AHRSCanvas::~AHRSCanvas()
 
 
 // Create the canvas utility instance, create the various pixmaps that are built up for fast painting
-// and start the update timer.
+// (or load them from the pixmap cache) and start the update timer.
+// When called again on an already initialized canvas only the pixmaps whose geometry actually changed are rebuilt.
 void AHRSCanvas::init()
 {
-    m_pCanvas = new Canvas( width(), height() );
+    Canvas          *pCanvas = new Canvas( width(), height() );
+    CanvasConstants  c = pCanvas->contants();
+    bool             bWidthChanged = true;
+    bool             bHeightChanged = true;
+    bool             bHeadFontChanged = true;
 
-    CanvasConstants c = m_pCanvas->contants();
+    if( m_pCanvas != 0 )
+    {
+        CanvasConstants prev = m_pCanvas->contants();
+
+        // A change in font metrics (i.e. DPI) affects everything so treat it as both dimensions changing
+        if( (prev.iTinyFontHeight == c.iTinyFontHeight) && (prev.iSmallFontHeight == c.iSmallFontHeight) &&
+            (prev.iMedFontHeight == c.iMedFontHeight) && (prev.iLargeFontHeight == c.iLargeFontHeight) &&
+            (prev.iTinyFontWidth == c.iTinyFontWidth) )
+        {
+            bWidthChanged = (prev.dW != c.dW);
+            bHeightChanged = (prev.dH != c.dH);
+            bHeadFontChanged = ((prev.dW > 1080) != (c.dW > 1080));
+        }
+        delete m_pCanvas;
+    }
+    m_pCanvas = pCanvas;
 
-    m_pRollIndicator = new QPixmap( static_cast<int>( c.dW2 ), static_cast<int>( c.dH2 / c.dAspectP ) );
-    m_pHeadIndicator = new QPixmap( static_cast<int>( c.dW2 / (c.dW2 / (c.dH2 - c.dH7)) ), static_cast<int>( c.dH2 - c.dH7 ) );
-    m_pAltTape = new QPixmap( static_cast<int>( c.dW5 ) - 50, c.iTinyFontHeight * 400 );    // 20000 ft / 100 x double the font height
-    m_pVertSpeedTape = new QPixmap( 50, c.dH2 );
-    m_pSpeedTape = new QPixmap( static_cast<int>( c.dW5 ), c.iTinyFontHeight * 60 );        // 300 Knots x double the font height
-    m_pRollIndicator->fill( Qt::transparent );
-    m_pHeadIndicator->fill( Qt::transparent );
-    m_pAltTape->fill( Qt::transparent );
-    m_pSpeedTape->fill( Qt::transparent );
-    m_pVertSpeedTape->fill( Qt::transparent );
-    Builder::buildRollIndicator( m_pRollIndicator, m_pCanvas );
-    Builder::buildHeadingIndicator( m_pHeadIndicator, m_pCanvas );
-    Builder::buildAltTape( m_pAltTape, m_pCanvas );
-    Builder::buildSpeedTape( m_pSpeedTape, m_pCanvas );
-    Builder::buildVertSpeedTape( m_pVertSpeedTape, m_pCanvas );
-    m_iDispTimer = startTimer( 1000 );     // Just drives updating the canvas if we're not currently receiving anything new.
+    // Anything already built for this exact geometry is pulled from the on-disk cache instead of being rebuilt
+    PixmapCache cache( m_pCanvas, logicalDpiX(), devicePixelRatioF() );
+
+    // The roll indicator is square and sized from the width alone
+    if( bWidthChanged )
+    {
+        delete m_pRollIndicator;
+        m_pRollIndicator = new QPixmap( static_cast<int>( c.dW2 ), static_cast<int>( c.dH2 / c.dAspectP ) );
+        if( !cache.load( "RollIndicator", m_pRollIndicator ) )
+        {
+            m_pRollIndicator->fill( Qt::transparent );
+            Builder::buildRollIndicator( m_pRollIndicator, m_pCanvas );
+            cache.save( "RollIndicator", m_pRollIndicator );
+        }
+    }
+    // The heading indicator is sized from the height but its font size depends on the width
+    if( bHeightChanged || bHeadFontChanged )
+    {
+        delete m_pHeadIndicator;
+        m_pHeadIndicator = new QPixmap( static_cast<int>( c.dW2 / (c.dW2 / (c.dH2 - c.dH7)) ), static_cast<int>( c.dH2 - c.dH7 ) );
+        if( !cache.load( "HeadIndicator", m_pHeadIndicator ) )
+        {
+            m_pHeadIndicator->fill( Qt::transparent );
+            Builder::buildHeadingIndicator( m_pHeadIndicator, m_pCanvas );
+            cache.save( "HeadIndicator", m_pHeadIndicator );
+        }
+    }
+    // Altitude and speed tapes are the width of the side panels; their length only depends on the font
+    if( bWidthChanged )
+    {
+        delete m_pAltTape;
+        m_pAltTape = new QPixmap( static_cast<int>( c.dW5 ) - 50, c.iTinyFontHeight * 400 );    // 20000 ft / 100 x double the font height
+        // The altitude bug isn't cached so a bugged tape is always built fresh
+        if( (m_iAltBug != -1) || (!cache.load( "AltTape", m_pAltTape )) )
+        {
+            m_pAltTape->fill( Qt::transparent );
+            Builder::buildAltTape( m_pAltTape, m_pCanvas, m_iAltBug );
+            if( m_iAltBug == -1 )
+                cache.save( "AltTape", m_pAltTape );
+        }
+        delete m_pSpeedTape;
+        m_pSpeedTape = new QPixmap( static_cast<int>( c.dW5 ), c.iTinyFontHeight * 60 );        // 300 Knots x double the font height
+        if( !cache.load( "SpeedTape", m_pSpeedTape ) )
+        {
+            m_pSpeedTape->fill( Qt::transparent );
+            Builder::buildSpeedTape( m_pSpeedTape, m_pCanvas );
+            cache.save( "SpeedTape", m_pSpeedTape );
+        }
+    }
+    // The vertical speed tape is a fixed width and half the height
+    if( bHeightChanged )
+    {
+        delete m_pVertSpeedTape;
+        m_pVertSpeedTape = new QPixmap( 50, c.dH2 );
+        if( !cache.load( "VertSpeedTape", m_pVertSpeedTape ) )
+        {
+            m_pVertSpeedTape->fill( Qt::transparent );
+            Builder::buildVertSpeedTape( m_pVertSpeedTape, m_pCanvas );
+            cache.save( "VertSpeedTape", m_pVertSpeedTape );
+        }
+    }
+
+    // Paint tools; done here rather than in the constructor since the emulated flag isn't set until after that
+    QLinearGradient cloudyGradient( 0.0, 50.0, 0.0, c.dH - 50.0 );
+
+    initPaintTools();
+    cloudyGradient.setColorAt( 0, QColor( 255, 255, 255, 225 ) );
+    cloudyGradient.setColorAt( 1, QColor( 175, 175, 255, 225 ) );
+    m_cloudyBrush = QBrush( cloudyGradient );
+    if( m_radarDial.width() != m_pHeadIndicator->height() )
+    {
+        m_radarDial = QImage( m_pHeadIndicator->height(), m_pHeadIndicator->height(), QImage::Format_ARGB32_Premultiplied );
+        m_radarDial.fill( Qt::transparent );
+    }
+    m_iTrafficListWidth = QFontMetrics( m_trafficFont ).boundingRect( "N0000000" ).width();
+    m_iHead = -1;   // Measure the heading readout again
+
+    if( m_iDispTimer == 0 )
+        m_iDispTimer = startTimer( 1000 );     // Just drives updating the canvas if we're not currently receiving anything new.
     m_bInitialized = true;
+    updateFrameTimer();
 }
 
 
 // Android suspend
+// Resuming keeps the pixmaps, canvas constants and traffic as they were; init() only rebuilds
+// whatever depends on a geometry that changed while we were in the background.
 void AHRSCanvas::suspend( bool bSuspend )
 {
     if( bSuspend )
@@ -132,23 +252,47 @@ void AHRSCanvas::suspend( bool bSuspend )
         if( m_iDispTimer != 0 )
             killTimer( m_iDispTimer );
         m_iDispTimer = 0;
+        updateFrameTimer();
     }
-    else
+    else if( m_bInitialized )
     {
-        if( m_iDispTimer != 0 )
-            killTimer( m_iDispTimer );
-        m_iDispTimer = 0;
-        m_bInitialized = false;
-        delete m_pRollIndicator;
-        delete m_pHeadIndicator;
-        delete m_pAltTape;
-        delete m_pSpeedTape;
-        delete m_pVertSpeedTape;
         init();
+        update();
     }
 }
 
 
+// Paint times and what's being tracked for the metrics endpoint
+void AHRSCanvas::metrics( MetricsWriter &writer ) const
+{
+    writer.family( "rosco_frames_total", "counter", "Frames painted." );
+    writer.value( "rosco_frames_total", m_iFrames );
+    writer.family( "rosco_frame_seconds_total", "counter", "Time spent painting frames." );
+    writer.value( "rosco_frame_seconds_total", m_iFrameNs / 1.0e9 );
+    writer.family( "rosco_frame_max_seconds", "gauge", "Longest frame paint." );
+    writer.value( "rosco_frame_max_seconds", m_iMaxFrameNs / 1.0e9 );
+    if( AllocCounter::isEnabled() )
+    {
+        writer.family( "rosco_frame_allocations_total", "counter", "Heap allocations made while painting frames." );
+        writer.value( "rosco_frame_allocations_total", m_iFrameAllocs );
+        writer.family( "rosco_frame_max_allocations", "gauge", "Most heap allocations made painting one frame." );
+        writer.value( "rosco_frame_max_allocations", m_iMaxFrameAllocs );
+    }
+    writer.family( "rosco_traffic_tracked", "gauge", "Aircraft being tracked." );
+    writer.value( "rosco_traffic_tracked", m_trafficStore.count() );
+    writer.family( "rosco_traffic_positioned", "gauge", "Tracked aircraft with a position." );
+    writer.value( "rosco_traffic_positioned", m_trafficStore.positionCount() );
+    writer.family( "rosco_traffic_visible", "gauge", "Aircraft drawn on the last frame." );
+    writer.value( "rosco_traffic_visible", m_visibleTraffic.count() );
+    writer.family( "rosco_traffic_threats", "gauge", "Aircraft with a closest point of approach on the last frame." );
+    writer.value( "rosco_traffic_threats", m_threats.count() );
+    writer.family( "rosco_weather_products", "gauge", "Weather products held." );
+    writer.value( "rosco_weather_products", m_weatherStore.count() );
+    writer.family( "rosco_nexrad_tiles", "gauge", "NEXRAD blocks held." );
+    writer.value( "rosco_nexrad_tiles", m_nexrad.count() );
+}
+
+
 // Resize event - on Android typically happens once at init
 // Current android manifest locks the display to portait so it won't fire on rotating the device.
 // This needs some thought though since I'm not sure it's really necessary to lock it into portrait mode.
@@ -158,461 +302,910 @@ void AHRSCanvas::resizeEvent( QResizeEvent *pEvent )
         return;
 
     if( m_bInitialized )
-    {
-        if( m_iDispTimer != 0 )
-            killTimer( m_iDispTimer );
-        m_iDispTimer = 0;
-        m_bInitialized = false;
-        delete m_pRollIndicator;
-        delete m_pHeadIndicator;
-        delete m_pAltTape;
-        delete m_pSpeedTape;
-        delete m_pVertSpeedTape;
         init();
-    }
 }
 
 
 // Just a utility timer that periodically updates the display when it's not being driven by the streams
 // coming from the Stratux.
+// The frame timer only runs while there's traffic being dead-reckoned or AHRS samples to predict from and just repaints.
 void AHRSCanvas::timerEvent( QTimerEvent *pEvent )
 {
     if( pEvent == 0 )
         return;
 
+    if( pEvent->timerId() == m_iFrameTimer )
+    {
+        update();
+        return;
+    }
+
     if( !m_bUpdated )
         update();
     m_bUpdated = false;
+    updateFrameTimer();     // Stops the frame timer once the AHRS stream goes quiet
 }
 
 
-// Where all the magic happens
+// Current time for everything time based on the display; fixed while rendering offscreen so frames are repeatable
+qint64 AHRSCanvas::now() const
+{
+    if( m_iClock != 0 )
+        return m_iClock;
+
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+
+// Run the frame timer whenever the display is live and there's either positioned traffic or a live attitude to animate
+void AHRSCanvas::updateFrameTimer()
+{
+    bool bTraffic = (m_eTrafficDisp != AHRS::NoTraffic) && (m_trafficStore.positionCount() > 0);
+    bool bAnimate = (m_iDispTimer != 0) && (bTraffic || m_predictor.isLive( now() ));
+
+    if( bAnimate && (m_iFrameTimer == 0) )
+        m_iFrameTimer = startTimer( 16, Qt::PreciseTimer );
+    else if( (!bAnimate) && (m_iFrameTimer != 0) )
+    {
+        killTimer( m_iFrameTimer );
+        m_iFrameTimer = 0;
+    }
+}
+
+
+// Standard flight category colors
+// The magenta for LIFR is darkened a little to read against the light overlay.
+static QColor weatherCategoryColor( WeatherDecoder::FlightCategory eCategory )
+{
+    switch( eCategory )
+    {
+        case WeatherDecoder::VFR:
+            return QColor( 0, 160, 0 );
+        case WeatherDecoder::MVFR:
+            return QColor( Qt::blue );
+        case WeatherDecoder::IFR:
+            return QColor( Qt::red );
+        case WeatherDecoder::LIFR:
+            return QColor( 192, 0, 192 );
+        default:
+            return QColor( Qt::black );
+    }
+}
+
+
+static QString weatherCategoryName( WeatherDecoder::FlightCategory eCategory )
+{
+    switch( eCategory )
+    {
+        case WeatherDecoder::VFR:
+            return "VFR";
+        case WeatherDecoder::MVFR:
+            return "MVFR";
+        case WeatherDecoder::IFR:
+            return "IFR";
+        case WeatherDecoder::LIFR:
+            return "LIFR";
+        default:
+            return "----";
+    }
+}
+
+
+// Wind as direction@speed with the gust if there is one
+static QString weatherWind( const WeatherDecoder::Decoded &wx )
+{
+    QString qsWind;
+
+    if( wx.iWindSpeed < 0 )
+        return "--";
+    if( wx.iWindSpeed == 0 )
+        return "Calm";
+
+    qsWind = (wx.iWindDir < 0) ? QString( "VRB@%1" ).arg( wx.iWindSpeed ) : QString( "%1@%2" ).arg( wx.iWindDir, 3, 10, QChar( '0' ) ).arg( wx.iWindSpeed );
+    if( wx.iWindGust > 0 )
+        qsWind += QString( "G%1" ).arg( wx.iWindGust );
+
+    return qsWind;
+}
+
+
+// printf style formatting straight into a string that already has room reserved so it doesn't allocate
+// Readouts are short; anything past the reserved size is just cut off.
+static void setText( QString &qsText, const char *szFormat, ... )
+{
+    char    szText[READOUT_LEN];
+    int     iLen;
+    va_list args;
+    QChar  *pText;
+
+    va_start( args, szFormat );
+    iLen = qvsnprintf( szText, sizeof( szText ), szFormat, args );
+    va_end( args );
+    if( iLen < 0 )
+        iLen = 0;
+    else if( iLen >= READOUT_LEN )
+        iLen = READOUT_LEN - 1;
+
+    qsText.resize( iLen );
+    pText = qsText.data();
+    for( int i = 0; i < iLen; i++ )
+        pText[i] = QLatin1Char( szText[i] );
+}
+
+
+// Fill a rectangle with one of the 0 to 1 vertical gradient brushes stretched to run from dTop to dBottom
+// Scaling the painter instead of building a gradient for the span every frame keeps the fill from allocating.
+static void fillGradient( QPainter *pPainter, const QRectF &rect, double dTop, double dBottom, const QBrush &gradient )
+{
+    QTransform xform( pPainter->transform() );
+    double     dSpan = dBottom - dTop;
+
+    if( fabs( dSpan ) < 1.0 )
+        dSpan = (dSpan < 0.0) ? -1.0 : 1.0;
+
+    pPainter->translate( 0.0, dTop );
+    pPainter->scale( 1.0, dSpan );
+    pPainter->fillRect( QRectF( rect.x(), (rect.y() - dTop) / dSpan, rect.width(), rect.height() / dSpan ).normalized(), gradient );
+    pPainter->setTransform( xform );
+}
+
+
+// Draw the part of a pixmap placed at iX, iY that falls inside a rectangle without setting a clip on the painter
+static void drawClipped( QPainter *pPainter, int iX, int iY, const QPixmap &pixmap, const QRect &clip )
+{
+    QRect target( QRect( iX, iY, pixmap.width(), pixmap.height() ) & clip );
+
+    if( !target.isEmpty() )
+        pPainter->drawPixmap( target, pixmap, target.translated( -iX, -iY ) );
+}
+
+
+// Where a line from a to b is inside a circle of radius dRadius around the origin, as fractions of the way along it
+// Returns false if it doesn't go through the circle at all.
+static bool clipToCircle( const QPointF &a, const QPointF &b, double dRadius, double &dEnter, double &dLeave )
+{
+    double dDX = b.x() - a.x();
+    double dDY = b.y() - a.y();
+    double dA = (dDX * dDX) + (dDY * dDY);
+    double dB = (a.x() * dDX) + (a.y() * dDY);
+    double dC = (a.x() * a.x()) + (a.y() * a.y()) - (dRadius * dRadius);
+    double dRoot;
+
+    if( dA <= 0.0 )
+    {
+        dEnter = 0.0;
+        dLeave = 1.0;
+        return dC <= 0.0;
+    }
+    dRoot = (dB * dB) - (dA * dC);
+    if( dRoot <= 0.0 )
+        return false;
+    dRoot = sqrt( dRoot );
+    dEnter = qMax( 0.0, (-dB - dRoot) / dA );
+    dLeave = qMin( 1.0, (-dB + dRoot) / dA );
+
+    return dEnter < dLeave;
+}
+
+
+// Paint the display into the widget
 void AHRSCanvas::paintEvent( QPaintEvent *pEvent )
 {
     if( (!m_bInitialized) || (pEvent == 0) )
         return;
 
-    QPainter        ahrs( this );
-    CanvasConstants c = m_pCanvas->contants();
-    double          dPitchH = c.dH2 + (m_situation.dAHRSpitch / 22.5 * c.dH2);     // The visible portion is only 1/4 of the 90 deg range
-    double          dArrowOffset = g_bEmulated ? 20 : 30;
-    QString         qsHead( QString::number( static_cast<int>( m_situation.dAHRSGyroHeading ) ) );
-    QPolygon        shape;
-    QPen            linePen( Qt::black );
-    double          dSlipSkid = c.dW2 - ((m_situation.dAHRSSlipSkid / 100.0) * c.dW2);
-    QFont           tiny( "Roboto", 12, QFont::Normal );
-    QFont           small( "Roboto", 16, QFont::Bold );
-    QFont           med( "Roboto", 18, QFont::Bold );
-    QFont           large( "Roboto", 24, QFont::Bold );
+    QPainter ahrs( this );
+    qint64   iFrameNs;
+    qint64   iAllocs = AllocCounter::count();
+
+    m_frameTime.start();
+    paintFrame( &ahrs );
+    iFrameNs = m_frameTime.nsecsElapsed();
+    iAllocs = AllocCounter::count() - iAllocs;
+
+    m_iFrames++;
+    m_iFrameNs += iFrameNs;
+    if( iFrameNs > m_iMaxFrameNs )
+        m_iMaxFrameNs = iFrameNs;
+    m_iFrameAllocs += iAllocs;
+    if( iAllocs > m_iMaxFrameAllocs )
+        m_iMaxFrameAllocs = iAllocs;
+}
+
+
+// Where all the magic happens
+// Draws the whole display with whatever painter it's given so it can go to the widget or an offscreen image alike.
+void AHRSCanvas::paintFrame( QPainter *pAhrs )
+{
+    CanvasConstants             c = m_pCanvas->contants();
+    AttitudePredictor::Attitude att = m_predictor.predict( now() );
+    double                      dPitchH = c.dH2 + (att.dPitch / 22.5 * c.dH2);     // The visible portion is only 1/4 of the 90 deg range
+    double                      dArrowOffset = g_bEmulated ? 20 : 30;
+    int                         iHead = static_cast<int>( att.dHeading );
+    double                      dSlipSkid = c.dW2 - ((m_situation.dAHRSSlipSkid / 100.0) * c.dW2);
+    double                      dDistInc = m_pHeadIndicator->height() / 80.0 * 1.75;   // The heading indicator outer diameter = 20NM
+    double                      dLadderTop = (m_pRollIndicator->height() / 3) + c.iLargeFontHeight + 50.0;
 
     if( dSlipSkid < (c.dW4 + 25.0) )
         dSlipSkid = c.dW4 + 25.0;
     else if( dSlipSkid > (c.dW2 + c.dW4 - 25.0) )
         dSlipSkid = c.dW2 + c.dW4 - 25.0;
 
-    linePen.setWidth( 3 );
+    // The heading readout is only measured again when the heading it shows changes
+    if( iHead != m_iHead )
+    {
+        setText( m_qsHead, "%d", iHead );
+        m_iHeadWidth = m_largeGlyphs.width( m_qsHead );
+        m_iHead = iHead;
+    }
 
-    ahrs.setRenderHints( QPainter::Antialiasing | QPainter::TextAntialiasing, true );
+    pAhrs->setRenderHints( QPainter::Antialiasing | QPainter::TextAntialiasing, true );
 
     // Translate to dead center and rotate by stratux roll then translate back
-    ahrs.translate( c.dW2, c.dH2 );
-    ahrs.rotate( -m_situation.dAHRSroll );
-    ahrs.translate( -c.dW2, -c.dH2 );
+    pAhrs->translate( c.dW2, c.dH2 );
+    pAhrs->rotate( -att.dRoll );
+    pAhrs->translate( -c.dW2, -c.dH2 );
 
     // Top half sky blue gradient offset by stratux pitch
-    QLinearGradient skyGradient( 0.0, -c.dH2, 0.0, dPitchH );
-    skyGradient.setColorAt( 0, Qt::blue );
-    skyGradient.setColorAt( 1, QColor( 85, 170, 255 ) );
-    ahrs.fillRect( -800.0, -c.dH2, c.dW + 1600.0, dPitchH + c.dH2, skyGradient );
+    fillGradient( pAhrs, QRectF( -800.0, -c.dH2, c.dW + 1600.0, dPitchH + c.dH2 ), -c.dH2, dPitchH, m_skyBrush );
 
     // Draw brown gradient horizon half offset by stratux pitch
-    QLinearGradient groundGradient( 0.0, dPitchH, 0, c.dH + c.dH2 );
-    groundGradient.setColorAt( 0, QColor( 170, 85, 0  ) );
-    groundGradient.setColorAt( 1, Qt::black );
     // Extreme overdraw accounts for extreme roll angles that might expose the corners
-    ahrs.fillRect( -800.0, dPitchH, c.dW + 1600.0, c.dH + c.dH2, groundGradient );
-    ahrs.setPen( linePen );
-    ahrs.drawLine( -800, dPitchH, c.dW + 1600.0, dPitchH );
-
-    ahrs.setClipRect( 0, (m_pRollIndicator->height() / 3) + c.iLargeFontHeight + 50.0, c.dW, c.dH );
-    for( int i = 0; i < 50; i += 10 )
-    {
-        linePen.setColor( Qt::cyan );
-        ahrs.setPen( linePen );
-        ahrs.drawLine( c.dW2 - c.dW20, dPitchH - ((i + 2.5) / 22.5 * c.dH2), c.dW2 + c.dW20, dPitchH - ((i + 2.5) / 22.5 * c.dH2) );
-        ahrs.drawLine( c.dW2 - c.dW20, dPitchH - ((i + 5.0) / 22.5 * c.dH2), c.dW2 + c.dW20, dPitchH - ((i + 5.0) / 22.5 * c.dH2) );
-        ahrs.drawLine( c.dW2 - c.dW20, dPitchH - ((i + 7.5) / 22.5 * c.dH2), c.dW2 + c.dW20, dPitchH - ((i + 7.5) / 22.5 * c.dH2) );
-        ahrs.drawLine( c.dW2 - c.dW5, dPitchH - ((i + 10.0) / 22.5 * c.dH2), c.dW2 + c.dW5, dPitchH - (( i + 10.0) / 22.5 * c.dH2) );
-        linePen.setColor( QColor( 67, 33, 9 ) );
-        ahrs.setPen( linePen );
-        ahrs.drawLine( c.dW2 - c.dW20, dPitchH + ((i + 2.5) / 22.5 * c.dH2), c.dW2 + c.dW20, dPitchH + ((i + 2.5) / 22.5 * c.dH2) );
-        ahrs.drawLine( c.dW2 - c.dW20, dPitchH + ((i + 5.0) / 22.5 * c.dH2), c.dW2 + c.dW20, dPitchH + ((i + 5.0) / 22.5 * c.dH2) );
-        ahrs.drawLine( c.dW2 - c.dW20, dPitchH + ((i + 7.5) / 22.5 * c.dH2), c.dW2 + c.dW20, dPitchH + ((i + 7.5) / 22.5 * c.dH2) );
-        ahrs.drawLine( c.dW2 - c.dW5, dPitchH + ((i + 10.0) / 22.5 * c.dH2), c.dW2 + c.dW5, dPitchH + (( i + 10.0) / 22.5 * c.dH2) );
-    }
-    ahrs.setClipping( false );
+    fillGradient( pAhrs, QRectF( -800.0, dPitchH, c.dW + 1600.0, c.dH + c.dH2 ), dPitchH, c.dH + c.dH2, m_groundBrush );
+    pAhrs->setPen( m_linePen );
+    pAhrs->drawLine( -800, dPitchH, c.dW + 1600.0, dPitchH );
+
+    // Pitch ladder every 2.5 deg out to 50 with a long rung every 10, sky side then ground side
+    // The rungs are level in the rolled frame so the ones that would run up under the roll indicator are
+    // left out rather than clipped.
+    for( int iSide = -1; iSide <= 1; iSide += 2 )
+    {
+        pAhrs->setPen( (iSide < 0) ? m_skyLadderPen : m_groundLadderPen );
+        for( int iRung = 1; iRung <= LadderRungs; iRung++ )
+        {
+            double dRungY = dPitchH + (iSide * (iRung * 2.5) / 22.5 * c.dH2);
+            double dHalfWidth = ((iRung % 4) == 0) ? c.dW5 : c.dW20;
+
+            if( (dRungY < dLadderTop) || (dRungY > (dLadderTop + c.dH)) )
+                continue;
+            pAhrs->drawLine( QLineF( c.dW2 - dHalfWidth, dRungY, c.dW2 + dHalfWidth, dRungY ) );
+        }
+    }
 
     // Reset rotation
-    ahrs.resetTransform();
+    pAhrs->resetTransform();
 
     // Slip/Skid indicator
-    ahrs.setPen( QPen( Qt::white, 5 ) );
-    ahrs.setBrush( Qt::black );
-    ahrs.drawRect( c.dW2 - c.dW4, 1, c.dW2, c.iLargeFontHeight );
-    ahrs.drawRect( c.dW2 - 30.0, 1.0, 60.0, c.iLargeFontHeight );
-    ahrs.setPen( Qt::NoPen );
-    ahrs.setBrush( Qt::white );
-    ahrs.drawEllipse( dSlipSkid - 25.0,
-                      1.0,
-                      50.0,
-                      c.iLargeFontHeight );
+    pAhrs->setPen( m_framePen );
+    pAhrs->setBrush( m_blackBrush );
+    pAhrs->drawRect( c.dW2 - c.dW4, 1, c.dW2, c.iLargeFontHeight );
+    pAhrs->drawRect( c.dW2 - 30.0, 1.0, 60.0, c.iLargeFontHeight );
+    pAhrs->setPen( Qt::NoPen );
+    pAhrs->setBrush( m_whiteBrush );
+    pAhrs->drawEllipse( dSlipSkid - 25.0,
+                        1.0,
+                        50.0,
+                        c.iLargeFontHeight );
 
     // Draw the top roll indicator
-    ahrs.translate( c.dW2, c.iLargeFontHeight + c.dH4 + 20.0 );
-    ahrs.rotate( -m_situation.dAHRSroll );
-    ahrs.translate( -c.dW2, -(c.iLargeFontHeight + c.dH4 + 20.0) );
-    ahrs.drawPixmap( c.dW2 - c.dW4, (c.iLargeFontHeight * 2) + 20.0, *m_pRollIndicator );
-    ahrs.resetTransform();
-
-    QPolygonF arrow;
-
-    arrow.append( QPointF( c.dW2, (c.iLargeFontHeight * 2) + (g_bEmulated ? 70.0 : 130.0) ) );
-    arrow.append( QPointF( c.dW2 + dArrowOffset, (c.iLargeFontHeight * 2) + (g_bEmulated ? 70.0 : 130.0) + dArrowOffset ) );
-    arrow.append( QPointF( c.dW2 - dArrowOffset, (c.iLargeFontHeight * 2) + (g_bEmulated ? 70.0 : 130.0) + dArrowOffset ) );
-    ahrs.setBrush( Qt::white );
-    ahrs.setPen( Qt::black );
-    ahrs.drawPolygon( arrow );
+    pAhrs->translate( c.dW2, c.iLargeFontHeight + c.dH4 + 20.0 );
+    pAhrs->rotate( -att.dRoll );
+    pAhrs->translate( -c.dW2, -(c.iLargeFontHeight + c.dH4 + 20.0) );
+    pAhrs->drawPixmap( c.dW2 - c.dW4, (c.iLargeFontHeight * 2) + 20.0, *m_pRollIndicator );
+    pAhrs->resetTransform();
+
+    m_arrow.resize( 0 );
+    m_arrow.append( QPointF( c.dW2, (c.iLargeFontHeight * 2) + (g_bEmulated ? 70.0 : 130.0) ) );
+    m_arrow.append( QPointF( c.dW2 + dArrowOffset, (c.iLargeFontHeight * 2) + (g_bEmulated ? 70.0 : 130.0) + dArrowOffset ) );
+    m_arrow.append( QPointF( c.dW2 - dArrowOffset, (c.iLargeFontHeight * 2) + (g_bEmulated ? 70.0 : 130.0) + dArrowOffset ) );
+    pAhrs->setBrush( m_whiteBrush );
+    pAhrs->setPen( m_blackPen );
+    pAhrs->drawPolygon( m_arrow );
 
     // Draw the yellow pitch indicators
-    ahrs.setBrush( Qt::yellow );
-    shape.append( QPoint( c.dW5 + c.dW20, c.dH2 - c.dH160 ) );
-    shape.append( QPoint( c.dW2 - c.dW10, c.dH2 - c.dH160 ) );
-    shape.append( QPoint( c.dW2 - c.dW10 + (g_bEmulated ? 10 : 20) , c.dH2 ) );
-    shape.append( QPoint( c.dW2 - c.dW10, c.dH2 + c.dH160 ) );
-    shape.append( QPoint( c.dW5 + c.dW20, c.dH2 + c.dH160 ) );
-    ahrs.drawPolygon( shape );
-    shape.clear();
-    shape.append( QPoint( c.dW - c.dW5 - c.dW20, c.dH2 - c.dH160 ) );
-    shape.append( QPoint( c.dW2 + c.dW10, c.dH2 - c.dH160 ) );
-    shape.append( QPoint( c.dW2 + c.dW10 - (g_bEmulated ? 10 : 20), c.dH2 ) );
-    shape.append( QPoint( c.dW2 + c.dW10, c.dH2 + c.dH160 ) );
-    shape.append( QPoint( c.dW - c.dW5 - c.dW20, c.dH2 + c.dH160 ) );
-    ahrs.drawPolygon( shape );
-    shape.clear();
-    shape.append( QPoint( c.dW2, c.dH2 ) );
-    shape.append( QPoint( c.dW2 - c.dW10, c.dH2 + (g_bEmulated ? 20 : 40) ) );
-    shape.append( QPoint( c.dW2 + c.dW10, c.dH2 + (g_bEmulated ? 20 : 40) ) );
-    ahrs.drawPolygon( shape );
+    pAhrs->setBrush( m_yellowBrush );
+    m_shape.resize( 0 );
+    m_shape.append( QPoint( c.dW5 + c.dW20, c.dH2 - c.dH160 ) );
+    m_shape.append( QPoint( c.dW2 - c.dW10, c.dH2 - c.dH160 ) );
+    m_shape.append( QPoint( c.dW2 - c.dW10 + (g_bEmulated ? 10 : 20) , c.dH2 ) );
+    m_shape.append( QPoint( c.dW2 - c.dW10, c.dH2 + c.dH160 ) );
+    m_shape.append( QPoint( c.dW5 + c.dW20, c.dH2 + c.dH160 ) );
+    pAhrs->drawPolygon( m_shape );
+    m_shape.resize( 0 );
+    m_shape.append( QPoint( c.dW - c.dW5 - c.dW20, c.dH2 - c.dH160 ) );
+    m_shape.append( QPoint( c.dW2 + c.dW10, c.dH2 - c.dH160 ) );
+    m_shape.append( QPoint( c.dW2 + c.dW10 - (g_bEmulated ? 10 : 20), c.dH2 ) );
+    m_shape.append( QPoint( c.dW2 + c.dW10, c.dH2 + c.dH160 ) );
+    m_shape.append( QPoint( c.dW - c.dW5 - c.dW20, c.dH2 + c.dH160 ) );
+    pAhrs->drawPolygon( m_shape );
+    m_shape.resize( 0 );
+    m_shape.append( QPoint( c.dW2, c.dH2 ) );
+    m_shape.append( QPoint( c.dW2 - c.dW10, c.dH2 + (g_bEmulated ? 20 : 40) ) );
+    m_shape.append( QPoint( c.dW2 + c.dW10, c.dH2 + (g_bEmulated ? 20 : 40) ) );
+    pAhrs->drawPolygon( m_shape );
 
     // Draw the heading value over the indicator
-    ahrs.setPen( QPen( Qt::white, 5 ) );
-    ahrs.setBrush( Qt::black );
-    ahrs.drawRect( c.dW2 - c.dW10, c.dH - m_pHeadIndicator->height() - 45.0 - c.iLargeFontHeight, c.dW5, c.iLargeFontHeight );
-    ahrs.setPen( Qt::white );
-    ahrs.setFont( large );
-    ahrs.drawText( c.dW2 - (m_pCanvas->largeWidth( qsHead ) / 2), c.dH - m_pHeadIndicator->height() - 45.0 - c.iAltSpeedOffset, qsHead );
+    pAhrs->setPen( m_framePen );
+    pAhrs->setBrush( m_blackBrush );
+    pAhrs->drawRect( c.dW2 - c.dW10, c.dH - m_pHeadIndicator->height() - 45.0 - c.iLargeFontHeight, c.dW5, c.iLargeFontHeight );
+    m_largeGlyphs.draw( pAhrs, c.dW2 - (m_iHeadWidth / 2), c.dH - m_pHeadIndicator->height() - 45.0 - c.iAltSpeedOffset, m_qsHead );
 
     // Arrow for heading position above heading dial
-    arrow.clear();
-    arrow.append( QPointF( c.dW2, c.dH - m_pHeadIndicator->height() - 15.0 ) );
-    arrow.append( QPointF( c.dW2 + dArrowOffset, c.dH - m_pHeadIndicator->height() - 35.0 ) );
-    arrow.append( QPointF( c.dW2 - dArrowOffset, c.dH - m_pHeadIndicator->height() - 35.0 ) );
-    ahrs.setBrush( Qt::white );
-    ahrs.setPen( Qt::black );
-    ahrs.drawPolygon( arrow );
+    m_arrow.resize( 0 );
+    m_arrow.append( QPointF( c.dW2, c.dH - m_pHeadIndicator->height() - 15.0 ) );
+    m_arrow.append( QPointF( c.dW2 + dArrowOffset, c.dH - m_pHeadIndicator->height() - 35.0 ) );
+    m_arrow.append( QPointF( c.dW2 - dArrowOffset, c.dH - m_pHeadIndicator->height() - 35.0 ) );
+    pAhrs->setBrush( m_whiteBrush );
+    pAhrs->setPen( m_blackPen );
+    pAhrs->drawPolygon( m_arrow );
+
+    // NM east and north of ownship to the screen over the heading indicator, turned to the heading it's drawn at
+    // Built once a frame and used for everything placed on the dial (radar, traffic, trails, threat rings) and
+    // backwards for presses on it, so they all line up with the dial and with each other.
+    m_dial.reset();
+    m_dial.translate( c.dW2, c.dH - (m_pHeadIndicator->height() / 2) - 10.0 );
+    m_dial.rotate( -att.dHeading );
+    m_dial.scale( dDistInc, -dDistInc );
 
     // Draw the heading pixmap and rotate it to the current heading
-    ahrs.translate( c.dW2, c.dH - (m_pHeadIndicator->height() / 2) - 10.0 );
-    ahrs.rotate( -m_situation.dAHRSGyroHeading );
-    ahrs.translate( -c.dW2, -(c.dH - (m_pHeadIndicator->height() / 2) - 10.0) );
-    ahrs.drawPixmap( c.dW2 - (m_pHeadIndicator->width() / 2), c.dH - m_pHeadIndicator->height() - 10.0, *m_pHeadIndicator );
-    ahrs.resetTransform();
+    pAhrs->translate( c.dW2, c.dH - (m_pHeadIndicator->height() / 2) - 10.0 );
+    pAhrs->rotate( -att.dHeading );
+    pAhrs->translate( -c.dW2, -(c.dH - (m_pHeadIndicator->height() / 2) - 10.0) );
+    pAhrs->drawPixmap( c.dW2 - (m_pHeadIndicator->width() / 2), c.dH - m_pHeadIndicator->height() - 10.0, *m_pHeadIndicator );
+    pAhrs->resetTransform();
+
+    // Draw the NEXRAD raster over the dial, north-up and turned with it
+    // The raster is kept centred near ownship and only redrawn as blocks arrive; turning it onto the round dial
+    // image here means it goes to the screen without a clip region, which the painter would allocate for.
+    if( (m_situation.dGPSlat != 0.0) || (m_situation.dGPSlong != 0.0) )
+    {
+        m_nexrad.setView( m_situation.dGPSlat, m_situation.dGPSlong, (m_pHeadIndicator->height() / 2.0) / dDistInc * RadarMargin );
+        if( !m_nexrad.isEmpty() )
+        {
+            m_nexrad.drawDial( m_radarDial, m_situation.dGPSlat, m_situation.dGPSlong, att.dHeading, dDistInc );
+            pAhrs->drawImage( QPointF( c.dW2 - (m_radarDial.width() / 2.0), c.dH - m_pHeadIndicator->height() - 10.0 ), m_radarDial );
+        }
+    }
 
     // Draw the central airplane
-    ahrs.drawPixmap( QRect( c.dW2 - c.dW20, c.dH - 10 - (m_pHeadIndicator->height() / 2) - c.dH20, c.dW10, c.dH10 ), m_planeIcon );
+    pAhrs->drawPixmap( QRect( c.dW2 - c.dW20, c.dH - 10 - (m_pHeadIndicator->height() / 2) - c.dH20, c.dW10, c.dH10 ), m_planeIcon );
 
     // Draw the heading bug
     if( m_iHeadBugAngle >= 0 )
     {
-        ahrs.translate( c.dW2, c.dH - (m_pHeadIndicator->height() / 2) - 10.0 );
-        ahrs.rotate( m_iHeadBugAngle + m_situation.dAHRSGyroHeading );
-        ahrs.translate( -c.dW2, -(c.dH - (m_pHeadIndicator->height() / 2) - 10.0) );
-        ahrs.drawPixmap( c.dW2 - 50, c.dH - m_pHeadIndicator->height() - 50.0, m_headIcon );
-        ahrs.resetTransform();
+        pAhrs->translate( c.dW2, c.dH - (m_pHeadIndicator->height() / 2) - 10.0 );
+        pAhrs->rotate( m_iHeadBugAngle + att.dHeading );
+        pAhrs->translate( -c.dW2, -(c.dH - (m_pHeadIndicator->height() / 2) - 10.0) );
+        pAhrs->drawPixmap( c.dW2 - 50, c.dH - m_pHeadIndicator->height() - 50.0, m_headIcon );
+        pAhrs->resetTransform();
     }
 
     // Draw the wind bug
     if( m_iWindBugAngle >= 0 )
     {
-        ahrs.translate( c.dW2, c.dH - (m_pHeadIndicator->height() / 2) - 10.0 );
-        ahrs.rotate( m_iWindBugAngle + m_situation.dAHRSGyroHeading );
-        ahrs.translate( -c.dW2, -(c.dH - (m_pHeadIndicator->height() / 2) - 10.0) );
-        ahrs.drawPixmap( c.dW2 - 50, c.dH - m_pHeadIndicator->height() - 50.0, m_windIcon );
-        ahrs.resetTransform();
+        pAhrs->translate( c.dW2, c.dH - (m_pHeadIndicator->height() / 2) - 10.0 );
+        pAhrs->rotate( m_iWindBugAngle + att.dHeading );
+        pAhrs->translate( -c.dW2, -(c.dH - (m_pHeadIndicator->height() / 2) - 10.0) );
+        pAhrs->drawPixmap( c.dW2 - 50, c.dH - m_pHeadIndicator->height() - 50.0, m_windIcon );
+        pAhrs->resetTransform();
     }
 
     // Draw the Altitude tape
-    linePen.setColor( Qt::white );
-    linePen.setWidth( 5 );
-    ahrs.setPen( linePen );
-    ahrs.setBrush( Qt::NoBrush );
-    ahrs.drawRect( c.dW - c.dW5, 1.0, c.dW5, c.dH2 - 1.0 );
-    ahrs.setClipRect( c.dW - c.dW5 + 1.0, 2.0, c.dW5 - 4.0, c.dH2 - 4.0 );
-    ahrs.drawPixmap( c.dW - c.dW5 + 5.0, c.dH4 - (c.iTinyFontHeight * 2) - (((20000.0 - m_situation.dBaroPressAlt) / 20000.0) * m_pAltTape->height()), *m_pAltTape );
-    ahrs.setClipping( false );
+    pAhrs->setPen( m_framePen );
+    pAhrs->setBrush( Qt::NoBrush );
+    pAhrs->drawRect( c.dW - c.dW5, 1.0, c.dW5, c.dH2 - 1.0 );
+    drawClipped( pAhrs, c.dW - c.dW5 + 5.0, c.dH4 - (c.iTinyFontHeight * 2) - (((20000.0 - m_situation.dBaroPressAlt) / 20000.0) * m_pAltTape->height()), *m_pAltTape,
+                 QRect( c.dW - c.dW5 + 1.0, 2.0, c.dW5 - 4.0, c.dH2 - 4.0 ) );
 
     // Draw the dividing line and vertical speed static pixmap
-    ahrs.drawLine( c.dW - 50.0, 1.0, c.dW - 50.0, c.dH2 - 1.0 );
-    ahrs.drawPixmap( c.dW - 50.0, 0.0, *m_pVertSpeedTape );
+    pAhrs->drawLine( c.dW - 50.0, 1.0, c.dW - 50.0, c.dH2 - 1.0 );
+    pAhrs->drawPixmap( c.dW - 50.0, 0.0, *m_pVertSpeedTape );
 
     // Draw the vertical speed indicator
-    ahrs.translate( 0.0, m_situation.dGPSVertSpeed / 1000.0 * c.dH4 );
-    arrow.clear();
-    arrow.append( QPoint( c.dW - dArrowOffset, c.dH4 ) );
-    arrow.append( QPoint( c.dW, c.dH4 - dArrowOffset ) );
-    arrow.append( QPoint( c.dW, c.dH4 + dArrowOffset ) );
-    ahrs.setPen( Qt::black );
-    ahrs.setBrush( Qt::white );
-    ahrs.drawPolygon( arrow );
-    ahrs.resetTransform();
+    pAhrs->translate( 0.0, m_situation.dGPSVertSpeed / 1000.0 * c.dH4 );
+    m_arrow.resize( 0 );
+    m_arrow.append( QPoint( c.dW - dArrowOffset, c.dH4 ) );
+    m_arrow.append( QPoint( c.dW, c.dH4 - dArrowOffset ) );
+    m_arrow.append( QPoint( c.dW, c.dH4 + dArrowOffset ) );
+    pAhrs->setPen( m_blackPen );
+    pAhrs->setBrush( m_whiteBrush );
+    pAhrs->drawPolygon( m_arrow );
+    pAhrs->resetTransform();
 
     // Draw the current altitude
-    ahrs.setPen( linePen );
-    ahrs.setBrush( Qt::black );
-    ahrs.drawRect( c.dW - c.dW5, c.dH4 - (c.iLargeFontHeight / 2), c.dW5 - 50.0, c.iLargeFontHeight );
-    ahrs.setPen( Qt::white );
-    ahrs.setFont( small );
-    ahrs.drawText( c.dW - c.dW5 + 5, c.dH4 + (c.iLargeFontHeight / 2) - c.iAltSpeedOffset, QString::number( static_cast<int>( m_situation.dBaroPressAlt ) ) );
+    pAhrs->setPen( m_framePen );
+    pAhrs->setBrush( m_blackBrush );
+    pAhrs->drawRect( c.dW - c.dW5, c.dH4 - (c.iLargeFontHeight / 2), c.dW5 - 50.0, c.iLargeFontHeight );
+    setText( m_qsAlt, "%d", static_cast<int>( m_situation.dBaroPressAlt ) );
+    m_smallGlyphs.draw( pAhrs, c.dW - c.dW5 + 5, c.dH4 + (c.iLargeFontHeight / 2) - c.iAltSpeedOffset, m_qsAlt );
 
     // Draw the Speed tape
-    linePen.setColor( Qt::white );
-    linePen.setWidth( 5 );
-    ahrs.setPen( linePen );
-    ahrs.setBrush( Qt::NoBrush );
-    ahrs.drawRect( 0, 1.0, c.dW5, c.dH2 - 1.0 );
-    ahrs.setClipRect( 2.0, 2.0, c.dW5 - 4.0, c.dH2 - 4.0 );
-    ahrs.drawPixmap( 3, c.dH4 - c.iSmallFontHeight - (((300.0 - m_situation.dGPSGroundSpeed) / 300.0) * m_pSpeedTape->height()), *m_pSpeedTape );
-    ahrs.setClipping( false );
+    pAhrs->setPen( m_framePen );
+    pAhrs->setBrush( Qt::NoBrush );
+    pAhrs->drawRect( 0, 1.0, c.dW5, c.dH2 - 1.0 );
+    drawClipped( pAhrs, 3, c.dH4 - c.iSmallFontHeight - (((300.0 - m_situation.dGPSGroundSpeed) / 300.0) * m_pSpeedTape->height()), *m_pSpeedTape,
+                 QRect( 2.0, 2.0, c.dW5 - 4.0, c.dH2 - 4.0 ) );
 
     // Draw the current speed
-    ahrs.setBrush( Qt::black );
-    ahrs.drawRect( 0, c.dH4 - (c.iLargeFontHeight / 2), c.dW5, c.iLargeFontHeight );
-    ahrs.setPen( Qt::white );
-    ahrs.setFont( large );
-    ahrs.drawText( 5, c.dH4 + (c.iLargeFontHeight / 2) - c.iAltSpeedOffset, QString::number( static_cast<int>( m_situation.dGPSGroundSpeed ) ) );
+    pAhrs->setBrush( m_blackBrush );
+    pAhrs->drawRect( 0, c.dH4 - (c.iLargeFontHeight / 2), c.dW5, c.iLargeFontHeight );
+    setText( m_qsSpeed, "%d", static_cast<int>( m_situation.dGPSGroundSpeed ) );
+    m_largeGlyphs.draw( pAhrs, 5, c.dH4 + (c.iLargeFontHeight / 2) - c.iAltSpeedOffset, m_qsSpeed );
 
     // Draw the G-Force indicator box and scale
-    ahrs.setPen( linePen );
-    ahrs.setBrush( Qt::NoBrush );
-    ahrs.drawRect( 0, c.dH2, c.dW5, c.iLargeFontHeight );
-    ahrs.setFont( tiny );
-    ahrs.setPen( Qt::white );
-    ahrs.drawText( 5, c.dH2 + c.iTinyFontHeight, "2" );
-    ahrs.drawText( (c.dW5 / 2) - (c.iTinyFontWidth / 2), c.dH2 + c.iTinyFontHeight, "0" );
-    ahrs.drawText( c.dW5 - c.iTinyFontWidth - 5, c.dH2 + c.iTinyFontHeight, "2" );
+    pAhrs->setPen( m_framePen );
+    pAhrs->setBrush( Qt::NoBrush );
+    pAhrs->drawRect( 0, c.dH2, c.dW5, c.iLargeFontHeight );
+    m_tinyGlyphs.draw( pAhrs, 5, c.dH2 + c.iTinyFontHeight, QStringLiteral( "2" ) );
+    m_tinyGlyphs.draw( pAhrs, (c.dW5 / 2) - (c.iTinyFontWidth / 2), c.dH2 + c.iTinyFontHeight, QStringLiteral( "0" ) );
+    m_tinyGlyphs.draw( pAhrs, c.dW5 - c.iTinyFontWidth - 5, c.dH2 + c.iTinyFontHeight, QStringLiteral( "2" ) );
 
     // Arrow for G-Force indicator
-    arrow.clear();
-    arrow.append( QPoint( c.dW10, c.dH2 + c.iLargeFontHeight - dArrowOffset ) );
-    arrow.append( QPoint( c.dW10 - dArrowOffset, c.dH2 + c.iLargeFontHeight ) );
-    arrow.append( QPoint( c.dW10 + dArrowOffset, c.dH2 + c.iLargeFontHeight ) );
-    ahrs.setPen( Qt::black );
-    ahrs.setBrush( Qt::white );
-    ahrs.translate( (m_situation.dAHRSGLoad - 1.0) * c.dW5, 0.0 );
-    ahrs.drawPolygon( arrow );
-    ahrs.resetTransform();
+    m_arrow.resize( 0 );
+    m_arrow.append( QPoint( c.dW10, c.dH2 + c.iLargeFontHeight - dArrowOffset ) );
+    m_arrow.append( QPoint( c.dW10 - dArrowOffset, c.dH2 + c.iLargeFontHeight ) );
+    m_arrow.append( QPoint( c.dW10 + dArrowOffset, c.dH2 + c.iLargeFontHeight ) );
+    pAhrs->setPen( m_blackPen );
+    pAhrs->setBrush( m_whiteBrush );
+    pAhrs->translate( (m_situation.dAHRSGLoad - 1.0) * c.dW5, 0.0 );
+    pAhrs->drawPolygon( m_arrow );
+    pAhrs->resetTransform();
 
     // GPS Lat/Long
-    ahrs.setPen( linePen );
-    ahrs.setBrush( Qt::black );
-    ahrs.drawRect( c.dW - c.dW5, c.dH2, c.dW5, c.iLargeFontHeight );
-    ahrs.drawRect( c.dW - c.dW5, c.dH2 + c.iLargeFontHeight, c.dW5, c.iLargeFontHeight );
-    ahrs.setPen( Qt::green );
-    ahrs.setFont( small );
-    QString qsLat = QString( "%1 %2" )
-                        .arg( m_bHideGPSLocation ? 12.3456 : fabs( m_situation.dGPSlat ) )
-                        .arg( (m_situation.dGPSlat < 0.0) ? "E" : "W" );
-    QString qsLong = QString( "%1 %2" )
-                        .arg( m_bHideGPSLocation ? 34.5678 : fabs( m_situation.dGPSlong ) )
-                        .arg( (m_situation.dGPSlong < 0.0) ? "N" : "S" );
-
-    ahrs.drawText( c.dW - c.dW5 + 8.0, c.dH2 + c.iLargeFontHeight - c.iAltSpeedOffset - 4, qsLat );
-    ahrs.drawText( c.dW - c.dW5 + 8.0, c.dH2 + (c.iLargeFontHeight * 2) - c.iAltSpeedOffset - 4, qsLong );
+    pAhrs->setPen( m_framePen );
+    pAhrs->setBrush( m_blackBrush );
+    pAhrs->drawRect( c.dW - c.dW5, c.dH2, c.dW5, c.iLargeFontHeight );
+    pAhrs->drawRect( c.dW - c.dW5, c.dH2 + c.iLargeFontHeight, c.dW5, c.iLargeFontHeight );
+    setText( m_qsLat, "%g %c", m_bHideGPSLocation ? 12.3456 : fabs( m_situation.dGPSlat ), (m_situation.dGPSlat < 0.0) ? 'E' : 'W' );
+    setText( m_qsLong, "%g %c", m_bHideGPSLocation ? 34.5678 : fabs( m_situation.dGPSlong ), (m_situation.dGPSlong < 0.0) ? 'N' : 'S' );
+    m_positionGlyphs.draw( pAhrs, c.dW - c.dW5 + 8.0, c.dH2 + c.iLargeFontHeight - c.iAltSpeedOffset - 4, m_qsLat );
+    m_positionGlyphs.draw( pAhrs, c.dW - c.dW5 + 8.0, c.dH2 + (c.iLargeFontHeight * 2) - c.iAltSpeedOffset - 4, m_qsLong );
 
     // Traffic altitude key
-    ahrs.setPen( linePen );
-    ahrs.setBrush( Qt::black );
-    ahrs.drawRect( 0, c.dH2 + c.iLargeFontHeight, c.dW5, c.iLargeFontHeight );
-    ahrs.setPen( Qt::NoPen );
-    ahrs.drawPixmap( 3.0, c.dH2 + c.iLargeFontHeight + 2.0, c.dW5 - 5.0, c.iLargeFontHeight - 4.0, m_trafficAltKey );
+    pAhrs->setPen( m_framePen );
+    pAhrs->setBrush( m_blackBrush );
+    pAhrs->drawRect( 0, c.dH2 + c.iLargeFontHeight, c.dW5, c.iLargeFontHeight );
+    pAhrs->setPen( Qt::NoPen );
+    pAhrs->drawPixmap( 3.0, c.dH2 + c.iLargeFontHeight + 2.0, c.dW5 - 5.0, c.iLargeFontHeight - 4.0, m_trafficAltKey );
 
     if( m_eTrafficDisp != AHRS::NoTraffic )
-        updateTraffic( &ahrs, c.dH2 + (c.iLargeFontHeight * 2.0) + 30.0 );
-
-    QLinearGradient cloudyGradient( 0.0, 50.0, 0.0, c.dH - 50.0 );
-    cloudyGradient.setColorAt( 0, QColor( 255, 255, 255, 225 ) );
-    cloudyGradient.setColorAt( 1, QColor( 175, 175, 255, 225 ) );
+        updateTraffic( pAhrs, c.dH2 + (c.iLargeFontHeight * 2.0) + 30.0 );
 
+    // The overlay pages draw text that was formatted when what they show last changed
     if( m_bShowWeather )
     {
-        linePen.setColor( Qt::black );
-        linePen.setWidth( 3 );
-        ahrs.setPen( linePen );
-        ahrs.setBrush( cloudyGradient );
-        ahrs.drawRect( 50, 50, c.dW - 100, c.dH - 100 );
-        ahrs.setFont( med );
-        if( m_weather.prodTime.date() == QDate( 2000, 1, 1 ) )
-            ahrs.drawText( 100, 100, "No Weather Data Available" );
-        else
+        double dLinePos = 100.0 + (c.iMedFontHeight * 2);
+
+        pAhrs->setPen( m_linePen );
+        pAhrs->setBrush( m_cloudyBrush );
+        pAhrs->drawRect( 50, 50, c.dW - 100, c.dH - 100 );
+        pAhrs->setFont( m_medFont );
+        if( !m_weatherText.isEmpty() )
+            pAhrs->drawText( 100, 100, m_weatherText.first() );
+
+        // One line per station colored by flight category
+        for( int i = 1; (i < m_weatherText.count()) && (dLinePos < (c.dH - 100.0)); i++ )
         {
-            ahrs.drawText( 100, 100, m_weather.prodTime.toString() );
-            ahrs.drawText( 100, 100 + (c.iMedFontHeight * 3), m_weather.qsType );
-            ahrs.drawText( 100, 100 + (c.iMedFontHeight * 5), m_weather.qsLocation );
-            ahrs.drawText( 100, 100 + (c.iMedFontHeight * 7), m_weather.qsData );
-            ahrs.drawText( 100, 100 + (c.iMedFontHeight * 9), m_weather.qsLastMessage );
+            pAhrs->setPen( m_categoryPens[m_weatherCategories.at( i )] );
+            pAhrs->drawText( 100, dLinePos, m_weatherText.at( i ) );
+            dLinePos += c.iMedFontHeight * 1.5;
         }
     }
 
     if( m_bShowGPSDetails )
     {
-        linePen.setColor( Qt::black );
-        linePen.setWidth( 3 );
-        ahrs.setPen( linePen );
-        ahrs.setBrush( cloudyGradient );
-        ahrs.drawRect( 50, 50, c.dW - 100, c.dH - 100 );
-        ahrs.setFont( med );
-        ahrs.drawText( 100, 100, "GPS Status" );
-        ahrs.drawText( 100, 100 + (c.iMedFontHeight * 3),  QString( "GPS Satellites Seen: %1" ).arg( m_situation.iGPSSatsSeen ) );
-        ahrs.drawText( 100, 100 + (c.iMedFontHeight * 5),  QString( "GPS Satellites Tracked: %1" ).arg( m_situation.iGPSSatsTracked ) );
-        ahrs.drawText( 100, 100 + (c.iMedFontHeight * 7),  QString( "GPS Satellites Locked: %1" ).arg( m_situation.iGPSSats ) );
-        ahrs.drawText( 100, 100 + (c.iMedFontHeight * 9),  QString( "GPS Fix Quality: %1" ).arg( m_situation.iGPSFixQuality ) );
+        static const int iGPSRow[GPSLines] = { 0, 3, 5, 7, 9, 13, 15, 17, 19 };
+
+        pAhrs->setPen( m_linePen );
+        pAhrs->setBrush( m_cloudyBrush );
+        pAhrs->drawRect( 50, 50, c.dW - 100, c.dH - 100 );
+        pAhrs->setFont( m_medFont );
+        for( int i = 0; (i < m_gpsText.count()) && (i < GPSLines); i++ )
+            pAhrs->drawText( 100, 100 + (c.iMedFontHeight * iGPSRow[i]), m_gpsText.at( i ) );
+    }
+
+    // Details for a traffic dot that was tapped
+    if( m_iIdentICAO != -1 )
+    {
+        if( !m_trafficStore.traffic().contains( m_iIdentICAO ) )
+            m_iIdentICAO = -1;
+        else
+        {
+            pAhrs->setPen( m_linePen );
+            pAhrs->setBrush( m_cloudyBrush );
+            pAhrs->drawRect( 50, 50, c.dW - 100, c.dH - 100 );
+            pAhrs->setFont( m_medFont );
+            for( int i = 0; i < m_identText.count(); i++ )
+                pAhrs->drawText( 100, 100 + (c.iMedFontHeight * ((i == 0) ? 0 : ((i * 2) + 1))), m_identText.at( i ) );
+        }
     }
 }
 
 
-// Draw the traffic onto the heading indicator and the tail numbers on the side
-void AHRSCanvas::updateTraffic( QPainter *pAhrs, double dListPos )
+// Weather page text; a heading and then one line per station
+// Each line's flight category goes alongside it to pick its pen (the heading's is never used).
+void AHRSCanvas::buildWeatherText()
+{
+    m_weatherText.resize( 0 );
+    m_weatherCategories.resize( 0 );
+    m_weatherStore.observations( m_weatherList );
+    if( m_weatherStore.count() == 0 )
+        m_weatherText.append( "No Weather Data Available" );
+    else
+        m_weatherText.append( QString( "Weather: %1 products, %2 repeats ignored" ).arg( m_weatherStore.count() ).arg( m_weatherStore.duplicates() ) );
+    m_weatherCategories.append( WeatherDecoder::UnknownCategory );
+
+    // Straight from what was decoded when each report arrived
+    for( int i = 0; i < m_weatherList.count(); i++ )
+    {
+        const WeatherDecoder::Decoded &wx = m_weatherList.at( i )->decoded;
+
+        m_weatherText.append( QString( "%1  %2  %3  %4  %5" )
+                                  .arg( QString::fromLatin1( m_weatherList.at( i )->location ), -5 )
+                                  .arg( weatherCategoryName( wx.eCategory ), -4 )
+                                  .arg( weatherWind( wx ) )
+                                  .arg( (wx.dVisibility < 0.0) ? QString( "--" ) : QString( "%1SM" ).arg( wx.dVisibility, 0, 'g', 2 ) )
+                                  .arg( (wx.iCeiling < 0) ? QString( "No Ceiling" ) : QString( "Ceiling %1" ).arg( wx.iCeiling ) ) );
+        m_weatherCategories.append( wx.eCategory );
+    }
+}
+
+
+// GPS details page text; the satellites, fix and how well the attitude predictor is doing
+void AHRSCanvas::buildGPSText()
 {
-    QList<StratuxTraffic> trafficList = m_trafficMap.values();
-    StratuxTraffic        traffic;
-    double                dDistInc = m_pHeadIndicator->height() / 80.0 * 1.75;   // The heading indicator outer diameter = 20NM
-    QPen                  planePen( Qt::black, g_bEmulated ? 15 : 30, Qt::SolidLine, Qt::RoundCap, Qt::BevelJoin );
-    CanvasConstants       c = m_pCanvas->contants();
-    QFont                 trafficFont( "Roboto", 12, QFont::Bold );
-    QFontMetrics          trafficMetrics( trafficFont );
-    QRect                 trafficRect( trafficMetrics.boundingRect( "N0000000" ) );
-    int                   iTrafficCount = trafficList.count();
+    // The same recent samples replayed at other leads to show whether the configured one is a good choice
+    static const int iReplayLead[ReplayLeads] = { 0, 50, 100, 200 };
+
+    AttitudePredictor::Accuracy acc = m_predictor.accuracy();
+    QString                     qsRollReplay( "Replayed RMS Roll" );
+    QString                     qsHeadReplay( "Replayed RMS Hdg" );
 
-    foreach( traffic, trafficList )
+    m_predictor.history( m_replaySamples );
+    for( int i = 0; i < ReplayLeads; i++ )
     {
-        if( (m_eTrafficDisp == AHRS::ADSBOnlyTraffic) && (!traffic.bHasADSB) )
-            iTrafficCount--;
+        AttitudePredictor::Accuracy replayAcc = AttitudePredictor::replay( m_replaySamples, iReplayLead[i] );
+
+        qsRollReplay += QString( "  %1 ms: %2" ).arg( iReplayLead[i] ).arg( replayAcc.dRollRMS, 0, 'f', 1 );
+        qsHeadReplay += QString( "  %1 ms: %2" ).arg( iReplayLead[i] ).arg( replayAcc.dHeadingRMS, 0, 'f', 1 );
     }
+
+    m_gpsText.resize( 0 );
+    m_gpsText.append( "GPS Status" );
+    m_gpsText.append( QString( "GPS Satellites Seen: %1" ).arg( m_situation.iGPSSatsSeen ) );
+    m_gpsText.append( QString( "GPS Satellites Tracked: %1" ).arg( m_situation.iGPSSatsTracked ) );
+    m_gpsText.append( QString( "GPS Satellites Locked: %1" ).arg( m_situation.iGPSSats ) );
+    m_gpsText.append( QString( "GPS Fix Quality: %1" ).arg( m_situation.iGPSFixQuality ) );
+    m_gpsText.append( QString( "Attitude Lead: %1 ms (%2 samples)" ).arg( m_predictor.horizon() ).arg( acc.iSamples ) );
+    m_gpsText.append( QString( "RMS Error Roll: %1  Pitch: %2  Hdg: %3" )
+                          .arg( acc.dRollRMS, 0, 'f', 1 )
+                          .arg( acc.dPitchRMS, 0, 'f', 1 )
+                          .arg( acc.dHeadingRMS, 0, 'f', 1 ) );
+    m_gpsText.append( qsRollReplay );
+    m_gpsText.append( qsHeadReplay );
+}
+
+
+// Traffic ident page text for the aircraft that was tapped; lets go of it if it's no longer tracked
+void AHRSCanvas::buildIdentText()
+{
+    QMap<int, StratuxTraffic>::const_iterator ident = m_trafficStore.traffic().constFind( m_iIdentICAO );
+
+    m_identText.resize( 0 );
+    if( ident == m_trafficStore.traffic().constEnd() )
+    {
+        m_iIdentICAO = -1;
+        return;
+    }
+
+    const StratuxTraffic &identTraffic = ident.value();
+
+    m_identText.append( QString( "Traffic %1" ).arg( QString::number( m_iIdentICAO, 16 ).rightJustified( 6, QChar( '0' ) ).toUpper() ) );
+    m_identText.append( QString( "Registration: %1" ).arg( StringTable::string( identTraffic.iReg ) ) );
+    m_identText.append( QString( "Tail: %1" ).arg( StringTable::string( identTraffic.iTail ) ) );
+    m_identText.append( QString( "Altitude: %1 ft" ).arg( static_cast<int>( identTraffic.fAlt ) ) );
+    m_identText.append( QString( "Distance: %1 NM" ).arg( identTraffic.fDist, 0, 'f', 1 ) );
+    m_identText.append( QString( "Bearing: %1" ).arg( static_cast<int>( identTraffic.fBearing ) ) );
+    m_identText.append( QString( "Track: %1  Speed: %2 kts" ).arg( static_cast<int>( identTraffic.fTrack ) ).arg( static_cast<int>( identTraffic.fSpeed ) ) );
+    m_identText.append( QString( "Squawk: %1" ).arg( identTraffic.iSquawk, 4, 10, QChar( '0' ) ) );
+}
+
+
+// Which altitude color band a traffic target falls into
+// Each threshold starts a new band; anything below the first one is band zero.
+static int trafficBand( double dAlt )
+{
+    static const double dBandAlt[TRAFFIC_ALT_BANDS - 1] = { 2000.0, 5000.0, 10000.0, 12000.0, 15000.0, 18000.0, 20000.0, 25000.0, 30000.0, 40000.0 };
+
+    int iBand = 0;
+
+    while( (iBand < (TRAFFIC_ALT_BANDS - 1)) && (dAlt >= dBandAlt[iBand]) )
+        iBand++;
+
+    return iBand;
+}
+
+
+// Color for each altitude band (matches the altitude key graphic)
+static QColor trafficBandColor( int iBand )
+{
+    static const QColor bandColor[TRAFFIC_ALT_BANDS] =
+    {
+        QColor( Qt::black ),        // Gray is hard to see on the gray gradient so the gray text is black
+        QColor( 0, 128, 128 ),      // teal
+        QColor( 128, 0, 128 ),      // purple
+        QColor( Qt::red ),
+        QColor( Qt::magenta ),
+        QColor( Qt::green ),
+        QColor( Qt::yellow ),
+        QColor( Qt::blue ),
+        QColor( Qt::cyan ),
+        QColor( 173, 255, 47 ),     // snot green
+        QColor( 214, 153, 255 )     // lavender
+    };
+
+    return bandColor[iBand];
+}
+
+
+// Fonts, pens and brushes that don't depend on the display geometry
+// Every combination painted is built here once; changing a pen or brush the painter still holds would copy it.
+void AHRSCanvas::initPaintTools()
+{
+    QLinearGradient skyGradient( 0.0, 0.0, 0.0, 1.0 );
+    QLinearGradient groundGradient( 0.0, 0.0, 0.0, 1.0 );
+    QLinearGradient trafficGradient( 0.0, 0.0, 0.0, 1.0 );
+    int             iBand, iCategory;
+
+    m_tinyFont = QFont( "Roboto", 12, QFont::Normal );
+    m_smallFont = QFont( "Roboto", 16, QFont::Bold );
+    m_medFont = QFont( "Roboto", 18, QFont::Bold );
+    m_largeFont = QFont( "Roboto", 24, QFont::Bold );
+    m_trafficFont = QFont( "Roboto", 12, QFont::Bold );
+
+    m_blackPen = QPen( Qt::black );
+    m_linePen = QPen( Qt::black, 3 );
+    m_skyLadderPen = QPen( Qt::cyan, 3 );
+    m_groundLadderPen = QPen( QColor( 67, 33, 9 ), 3 );
+    m_framePen = QPen( Qt::white, 5 );
+    m_alertPen = QPen( Qt::red, g_bEmulated ? 3 : 5 );
+    m_advisoryPen = QPen( Qt::yellow, g_bEmulated ? 3 : 5 );
+    m_largeGlyphs.build( m_largeFont, Qt::white );
+    m_smallGlyphs.build( m_smallFont, Qt::white );
+    m_positionGlyphs.build( m_smallFont, Qt::green );
+    m_tinyGlyphs.build( m_tinyFont, Qt::white );
+    m_alertGlyphs.build( m_trafficFont, Qt::red );
+    m_advisoryGlyphs.build( m_trafficFont, Qt::yellow );
+    for( iBand = 0; iBand < TRAFFIC_ALT_BANDS; iBand++ )
+    {
+        m_bandGlyphs[iBand].build( m_trafficFont, trafficBandColor( iBand ) );
+        m_bandTrailPens[iBand] = QPen( trafficBandColor( iBand ), g_bEmulated ? 2 : 4, Qt::SolidLine, Qt::RoundCap, Qt::BevelJoin );
+        m_bandDotPens[iBand] = QPen( trafficBandColor( iBand ), g_bEmulated ? 15 : 30, Qt::SolidLine, Qt::RoundCap, Qt::BevelJoin );
+        m_bandMarkerPens[iBand] = QPen( trafficBandColor( iBand ), 7, Qt::SolidLine, Qt::RoundCap, Qt::BevelJoin );
+    }
+
+    for( iCategory = WeatherDecoder::UnknownCategory; iCategory <= WeatherDecoder::LIFR; iCategory++ )
+        m_categoryPens[iCategory] = QPen( weatherCategoryColor( static_cast<WeatherDecoder::FlightCategory>( iCategory ) ) );
+
+    m_blackBrush = QBrush( Qt::black );
+    m_whiteBrush = QBrush( Qt::white );
+    m_yellowBrush = QBrush( Qt::yellow );
+    skyGradient.setColorAt( 0, Qt::blue );
+    skyGradient.setColorAt( 1, QColor( 85, 170, 255 ) );
+    m_skyBrush = QBrush( skyGradient );
+    groundGradient.setColorAt( 0, QColor( 170, 85, 0  ) );
+    groundGradient.setColorAt( 1, Qt::black );
+    m_groundBrush = QBrush( groundGradient );
+    trafficGradient.setColorAt( 0, Qt::lightGray );
+    trafficGradient.setColorAt( 1, Qt::darkGray );
+    m_trafficListBrush = QBrush( trafficGradient );
+
+    m_qsHead.reserve( READOUT_LEN );
+    m_qsAlt.reserve( READOUT_LEN );
+    m_qsSpeed.reserve( READOUT_LEN );
+    m_qsLat.reserve( READOUT_LEN );
+    m_qsLong.reserve( READOUT_LEN );
+    m_qsThreat.reserve( READOUT_LEN );
+}
+
+
+// Draw the traffic onto the heading indicator and the tail numbers on the side
+// Screen positions are worked out in one pass (no painter transforms) and sorted into altitude color bands
+// so each band goes to the painter as a single drawPoints call.
+void AHRSCanvas::updateTraffic( QPainter *pAhrs, double dListPos )
+{
+    const QMap<int, StratuxTraffic>           &trafficMap = m_trafficStore.traffic();
+    QMap<int, StratuxTraffic>::const_iterator  it;
+    double                                     dDistInc = m_pHeadIndicator->height() / 80.0 * 1.75;   // The heading indicator outer diameter = 20NM
+    double                                     dRange = (m_pHeadIndicator->height() / 2.0) / dDistInc;
+    CanvasConstants                            c = m_pCanvas->contants();
+    int                                        iTrafficCount = (m_eTrafficDisp == AHRS::ADSBOnlyTraffic) ? m_trafficStore.positionCount() : m_trafficStore.count();
+    int                                        iBand;
+    QString                                    qsNotAvailable( QStringLiteral( " N/A " ) );
+
     if( iTrafficCount > 0 )
     {
-        QLinearGradient trafficGradient( 0.0, dListPos - 10.0, 0.0, dListPos - 10.0 + (c.iTinyFontHeight * (trafficList.count() + 1)) );
+        QRectF listRect( c.dW - m_iTrafficListWidth - 40.0, dListPos - 10.0, m_iTrafficListWidth + 20, c.iTinyFontHeight * (iTrafficCount + 1) );
+
+        fillGradient( pAhrs, listRect, listRect.top(), listRect.bottom(), m_trafficListBrush );
+        pAhrs->setPen( m_blackPen );
+        pAhrs->setBrush( Qt::NoBrush );
+        pAhrs->drawRect( listRect );
+    }
 
-        trafficGradient.setColorAt( 0, Qt::lightGray );
-        trafficGradient.setColorAt( 1, Qt::darkGray );
-        pAhrs->setPen( Qt::black );
-        pAhrs->setBrush( trafficGradient );
-        pAhrs->drawRect( c.dW - trafficRect.width() - 40.0, dListPos - 10.0, trafficRect.width() + 20, c.iTinyFontHeight * (trafficList.count() + 1) );
+    for( iBand = 0; iBand < TRAFFIC_ALT_BANDS; iBand++ )
+    {
+        m_trafficPoints[iBand].resize( 0 );
+        m_trafficMarkers[iBand].resize( 0 );
     }
 
-    pAhrs->setFont( trafficFont );
+    // Move everything along from its last fix so the dots glide between updates
+    m_trafficStore.extrapolate( now() );
+    for( int i = 0; i < m_trafficStore.dropped().count(); i++ )
+        m_trafficTrails.remove( m_trafficStore.dropped().at( i ) );
 
-    // Draw a large dot for each aircraft; the outer edge of the heading indicator is calibrated to be 20 NM out from your position
-    foreach( traffic, trafficList )
+    // Only the aircraft inside the outer ring of the heading indicator get a dot
+    // Positions come out of the store as NM east/north of ownship so rotating them to the heading takes
+    // the same sin/cos for every target.
+    m_trafficStore.inRange( dRange, m_visibleTraffic );
+    for( int i = 0; i < m_visibleTraffic.count(); i++ )
     {
-        if( (m_eTrafficDisp == AHRS::ADSBOnlyTraffic) && (!traffic.bHasADSB) )
+        const TrafficStore::Target &target = m_visibleTraffic.at( i );
+
+        it = trafficMap.constFind( target.iICAO );
+        if( it == trafficMap.constEnd() )
             continue;
+        m_trafficPoints[trafficBand( it.value().fAlt )].append( m_dial.map( QPointF( target.dX, target.dY ) ) );
+    }
 
-        planePen.setColor( Qt::black );                   // Gray is hard to see on the gray gradient so the gray text is black
-        if( traffic.dAlt >= 2000.0 )
-            planePen.setColor( QColor( 0, 128, 128 ) );   // teal
-        if( traffic.dAlt >= 5000.0 )
-            planePen.setColor( QColor( 128, 0, 128 ) );   // purple
-        if( traffic.dAlt >= 10000.0 )
-            planePen.setColor( Qt::red );
-        if( traffic.dAlt >= 12000.0 )
-            planePen.setColor( Qt::magenta );
-        if( traffic.dAlt >= 15000.0 )
-            planePen.setColor( Qt::green );
-        if( traffic.dAlt >= 18000.0 )
-            planePen.setColor( Qt::yellow );
-        if( traffic.dAlt >= 20000.0 )
-            planePen.setColor( Qt::blue );
-        if( traffic.dAlt >= 25000.0 )
-            planePen.setColor( Qt::cyan );
-        if( traffic.dAlt >= 30000.0 )
-            planePen.setColor( QColor( 173, 255, 47 ) );  // snot green
-        if( traffic.dAlt >= 40000.0 )
-            planePen.setColor( QColor( 214, 153, 255 ) ); // lavender
-
-        // If bearing and distance were able to be calculated then show relative position
-        if( traffic.bHasADSB )
+    // Trails behind the visible aircraft, cut at the edge of the dial and ending at the current (dead-reckoned) dot
+    // The trail positions are absolute so they need an ownship GPS position to be placed. Each leg is cut to the
+    // dial's circle before it's mapped rather than setting a clip region, which the painter would allocate for;
+    // a trail that goes off the dial and comes back is drawn as separate lines.
+    if( (m_situation.dGPSlat != 0.0) || (m_situation.dGPSlong != 0.0) )
+    {
+        double dEnter, dLeave;
+
+        for( int i = 0; i < m_visibleTraffic.count(); i++ )
         {
-            pAhrs->translate( c.dW2, c.dH - (m_pHeadIndicator->height() / 2) - 10.0 );
-            pAhrs->rotate( traffic.dBearing + m_situation.dAHRSMagHeading );
-            pAhrs->translate( -c.dW2, -(c.dH - (m_pHeadIndicator->height() / 2) - 10.0) );
-            planePen.setWidth( g_bEmulated ? 15 : 30 );
-            pAhrs->setPen( planePen );
-            pAhrs->drawPoint( c.dW2, c.dH - (m_pHeadIndicator->height() / 2) - 10.0 - (traffic.dDist * dDistInc) );
-            pAhrs->resetTransform();
+            const TrafficStore::Target &target = m_visibleTraffic.at( i );
+
+            if( !m_trafficTrails.relative( target.iICAO, m_situation.dGPSlat, m_situation.dGPSlong, m_trailPoints ) )
+                continue;
+            it = trafficMap.constFind( target.iICAO );
+            if( it == trafficMap.constEnd() )
+                continue;
+
+            m_trailPoints.append( QPointF( target.dX, target.dY ) );
+            pAhrs->setPen( m_bandTrailPens[trafficBand( it.value().fAlt )] );
+            m_trailLine.resize( 0 );
+            for( int j = 1; j < m_trailPoints.count(); j++ )
+            {
+                const QPointF &from = m_trailPoints.at( j - 1 );
+                const QPointF &to = m_trailPoints.at( j );
+
+                if( !clipToCircle( from, to, dRange, dEnter, dLeave ) )
+                    continue;
+                // A leg coming in from outside the dial starts a new line
+                if( (dEnter > 0.0) || m_trailLine.isEmpty() )
+                {
+                    if( m_trailLine.count() > 1 )
+                        pAhrs->drawPolyline( m_trailLine );
+                    m_trailLine.resize( 0 );
+                    m_trailLine.append( m_dial.map( from + ((to - from) * dEnter) ) );
+                }
+                m_trailLine.append( m_dial.map( from + ((to - from) * dLeave) ) );
+            }
+            if( m_trailLine.count() > 1 )
+                pAhrs->drawPolyline( m_trailLine );
         }
+    }
+
+    // Ring each aircraft on the dial that's on a collision course; red for an alert, yellow for an advisory,
+    // with the seconds to closest approach alongside
+    m_trafficStore.threats( m_threats );
+    pAhrs->setBrush( Qt::NoBrush );
+    for( int i = 0; i < m_threats.count(); i++ )
+    {
+        const TrafficStore::Threat &threat = m_threats.at( i );
 
-        // List the tail numbers along the right side
-        planePen.setWidth( 1 );
-        pAhrs->setPen( planePen );
+        if( ((threat.dX * threat.dX) + (threat.dY * threat.dY)) > (dRange * dRange) )
+            continue;
+
+        QPointF threatPt( m_dial.map( QPointF( threat.dX, threat.dY ) ) );
+        double  dRingRad = g_bEmulated ? 14.0 : 28.0;
+
+        pAhrs->setPen( threat.bAlert ? m_alertPen : m_advisoryPen );
+        pAhrs->drawEllipse( threatPt, dRingRad, dRingRad );
+        setText( m_qsThreat, "%ds", static_cast<int>( threat.dTCPA ) );
+        (threat.bAlert ? m_alertGlyphs : m_advisoryGlyphs).draw( pAhrs, threatPt.x() + dRingRad + 5.0, threatPt.y() + (c.iTinyFontHeight / 2.0), m_qsThreat );
+    }
+
+    // List the tail numbers along the right side
+    for( it = trafficMap.constBegin(); it != trafficMap.constEnd(); ++it )
+    {
+        const StratuxTraffic &traffic = it.value();
+
+        if( (m_eTrafficDisp == AHRS::ADSBOnlyTraffic) && (!m_trafficStore.hasPosition( it.key() )) )
+            continue;
+
+        iBand = trafficBand( traffic.fAlt );
         dListPos += c.iTinyFontHeight;
-        if( traffic.qsReg.isEmpty() )
-            traffic.qsReg = " N/A ";
-        pAhrs->drawText( c.dW - trafficRect.width() - 20.0, dListPos, traffic.qsReg );
-        // Draw a marker dot next to traffic that is also transmitting ADSB position
-        if( traffic.bHasADSB )
+        m_bandGlyphs[iBand].draw( pAhrs, c.dW - m_iTrafficListWidth - 20.0, dListPos, (traffic.iReg == 0) ? qsNotAvailable : StringTable::string( traffic.iReg ) );
+        // Mark traffic in the list that is also transmitting ADSB position (and still current enough to be on the dial)
+        if( m_trafficStore.hasPosition( it.key() ) )
+            m_trafficMarkers[iBand].append( QPointF( c.dW - m_iTrafficListWidth - 30.0, dListPos - (c.iTinyFontHeight / 2) + 3 ) );
+    }
+
+    // One batch per color band for the dots on the heading indicator and the list markers
+    for( iBand = 0; iBand < TRAFFIC_ALT_BANDS; iBand++ )
+    {
+        if( !m_trafficPoints[iBand].isEmpty() )
+        {
+            pAhrs->setPen( m_bandDotPens[iBand] );
+            pAhrs->drawPoints( m_trafficPoints[iBand].constData(), m_trafficPoints[iBand].count() );
+        }
+        if( !m_trafficMarkers[iBand].isEmpty() )
         {
-            planePen.setWidth( 7 );
-            pAhrs->setPen( planePen );
-            pAhrs->drawPoint( c.dW - trafficRect.width() - 30.0, dListPos - (c.iTinyFontHeight / 2) + 3 );
+            pAhrs->setPen( m_bandMarkerPens[iBand] );
+            pAhrs->drawPoints( m_trafficMarkers[iBand].constData(), m_trafficMarkers[iBand].count() );
         }
     }
 }
 
 
 // Situation (mostly AHRS data) update
-void AHRSCanvas::situation( StratuxSituation s )
+// The change mask says which groups of fields are different from the last one so work for the rest is skipped.
+void AHRSCanvas::situation( SituationSnapshot pSituation )
 {
+    const StratuxSituation &s = *pSituation;
+    qint64                  iNow = now();
+    bool                    bRadarChanged;
+
     m_situation = s;
+    // Traffic altitudes are pressure altitudes so prefer the baro sensor (ft/min) and fall back on GPS (ft/sec)
+    if( s.uiChanged & (AHRS::GPSTrackChanged | AHRS::GPSPosChanged | AHRS::BaroChanged) )
+    {
+        if( s.dBaroPressAlt != 0.0 )
+            m_trafficStore.setOwnship( s.dGPSTrueCourse, s.dGPSGroundSpeed, s.dBaroPressAlt, s.dBaroVertSpeed );
+        else
+            m_trafficStore.setOwnship( s.dGPSTrueCourse, s.dGPSGroundSpeed, s.dGPSAltMSL, s.dGPSVertSpeed * 60.0 );
+    }
+    // Every sample counts for the predictor even if the attitude held still; it says the rates are zero
+    m_predictor.addSample( s, iNow );
+    bRadarChanged = m_nexrad.expire( iNow );
+    if( m_bShowGPSDetails )
+        buildGPSText();
+    updateFrameTimer();
     m_bUpdated = true;
-    update();
+
+    // Nothing drawn changed; the frame timer is still there to animate the predicted attitude and traffic
+    if( bRadarChanged || (s.uiChanged & AHRS::DisplayedChanges) )
+        update();
 }
 
 
-// Traffic update
-void AHRSCanvas::traffic( int iICAO, StratuxTraffic t )
+// Traffic update; everything that came in since the last batch
+void AHRSCanvas::traffic( TrafficSnapshot pBatch )
 {
-    QMapIterator<int, StratuxTraffic> it( m_trafficMap );
-    bool                              bTrafficRemoved = true;
+    qint64 iNow = now();
 
-    m_trafficMap.insert( iICAO, t );
+    // Nothing is tracked while traffic is turned off
+    if( m_eTrafficDisp == AHRS::NoTraffic )
+        return;
 
-    // Each time this is updated, remove an old entry
-    while( bTrafficRemoved )
+    for( int i = 0; i < pBatch->count(); i++ )
     {
-        bTrafficRemoved = false;
-        it.toFront();
-        while( it.hasNext() )
-        {
-            it.next();
-            // Anything older than 60 seconds discard
-            if( it.value().dAge > 60.0 )
-            {
-                m_trafficMap.remove( it.key() );
-                bTrafficRemoved = true;
-                break;
-            }
-        }
+        const StratuxTrafficUpdate &trafficUpdate = pBatch->at( i );
+
+        m_trafficStore.update( trafficUpdate.iICAO, trafficUpdate.traffic, iNow );
+        m_trafficTrails.add( trafficUpdate.iICAO, trafficUpdate.traffic, iNow );
+        for( int j = 0; j < m_trafficStore.dropped().count(); j++ )
+            m_trafficTrails.remove( m_trafficStore.dropped().at( j ) );
     }
+    if( m_iIdentICAO != -1 )
+        buildIdentText();
+    updateFrameTimer();
 
     m_bUpdated = true;
     update();
@@ -620,12 +1213,24 @@ void AHRSCanvas::traffic( int iICAO, StratuxTraffic t )
 
 
 // Weather update - almost no testing! The display of this is mostly guesswork
-// and even the raw websocket message is displayed so we can easily look at the guts
-// Once I have some logs of various weather outputs the raw message shown on the
-// display will be removed.
-void AHRSCanvas::weather( StratuxWeather w )
+// Every product is kept in the weather store; only repaint if it told us something new.
+void AHRSCanvas::weather( WeatherSnapshot pWeather )
+{
+    WeatherStore::InsertResult eResult = m_weatherStore.insert( *pWeather, now() );
+
+    if( !m_bShowWeather )
+        return;
+    buildWeatherText();
+    if( (eResult == WeatherStore::Added) || (eResult == WeatherStore::Replaced) )
+        update();
+}
+
+
+// NEXRAD block from a FIS-B uplink
+// Only the part of the raster it covers is redrawn.
+void AHRSCanvas::nexrad( NexradBlock block )
 {
-    m_weather = w;
+    m_nexrad.add( block, now() );
     update();
 }
 
@@ -649,6 +1254,12 @@ void AHRSCanvas::mousePressEvent( QMouseEvent *pEvent )
         update();
         return;
     }
+    else if( m_iIdentICAO != -1 )
+    {
+        m_iIdentICAO = -1;
+        update();
+        return;
+    }
 
     // Otherwise we're looking for specific spots
     CanvasConstants c = m_pCanvas->contants();
@@ -657,6 +1268,31 @@ void AHRSCanvas::mousePressEvent( QMouseEvent *pEvent )
     QRect           gpsRect( c.dW - c.dW5, c.dH2, c.dW5, c.iLargeFontHeight * 2.0 );
     QRect           altRect( c.dW - c.dW5, 0.0, c.dW5, c.dH2 );
 
+    // User pressed on a traffic dot on the heading indicator
+    if( headRect.contains( pressPt ) && (m_eTrafficDisp != AHRS::NoTraffic) )
+    {
+        // Back through the dial transform from the last frame to NM east/north of ownship
+        double  dDistInc = m_pHeadIndicator->height() / 80.0 * 1.75;
+        QPointF dialPt( m_dial.inverted().map( QPointF( pressPt ) ) );
+
+        m_iIdentICAO = m_trafficStore.hitTest( dialPt.x(), dialPt.y(), (g_bEmulated ? 15.0 : 30.0) / dDistInc );
+        // Pressing the ownship symbol in the middle picks out whichever aircraft is closest, on the dial or not
+        if( (m_iIdentICAO == -1) && QRect( c.dW2 - c.dW20, c.dH - 10 - (m_pHeadIndicator->height() / 2) - c.dH20, c.dW10, c.dH10 ).contains( pressPt ) )
+        {
+            TrafficStore::TargetList closest;
+
+            m_trafficStore.nearest( 1, closest );
+            if( !closest.isEmpty() )
+                m_iIdentICAO = closest.first().iICAO;
+        }
+        if( m_iIdentICAO != -1 )
+        {
+            buildIdentText();
+            update();
+            return;
+        }
+    }
+
     // User pressed on the heading indicator
     if( headRect.contains( pressPt ) )
     {
@@ -699,14 +1335,18 @@ void AHRSCanvas::mousePressEvent( QMouseEvent *pEvent )
     else if( gpsRect.contains( pressPt ) )
     {
         m_bShowGPSDetails = (!m_bShowGPSDetails);
+        if( m_bShowGPSDetails )
+            buildGPSText();
     }
-    else if( gpsRect.contains( altRect ) )
+    else if( altRect.contains( pressPt ) )
     {
         Keypad altBugDlg( this );
 
         if( altBugDlg.exec() == QDialog::Accepted )
         {
-            Builder::buildAltTape( m_pAltTape, m_pCanvas, altBugDlg.value() );
+            m_iAltBug = altBugDlg.value();
+            m_pAltTape->fill( Qt::transparent );
+            Builder::buildAltTape( m_pAltTape, m_pCanvas, m_iAltBug );
         }
     }
 
@@ -730,9 +1370,17 @@ void AHRSCanvas::mouseDoubleClickEvent( QMouseEvent *pEvent )
 
 
 // Traffic setting changed (All, ADSB-only, None)
+// Turning it off lets go of everything tracked so far; it builds up again from new reports when it's back on.
 void AHRSCanvas::trafficToggled( AHRS::TrafficDisp eDispType )
 {
     m_eTrafficDisp = eDispType;
+    if( m_eTrafficDisp == AHRS::NoTraffic )
+    {
+        m_trafficStore.clear();
+        m_trafficTrails.clear();
+        m_iIdentICAO = -1;
+    }
+    updateFrameTimer();
     m_bUpdated = true;
     update();
 }
@@ -742,6 +1390,8 @@ void AHRSCanvas::trafficToggled( AHRS::TrafficDisp eDispType )
 void AHRSCanvas::weatherToggled()
 {
     m_bShowWeather = (!m_bShowWeather);
+    if( m_bShowWeather )
+        buildWeatherText();
     update();
 }
 
@@ -16,6 +16,9 @@ Stratux AHRS Display
 #include "StreamReader.h"
 #include "AppDefs.h"
 #include "MenuDialog.h"
+#include "DiagnosticsDialog.h"
+#include "MetricsServer.h"
+#include "StreamStats.h"
 #include "Canvas.h"
 
 
@@ -29,18 +32,38 @@ extern bool g_bEmulated;
 AHRSMainWin::AHRSMainWin( QWidget *parent )
     : QMainWindow( parent ),
       m_pStratuxStream( new StreamReader( this ) ),
-      m_bStartup( true )
+      m_bStartup( true ),
+      m_pMetrics( 0 )
 {
+    QSettings config;
+    int       iMetricsPort;
+
     setupUi( this );
 
+    // Serve the pipeline counters for scraping if a port is configured (off by default)
+    config.beginGroup( "Global" );
+    iMetricsPort = config.value( "MetricsPort", 0 ).toInt();
+    config.endGroup();
+    if( iMetricsPort > 0 )
+    {
+        m_pMetrics = new MetricsServer( this );
+        m_pMetrics->addSource( m_pStratuxStream );
+        m_pMetrics->addSource( m_pAHRSDisp );
+        if( m_pMetrics->listen( static_cast<quint16>( iMetricsPort ) ) )
+            StreamStats::setTiming( true );
+        else
+        {
+            delete m_pMetrics;
+            m_pMetrics = 0;
+        }
+    }
+
     connect( m_pMenuButton, SIGNAL( clicked() ), this, SLOT( menu() ) );
     connect( m_pWeatherButton, SIGNAL( clicked() ), this, SLOT( weather() ) );
     connect( qApp, SIGNAL( applicationStateChanged( Qt::ApplicationState ) ), this, SLOT( appStateChanged( Qt::ApplicationState ) ) );
 
-    m_lastStatusUpdate = QDateTime::currentDateTime();
-
-    // We don't care what the ID is since it's the one and only timer for this class and never gets killed
-    startTimer( 5000 );
+    // The streams keep themselves connected once started; this only covers a platform that never reports the app as active
+    QTimer::singleShot( 5000, this, SLOT( startupTimeout() ) );
 }
 
 
@@ -71,9 +94,10 @@ void AHRSMainWin::appStateChanged( Qt::ApplicationState eState )
         {
             if( m_bStartup )
             {
-                connect( m_pStratuxStream, SIGNAL( newSituation( StratuxSituation ) ), m_pAHRSDisp, SLOT( situation( StratuxSituation ) ) );
-                connect( m_pStratuxStream, SIGNAL( newTraffic( int, StratuxTraffic ) ), m_pAHRSDisp, SLOT( traffic( int, StratuxTraffic ) ) );
-                connect( m_pStratuxStream, SIGNAL( newWeather( StratuxWeather ) ), m_pAHRSDisp, SLOT( weather( StratuxWeather ) ) );
+                connect( m_pStratuxStream, SIGNAL( newSituation( SituationSnapshot ) ), m_pAHRSDisp, SLOT( situation( SituationSnapshot ) ) );
+                connect( m_pStratuxStream, SIGNAL( newTraffic( TrafficSnapshot ) ), m_pAHRSDisp, SLOT( traffic( TrafficSnapshot ) ) );
+                connect( m_pStratuxStream, SIGNAL( newWeather( WeatherSnapshot ) ), m_pAHRSDisp, SLOT( weather( WeatherSnapshot ) ) );
+                connect( m_pStratuxStream, SIGNAL( newNexrad( NexradBlock ) ), m_pAHRSDisp, SLOT( nexrad( NexradBlock ) ) );
                 connect( m_pStratuxStream, SIGNAL( newStatus( bool, bool, bool, bool, bool ) ), this, SLOT( statusUpdate( bool, bool, bool, bool, bool ) ) );
             }
             m_pStratuxStream->connectStreams();
@@ -96,8 +120,6 @@ void AHRSMainWin::statusUpdate( bool bStratux, bool bAHRS, bool bGPS, bool bTraf
     m_pAHRSIndicator->setStyleSheet( bAHRS ? qsOn : qsOff );
     m_pTrafficIndicator->setStyleSheet( bTraffic ? qsOn : qsOff );
     m_pGPSIndicator->setStyleSheet( bGPS ? qsOn : qsOff );
-
-    m_lastStatusUpdate = QDateTime::currentDateTime();
 }
 
 
@@ -114,19 +136,39 @@ void::AHRSMainWin::menu()
     iRet = dlg.exec();
     if( iRet == QDialog::Rejected )
         qApp->closeAllWindows();
-    else if( iRet == QDialog::Accepted )
+    else
     {
         config.beginGroup( "Global" );
         m_pAHRSDisp->trafficToggled( static_cast<AHRS::TrafficDisp>( config.value( "TrafficDisp", static_cast<int>( AHRS::ADSBOnlyTraffic ) ).toInt() ) );
+        // Reconnect if the stream source was changed; connecting picks up the new source
+        if( static_cast<AHRS::StreamSource>( config.value( "StreamSource", static_cast<int>( AHRS::WebSocketSource ) ).toInt() ) != m_pStratuxStream->source() )
+        {
+            m_pStratuxStream->disconnectStreams();
+            m_pStratuxStream->connectStreams();
+        }
         config.endGroup();
         // Call the Android function for locking the screen through JNI if so configured
 #if defined( Q_OS_ANDROID )
         androidToggleScreenLock();
 #endif
+        if( iRet == MenuDialog::Diagnostics )
+            diagnostics();
     }
 }
 
 
+// Show the stream diagnostics page
+void AHRSMainWin::diagnostics()
+{
+    DiagnosticsDialog dlg( this, m_pStratuxStream );
+    int               iW = width();
+    int               iH = height();
+
+    dlg.setGeometry( (iW / 2) - 350 + (g_bEmulated ? 2000 : 0), (iH / 2) - 500, 700, 1000 );
+    dlg.exec();
+}
+
+
 #if defined( Q_OS_ANDROID )
 void AHRSMainWin::androidToggleScreenLock()
 {
@@ -171,16 +213,10 @@ void AHRSMainWin::keyReleaseEvent( QKeyEvent *pEvent )
 }
 
 
-void AHRSMainWin::timerEvent( QTimerEvent *pEvent )
+// Start the streams if the application state change never came
+void AHRSMainWin::startupTimeout()
 {
-    if( pEvent == 0 )
-        return;
-
-    // If we're not connected, try to reconnect
-    if( !m_pStratuxStream->isConnected() )
-        appStateChanged( Qt::ApplicationActive );  // Default case where we reconnect and ensure the canvas class is woken up
-    // If we haven't gotten a status update for over ten seconds, force a reconnect
-    if( m_lastStatusUpdate.secsTo( QDateTime::currentDateTime() ) > 10 )
-        m_pStratuxStream->disconnectStreams();
+    if( m_bStartup )
+        appStateChanged( Qt::ApplicationActive );
 }
 
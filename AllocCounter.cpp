@@ -0,0 +1,163 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QAtomicInteger>
+
+#include <new>
+#include <stdlib.h>
+
+#include "AllocCounter.h"
+
+
+#if defined( ALLOC_TRACKING )
+
+// Statically initialized so allocations made by other static constructors before main() are counted too
+static QBasicAtomicInteger<qint64> s_iCount = Q_BASIC_ATOMIC_INITIALIZER( 0 );
+static QBasicAtomicInteger<qint64> s_iBytes = Q_BASIC_ATOMIC_INITIALIZER( 0 );
+
+
+static inline void counted( size_t size )
+{
+    s_iCount.fetchAndAddRelaxed( 1 );
+    s_iBytes.fetchAndAddRelaxed( static_cast<qint64>( size ) );
+}
+
+
+#if defined( __GLIBC__ )
+
+// With glibc the malloc family itself is replaced; Qt's strings and containers allocate through malloc
+// directly rather than operator new, and operator new ends up here as well.
+extern "C"
+{
+    void *__libc_malloc( size_t size );
+    void *__libc_calloc( size_t count, size_t size );
+    void *__libc_realloc( void *pMem, size_t size );
+    void  __libc_free( void *pMem );
+
+    void *malloc( size_t size )
+    {
+        counted( size );
+        return __libc_malloc( size );
+    }
+
+    void *calloc( size_t count, size_t size )
+    {
+        counted( count * size );
+        return __libc_calloc( count, size );
+    }
+
+    // A realloc may move the block so it's counted as a new allocation
+    void *realloc( void *pMem, size_t size )
+    {
+        if( size > 0 )
+            counted( size );
+        return __libc_realloc( pMem, size );
+    }
+
+    void free( void *pMem )
+    {
+        __libc_free( pMem );
+    }
+}
+
+#else
+
+// Elsewhere (Android's bionic) there's no way to reach the underlying malloc so only operator new is counted
+void *operator new( size_t size )
+{
+    void *pMem;
+
+    counted( size );
+    pMem = malloc( (size > 0) ? size : 1 );
+    if( pMem == 0 )
+        throw std::bad_alloc();
+
+    return pMem;
+}
+
+
+void *operator new[]( size_t size )
+{
+    return operator new( size );
+}
+
+
+void *operator new( size_t size, const std::nothrow_t & ) noexcept
+{
+    counted( size );
+    return malloc( (size > 0) ? size : 1 );
+}
+
+
+void *operator new[]( size_t size, const std::nothrow_t &nothrow ) noexcept
+{
+    return operator new( size, nothrow );
+}
+
+
+void operator delete( void *pMem ) noexcept
+{
+    free( pMem );
+}
+
+
+void operator delete[]( void *pMem ) noexcept
+{
+    free( pMem );
+}
+
+
+void operator delete( void *pMem, const std::nothrow_t & ) noexcept
+{
+    free( pMem );
+}
+
+
+void operator delete[]( void *pMem, const std::nothrow_t & ) noexcept
+{
+    free( pMem );
+}
+
+#endif
+
+
+bool AllocCounter::isEnabled()
+{
+    return true;
+}
+
+
+qint64 AllocCounter::count()
+{
+    return s_iCount.load();
+}
+
+
+qint64 AllocCounter::bytes()
+{
+    return s_iBytes.load();
+}
+
+#else
+
+
+bool AllocCounter::isEnabled()
+{
+    return false;
+}
+
+
+qint64 AllocCounter::count()
+{
+    return 0;
+}
+
+
+qint64 AllocCounter::bytes()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,271 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <math.h>
+
+#include "AttitudePredictor.h"
+
+
+#define MaxPredictMs  500   // Never project further than this past the last sample
+#define LiveMs        1000  // Samples older than this mean the AHRS isn't streaming
+#define HistorySize   1200  // About two minutes of samples at the Stratux update rate
+#define RateSmoothing 0.5   // Weight of the newest rate in the running rate estimate
+#define MaxPending    64    // Predictions waiting to be scored
+
+
+// Signed difference between two headings in the range -180 to 180
+static double headingDiff( double dTo, double dFrom )
+{
+    double dDiff = dTo - dFrom;
+
+    while( dDiff > 180.0 )
+        dDiff -= 360.0;
+    while( dDiff < -180.0 )
+        dDiff += 360.0;
+
+    return dDiff;
+}
+
+
+// Normalize a heading to 0 - 360
+static double wrapHeading( double dHeading )
+{
+    while( dHeading >= 360.0 )
+        dHeading -= 360.0;
+    while( dHeading < 0.0 )
+        dHeading += 360.0;
+
+    return dHeading;
+}
+
+
+AttitudePredictor::AttitudePredictor()
+    : m_iHorizonMs( 0 ),
+      m_iCount( 0 ),
+      m_dRollRate( 0.0 ),
+      m_dPitchRate( 0.0 ),
+      m_dHeadingRate( 0.0 ),
+      m_iHistoryNext( 0 )
+{
+    m_last.iTime = 0;
+    m_last.dRoll = 0.0;
+    m_last.dPitch = 0.0;
+    m_last.dHeading = 0.0;
+    m_last.dTurnRate = 0.0;
+    m_prev = m_last;
+    m_history.reserve( HistorySize );
+    resetAccuracy();
+}
+
+
+// How far ahead (positive) or behind (negative) of the current time to present the attitude
+void AttitudePredictor::setHorizon( int iHorizonMs )
+{
+    m_iHorizonMs = iHorizonMs;
+    resetAccuracy();
+}
+
+
+// New AHRS sample; the receive time is in milliseconds on the same clock later passed to predict()
+void AttitudePredictor::addSample( const StratuxSituation &situation, qint64 iReceived )
+{
+    Sample sample;
+
+    sample.iTime = iReceived;
+    sample.dRoll = situation.dAHRSroll;
+    sample.dPitch = situation.dAHRSpitch;
+    sample.dHeading = situation.dAHRSGyroHeading;
+    sample.dTurnRate = situation.dAHRSTurnRate;
+
+    addSample( sample );
+}
+
+
+void AttitudePredictor::addSample( const Sample &sample )
+{
+    double dDT;
+
+    score( sample );
+
+    if( m_history.count() < HistorySize )
+        m_history.append( sample );
+    else
+        m_history[m_iHistoryNext] = sample;
+    m_iHistoryNext = (m_iHistoryNext + 1) % HistorySize;
+
+    // Samples that arrive together (or out of order) replace the last one without touching the rates
+    if( (m_iCount > 0) && (sample.iTime > m_last.iTime) )
+    {
+        dDT = static_cast<double>( sample.iTime - m_last.iTime ) / 1000.0;
+        if( m_iCount == 1 )
+        {
+            m_dRollRate = (sample.dRoll - m_last.dRoll) / dDT;
+            m_dPitchRate = (sample.dPitch - m_last.dPitch) / dDT;
+            m_dHeadingRate = headingDiff( sample.dHeading, m_last.dHeading ) / dDT;
+        }
+        else
+        {
+            m_dRollRate = (RateSmoothing * ((sample.dRoll - m_last.dRoll) / dDT)) + ((1.0 - RateSmoothing) * m_dRollRate);
+            m_dPitchRate = (RateSmoothing * ((sample.dPitch - m_last.dPitch) / dDT)) + ((1.0 - RateSmoothing) * m_dPitchRate);
+            m_dHeadingRate = (RateSmoothing * (headingDiff( sample.dHeading, m_last.dHeading ) / dDT)) + ((1.0 - RateSmoothing) * m_dHeadingRate);
+        }
+        m_prev = m_last;
+    }
+    m_last = sample;
+    m_iCount++;
+
+    // Hold on to what this sample says the attitude will be a horizon from now so it can be scored later
+    if( (m_iHorizonMs > 0) && (m_iCount >= 2) )
+    {
+        Pending pending;
+
+        pending.iTarget = sample.iTime + m_iHorizonMs;
+        pending.att = predict( sample.iTime );
+        if( m_pending.count() >= MaxPending )
+            m_pending.remove( 0 );
+        m_pending.append( pending );
+    }
+}
+
+
+// Attitude to show at the given time
+// Between the last two samples it interpolates, past the last one it projects forward on the current rates.
+AttitudePredictor::Attitude AttitudePredictor::predict( qint64 iNow ) const
+{
+    Attitude att;
+    qint64   iTarget = iNow + m_iHorizonMs;
+    double   dFrac, dDT;
+
+    att.dRoll = m_last.dRoll;
+    att.dPitch = m_last.dPitch;
+    att.dHeading = m_last.dHeading;
+    if( m_iCount < 2 )
+        return att;
+
+    if( (iTarget < m_last.iTime) && (m_last.iTime > m_prev.iTime) )
+    {
+        dFrac = static_cast<double>( iTarget - m_prev.iTime ) / static_cast<double>( m_last.iTime - m_prev.iTime );
+        if( dFrac < 0.0 )
+            dFrac = 0.0;
+        att.dRoll = m_prev.dRoll + ((m_last.dRoll - m_prev.dRoll) * dFrac);
+        att.dPitch = m_prev.dPitch + ((m_last.dPitch - m_prev.dPitch) * dFrac);
+        att.dHeading = wrapHeading( m_prev.dHeading + (headingDiff( m_last.dHeading, m_prev.dHeading ) * dFrac) );
+    }
+    else
+    {
+        dDT = static_cast<double>( qMin( iTarget - m_last.iTime, static_cast<qint64>( MaxPredictMs ) ) ) / 1000.0;
+        att.dRoll = m_last.dRoll + (m_dRollRate * dDT);
+        att.dPitch = m_last.dPitch + (m_dPitchRate * dDT);
+        // Prefer the AHRS turn rate; fall back on the rate seen in the samples when it isn't reported
+        att.dHeading = wrapHeading( m_last.dHeading + (((m_last.dTurnRate != 0.0) ? m_last.dTurnRate : m_dHeadingRate) * dDT) );
+        if( att.dRoll > 180.0 )
+            att.dRoll -= 360.0;
+        else if( att.dRoll < -180.0 )
+            att.dRoll += 360.0;
+        if( att.dPitch > 90.0 )
+            att.dPitch = 90.0;
+        else if( att.dPitch < -90.0 )
+            att.dPitch = -90.0;
+    }
+
+    return att;
+}
+
+
+// Whether samples are still arriving
+bool AttitudePredictor::isLive( qint64 iNow ) const
+{
+    return (m_iCount > 0) && ((iNow - m_last.iTime) < LiveMs);
+}
+
+
+// How close the predictions for the current horizon have been to the samples that actually arrived
+AttitudePredictor::Accuracy AttitudePredictor::accuracy() const
+{
+    Accuracy acc;
+
+    acc.iSamples = m_iScored;
+    acc.dRollRMS = (m_iScored > 0) ? sqrt( m_dRollSq / m_iScored ) : 0.0;
+    acc.dPitchRMS = (m_iScored > 0) ? sqrt( m_dPitchSq / m_iScored ) : 0.0;
+    acc.dHeadingRMS = (m_iScored > 0) ? sqrt( m_dHeadingSq / m_iScored ) : 0.0;
+    acc.dRollMax = m_dRollMax;
+    acc.dPitchMax = m_dPitchMax;
+    acc.dHeadingMax = m_dHeadingMax;
+
+    return acc;
+}
+
+
+void AttitudePredictor::resetAccuracy()
+{
+    m_pending.clear();
+    m_iScored = 0;
+    m_dRollSq = 0.0;
+    m_dPitchSq = 0.0;
+    m_dHeadingSq = 0.0;
+    m_dRollMax = 0.0;
+    m_dPitchMax = 0.0;
+    m_dHeadingMax = 0.0;
+}
+
+
+// Recent samples oldest first
+void AttitudePredictor::history( SampleList &samples ) const
+{
+    samples.resize( 0 );
+    if( m_history.count() < HistorySize )
+        samples = m_history;
+    else
+    {
+        for( int i = 0; i < HistorySize; i++ )
+            samples.append( m_history.at( (m_iHistoryNext + i) % HistorySize ) );
+    }
+}
+
+
+// Run a recorded sequence of samples through a fresh predictor with the given horizon
+AttitudePredictor::Accuracy AttitudePredictor::replay( const SampleList &samples, int iHorizonMs )
+{
+    AttitudePredictor predictor;
+
+    predictor.setHorizon( iHorizonMs );
+    for( int i = 0; i < samples.count(); i++ )
+        predictor.addSample( samples.at( i ) );
+
+    return predictor.accuracy();
+}
+
+
+// Score any held predictions whose target time falls between the last sample and this one
+// The real attitude at the target time is taken as the straight line between the two samples.
+void AttitudePredictor::score( const Sample &sample )
+{
+    Attitude att;
+    double   dFrac, dRollErr, dPitchErr, dHeadingErr;
+
+    if( (m_iCount < 1) || (sample.iTime <= m_last.iTime) )
+        return;
+
+    while( (!m_pending.isEmpty()) && (m_pending.first().iTarget <= sample.iTime) )
+    {
+        if( m_pending.first().iTarget >= m_last.iTime )
+        {
+            dFrac = static_cast<double>( m_pending.first().iTarget - m_last.iTime ) / static_cast<double>( sample.iTime - m_last.iTime );
+            att = m_pending.first().att;
+            dRollErr = fabs( att.dRoll - (m_last.dRoll + ((sample.dRoll - m_last.dRoll) * dFrac)) );
+            dPitchErr = fabs( att.dPitch - (m_last.dPitch + ((sample.dPitch - m_last.dPitch) * dFrac)) );
+            dHeadingErr = fabs( headingDiff( att.dHeading, m_last.dHeading + (headingDiff( sample.dHeading, m_last.dHeading ) * dFrac) ) );
+
+            m_dRollSq += dRollErr * dRollErr;
+            m_dPitchSq += dPitchErr * dPitchErr;
+            m_dHeadingSq += dHeadingErr * dHeadingErr;
+            m_dRollMax = qMax( m_dRollMax, dRollErr );
+            m_dPitchMax = qMax( m_dPitchMax, dPitchErr );
+            m_dHeadingMax = qMax( m_dHeadingMax, dHeadingErr );
+            m_iScored++;
+        }
+        m_pending.remove( 0 );
+    }
+}
@@ -5,6 +5,10 @@ Stratux AHRS Display
 
 #include <QPixmap>
 #include <QPainter>
+#include <QVector>
+#include <QLineF>
+
+#include <math.h>
 
 #include "Builder.h"
 #include "Canvas.h"
@@ -13,6 +17,9 @@ Stratux AHRS Display
 extern bool g_bEmulated;
 
 
+#define ToRad 0.017453292519943296
+
+
 Builder::Builder()
 {
 }
@@ -112,88 +119,119 @@ void Builder::buildSpeedTape( QPixmap *pSpeedTape, Canvas *pCanvas )
 }
 
 
+// Generate the end points of a run of evenly spaced ticks around an arc and append them to the list
+// Angles are in degrees clockwise from straight up (the same sense as QPainter::rotate) and each tick runs
+// from the outer radius in to the inner one. All the trig is done up front in one tight loop over plain arrays
+// so the tick lines can go to the painter as a single drawLines batch instead of a rotate/draw/reset per tick.
+void Builder::arcTicks( QVector<QLineF> &ticks, const QPointF &center, double dOuter, double dInner, double dStart, double dStep, int iCount )
+{
+    int     iFirst = ticks.count();
+    QLineF *pTick;
+
+    if( iCount <= 0 )
+        return;
+
+    QVector<double> sinAng( iCount );
+    QVector<double> cosAng( iCount );
+    double         *pSin = sinAng.data();
+    double         *pCos = cosAng.data();
+
+    for( int i = 0; i < iCount; i++ )
+    {
+        double dAng = (dStart + (dStep * i)) * ToRad;
+
+        pSin[i] = sin( dAng );
+        pCos[i] = cos( dAng );
+    }
+
+    ticks.resize( iFirst + iCount );
+    pTick = ticks.data() + iFirst;
+    for( int i = 0; i < iCount; i++ )
+    {
+        pTick[i].setLine( center.x() + (dOuter * pSin[i]), center.y() - (dOuter * pCos[i]),
+                          center.x() + (dInner * pSin[i]), center.y() - (dInner * pCos[i]) );
+    }
+}
+
+
 // Build the roll indicator (the arc scale at the top)
 void Builder::buildRollIndicator( QPixmap *pRollInd, Canvas *pCanvas )
 {
     Q_UNUSED( pCanvas )
 
-    QPainter     ahrs( pRollInd );
-    double       dW = pRollInd->width();
-    double       dH = pRollInd->height();
-    double       dW2 = dW / 2.0;
-    double       dH2 = dH / 2.0;
-    QPen         linePen( Qt::white, 3 );
-    QFont        rollFont( "Roboto Thin", 12 );
-    QFontMetrics rollMetrics( rollFont );
-    QString      qsRoll;
-    QRect        rollRect;
+    QPainter        ahrs( pRollInd );
+    double          dW = pRollInd->width();
+    double          dH = pRollInd->height();
+    double          dW2 = dW / 2.0;
+    double          dH2 = dH / 2.0;
+    QPointF         center( dW2, dH2 );
+    QPen            linePen( Qt::white, 3 );
+    QFont           rollFont( "Roboto Thin", 12 );
+    QFontMetrics    rollMetrics( rollFont );
+    QString         qsRoll;
+    QRect           rollRect;
+    QVector<QLineF> ticks;
+    int             iAngle;
 
     ahrs.setRenderHints( QPainter::Antialiasing | QPainter::TextAntialiasing, true );
 
-    // -30 to 30 with black lines on -30, 0 and 30
-    for( int i = 0; i < 7; i++ )
+    // -30 to 30 with orange lines on -30, 0 and 30
+    linePen.setColor( QColor( 0xFF, 0xA5, 0x00, 0xFF ) );   // Orange
+    ahrs.setPen( linePen );
+    arcTicks( ticks, center, dH2, dH2 - 20.0, -30.0, 30.0, 3 );
+    ahrs.drawLines( ticks );
+    ticks.clear();
+    linePen.setColor( Qt::white );
+    ahrs.setPen( linePen );
+    arcTicks( ticks, center, dH2, dH2 - 20.0, -20.0, 10.0, 2 );
+    arcTicks( ticks, center, dH2, dH2 - 20.0, 10.0, 10.0, 2 );
+    ahrs.drawLines( ticks );
+    ticks.clear();
+    // Red lines on -60, -45, 45 and 60
+    linePen.setColor( Qt::red );
+    ahrs.setPen( linePen );
+    arcTicks( ticks, center, dH2, dH2 - 20.0, -60.0, 15.0, 2 );
+    arcTicks( ticks, center, dH2, dH2 - 20.0, 45.0, 15.0, 2 );
+    ahrs.drawLines( ticks );
+
+    // The labels still need rotating but there are only a handful of them
+    for( int i = 0; i < 11; i++ )
     {
-        ahrs.translate( dW2, dH2 );
-        ahrs.rotate( -30 + (i * 10) );
-        ahrs.translate( -dW2, -dH2 );
-        if( (i == 0) || (i == 3) || (i == 6) )
-            linePen.setColor( QColor( 0xFF, 0xA5, 0x00, 0xFF ) );   // Orange
+        if( i < 7 )
+        {
+            iAngle = -30 + (i * 10);
+            if( (i == 0) || (i == 3) || (i == 6) )
+                linePen.setColor( QColor( 0xFF, 0xA5, 0x00, 0xFF ) );
+            else
+                linePen.setColor( Qt::white );
+            qsRoll = QString::number( abs( iAngle ) );
+            qsRoll.chop( 1 );
+        }
         else
-            linePen.setColor( Qt::white );
+        {
+            static const int redAngles[4] = { -45, 45, -60, 60 };
+
+            iAngle = redAngles[i - 7];
+            linePen.setColor( Qt::red );
+            qsRoll = (abs( iAngle ) == 45) ? "45" : "6";
+        }
         ahrs.setPen( linePen );
-        ahrs.drawLine( dW2, 0, dW2, 20 );
-        qsRoll = QString::number( abs( -30 + (i * 10) ) );
-        qsRoll.chop( 1 );
+        ahrs.translate( dW2, dH2 );
+        ahrs.rotate( iAngle );
+        ahrs.translate( -dW2, -dH2 );
         rollRect = rollMetrics.boundingRect( qsRoll );
         ahrs.drawText( dW2 - (rollRect.width() / 2.0), 22.0 + rollRect.height(), qsRoll );
         ahrs.resetTransform();
     }
-    // Red lines on -60, -45, 45 and 60
-    linePen.setColor( Qt::red );
-    ahrs.setPen( linePen );
-    // -45
-    qsRoll = "45";
-    ahrs.translate( dW2, dH2 );
-    ahrs.rotate( -45 );
-    ahrs.translate( -dW2, -dH2 );
-    ahrs.drawLine( dW2, 0, dW2, 20 );
-    rollRect = rollMetrics.boundingRect( qsRoll );
-    ahrs.drawText( dW2 - (rollRect.width() / 2.0), 22.0 + rollRect.height(), qsRoll );
-    ahrs.resetTransform();
-    // 45
-    ahrs.translate( dW2, dH2 );
-    ahrs.rotate( 45 );
-    ahrs.translate( -dW2, -dH2 );
-    ahrs.drawLine( dW2, 0, dW2, 20 );
-    ahrs.drawText( dW2 - (rollRect.width() / 2.0), 22.0 + rollRect.height(), qsRoll );
-    ahrs.resetTransform();
-    // -60
-    ahrs.translate( dW2, dH2 );
-    ahrs.rotate( -60 );
-    ahrs.translate( -dW2, -dH2 );
-    ahrs.drawLine( dW2, 0, dW2, 20 );
-    qsRoll = "6";
-    rollRect = rollMetrics.boundingRect( qsRoll );
-    ahrs.drawText( dW2 - (rollRect.width() / 2.0), 22.0 + rollRect.height(), qsRoll );
-    ahrs.resetTransform();
-    // 60
-    ahrs.translate( dW2, dH2 );
-    ahrs.rotate( 60 );
-    ahrs.translate( -dW2, -dH2 );
-    ahrs.drawLine( dW2, 0, dW2, 20 );
-    ahrs.drawText( dW2 - (rollRect.width() / 2.0), 22.0 + rollRect.height(), qsRoll );
-    ahrs.resetTransform();
+
+    // The scale arc itself from -60 to 60 as one arc instead of a rotated dot every tenth of a degree
+    // Qt arc angles are counter-clockwise from three o'clock so -60..60 from the top is 30..150.
+    double dArcRadius = dH2 - 20.5;
 
     linePen.setColor( Qt::white );
     ahrs.setPen( linePen );
-    for( double d = 0; d <= 120.0; d += 0.1 )
-    {
-        ahrs.translate( dW2, dH2 );
-        ahrs.rotate( -60.0 + d );
-        ahrs.translate( -dW2, -dH2 );
-        ahrs.drawLine( dW2, 20.0, dW2, 21.0 );
-        ahrs.resetTransform();
-    }
+    ahrs.setBrush( Qt::NoBrush );
+    ahrs.drawArc( QRectF( dW2 - dArcRadius, dH2 - dArcRadius, dArcRadius * 2.0, dArcRadius * 2.0 ), 30 * 16, 120 * 16 );
 }
 
 
@@ -205,11 +243,12 @@ void Builder::buildHeadingIndicator( QPixmap *pHeadInd, Canvas *pCanvas )
     double          dH = pHeadInd->height();
     double          dW2 = dW / 2.0;
     double          dH2 = dH / 2.0;
+    QPointF         center( dW2, dH2 );
     QPen            linePen( Qt::white, 3 );
-    bool            bThis = true;
     QColor          orange( 255, 165, 0 );
     int             iFontSize = 20;
     CanvasConstants c = pCanvas->contants();
+    QVector<QLineF> ticks;
 
     if( c.dW > 1080 )
         iFontSize = 30;
@@ -224,35 +263,17 @@ void Builder::buildHeadingIndicator( QPixmap *pHeadInd, Canvas *pCanvas )
     ahrs.setPen( Qt::NoPen );
     ahrs.setBrush( Qt::black );
     ahrs.drawEllipse( 0.0, 0.0, dW, dH );
-    ahrs.setPen( linePen );
     // Tens of degrees
-    for( int i = 0; i < 360; i += 10 )
-    {
-        ahrs.translate( dW2, dH2 );
-        ahrs.rotate( i );
-        ahrs.translate( -dW2, -dH2 );
-        ahrs.drawLine( dW2, 0, dW2, 20 );
-        ahrs.resetTransform();
-    }
-    // Every five degrees
+    ahrs.setPen( linePen );
+    arcTicks( ticks, center, dH2, dH2 - 20.0, 0.0, 10.0, 36 );
+    ahrs.drawLines( ticks );
+    ticks.clear();
+    // Every five degrees in between
     linePen.setWidth( 2 );
     linePen.setColor( Qt::gray );
     ahrs.setPen( linePen );
-    for( int i = 5; i < 360; i += 5 )
-    {
-        if( bThis )
-        {
-            ahrs.translate( dW2, dH2 );
-            ahrs.rotate( i );
-            ahrs.translate( -dW2, -dH2 );
-            ahrs.drawLine( dW2, 0, dW2, 10 );
-            ahrs.resetTransform();
-            bThis = false;
-        }
-        else
-            bThis = true;
-    }
-    ahrs.resetTransform();
+    arcTicks( ticks, center, dH2, dH2 - 10.0, 5.0, 10.0, 36 );
+    ahrs.drawLines( ticks );
     // Number labels
     ahrs.setFont( headFont );
     for( int i = 0; i < 36; i += 3 )
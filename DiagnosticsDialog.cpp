@@ -0,0 +1,163 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QKeyEvent>
+
+#include "DiagnosticsDialog.h"
+#include "StreamReader.h"
+
+
+#define RefreshInterval 1000
+
+
+static const char *g_szEndpoints[AHRS::EndpointCount] = { "Situation", "Traffic", "Status", "Weather", "GDL90" };
+
+
+DiagnosticsDialog::DiagnosticsDialog( QWidget *pParent, StreamReader *pStream )
+    : QDialog( pParent, Qt::Dialog | Qt::FramelessWindowHint ),
+      m_pStream( pStream )
+{
+    setupUi( this );
+
+    StreamStats::setTiming( true );
+    sample();
+
+    connect( &m_refreshTimer, SIGNAL( timeout() ), this, SLOT( refresh() ) );
+    connect( m_pResetButton, SIGNAL( clicked() ), this, SLOT( reset() ) );
+    connect( m_pDoneButton, SIGNAL( clicked() ), this, SLOT( accept() ) );
+    m_refreshTimer.start( RefreshInterval );
+
+    refresh();
+}
+
+
+// Back to counting only messages and bytes
+DiagnosticsDialog::~DiagnosticsDialog()
+{
+    StreamStats::setTiming( false );
+}
+
+
+// Remember the counters the next rates are worked out from
+void DiagnosticsDialog::sample()
+{
+    int i;
+
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        m_pStream->stats( static_cast<AHRS::StreamEndpoint>( i ) ).counters( m_prev[i] );
+    m_sinceSample.start();
+}
+
+
+// Rebuild the page from the current counters
+void DiagnosticsDialog::refresh()
+{
+    StreamStats::Counters    counters[AHRS::EndpointCount];
+    double                   dSecs = qMax( m_sinceSample.elapsed(), static_cast<qint64>( 1 ) ) / 1000.0;
+    QString                  qsPage;
+    int                      i, iBin;
+    const StreamConnection  *connections[4] = { &m_pStream->situationConnection(), &m_pStream->trafficConnection(),
+                                                &m_pStream->statusConnection(), &m_pStream->weatherConnection() };
+    const StreamQueue       *queues[3] = { &m_pStream->situationQueue(), &m_pStream->trafficQueue(), &m_pStream->weatherQueue() };
+
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        m_pStream->stats( static_cast<AHRS::StreamEndpoint>( i ) ).counters( counters[i] );
+
+    // Rates, jitter, gaps and parse time
+    qsPage = "<table cellspacing=\"4\"><tr><th align=\"left\">Stream</th><th>Msg/s</th><th>kB/s</th><th>Jitter ms</th><th>Max gap ms</th><th>Parse &micro;s</th><th>Max &micro;s</th></tr>";
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+    {
+        StreamStats::Counters &c = counters[i];
+
+        qsPage += QString( "<tr><td>%1</td><td align=\"right\">%2</td><td align=\"right\">%3</td><td align=\"right\">%4</td><td align=\"right\">%5</td><td align=\"right\">%6</td><td align=\"right\">%7</td></tr>" )
+                      .arg( g_szEndpoints[i] )
+                      .arg( (c.iMessages - m_prev[i].iMessages) / dSecs, 0, 'f', 1 )
+                      .arg( (c.iBytes - m_prev[i].iBytes) / dSecs / 1024.0, 0, 'f', 1 )
+                      .arg( c.iJitterUs / 1000.0, 0, 'f', 1 )
+                      .arg( c.iMaxGapMs )
+                      .arg( (c.iParsed > 0) ? (c.iParseNs / c.iParsed / 1000.0) : 0.0, 0, 'f', 1 )
+                      .arg( c.iMaxParseNs / 1000.0, 0, 'f', 1 );
+    }
+    qsPage += "</table>";
+
+    // Jitter histogram; each bin counts gaps that differed from the smoothed gap by less than its limit
+    qsPage += "<p>Jitter histogram</p><table cellspacing=\"4\"><tr><th align=\"left\">Stream</th>";
+    for( iBin = 0; iBin < StreamStats::JitterBins; iBin++ )
+    {
+        if( iBin < (StreamStats::JitterBins - 1) )
+            qsPage += QString( "<th>&lt;%1</th>" ).arg( StreamStats::jitterBinLimit( iBin ) );
+        else
+            qsPage += QString( "<th>&ge;%1</th>" ).arg( StreamStats::jitterBinLimit( iBin - 1 ) );
+    }
+    qsPage += "</tr>";
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+    {
+        qsPage += QString( "<tr><td>%1</td>" ).arg( g_szEndpoints[i] );
+        for( iBin = 0; iBin < StreamStats::JitterBins; iBin++ )
+            qsPage += QString( "<td align=\"right\">%1</td>" ).arg( counters[i].histogram[iBin] );
+        qsPage += "</tr>";
+    }
+    qsPage += "</table>";
+
+    // Websocket connections
+    qsPage += "<p>Connections</p><table cellspacing=\"4\"><tr><th align=\"left\">Stream</th><th>Up</th><th>Connects</th><th>Failures</th><th>Timeouts<br>connect/live</th><th>Down s</th><th>RTT ms</th></tr>";
+    for( i = 0; i < 4; i++ )
+    {
+        StreamConnection::Counters c = connections[i]->counters();
+
+        qsPage += QString( "<tr><td>%1</td><td align=\"center\">%2</td><td align=\"right\">%3</td><td align=\"right\">%4</td><td align=\"right\">%5/%6</td><td align=\"right\">%7</td><td align=\"right\">%8</td></tr>" )
+                      .arg( g_szEndpoints[i] )
+                      .arg( connections[i]->isConnected() ? "Y" : "N" )
+                      .arg( c.iConnects )
+                      .arg( c.iFailures )
+                      .arg( c.iConnectTimeouts )
+                      .arg( c.iLivenessTimeouts )
+                      .arg( c.iDowntimeMs / 1000.0, 0, 'f', 1 )
+                      .arg( c.iRoundTripMs );
+    }
+    qsPage += "</table>";
+
+    // Ingest queues
+    qsPage += "<p>Queues</p><table cellspacing=\"4\"><tr><th align=\"left\">Stream</th><th>Received</th><th>Dropped</th><th>Coalesced</th><th>High water</th></tr>";
+    for( i = 0; i < 3; i++ )
+    {
+        const StreamQueue::Counters &c = queues[i]->counters();
+
+        qsPage += QString( "<tr><td>%1</td><td align=\"right\">%2</td><td align=\"right\">%3</td><td align=\"right\">%4</td><td align=\"right\">%5/%6</td></tr>" )
+                      .arg( g_szEndpoints[(i == 2) ? AHRS::WeatherEndpoint : i] )
+                      .arg( c.iReceived )
+                      .arg( c.iDropped )
+                      .arg( c.iCoalesced )
+                      .arg( c.iHighWater )
+                      .arg( queues[i]->capacity() );
+    }
+    qsPage += "</table>";
+    qsPage += QString( "<p>Situations coalesced: %1<br>Traffic updates coalesced: %2</p>" )
+                  .arg( m_pStream->situationsCoalesced() )
+                  .arg( m_pStream->trafficCoalesced() );
+
+    m_pStatsLabel->setText( qsPage );
+    sample();
+}
+
+
+// Start the statistics over
+void DiagnosticsDialog::reset()
+{
+    m_pStream->resetStats();
+    sample();
+    refresh();
+}
+
+
+// Android back key closes the page (B Key on emulator)
+void DiagnosticsDialog::keyReleaseEvent( QKeyEvent *pEvent )
+{
+    if( (pEvent->key() == Qt::Key_Back) || (pEvent->key() == Qt::Key_B) )
+    {
+        pEvent->accept();
+        accept();
+    }
+}
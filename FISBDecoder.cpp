@@ -0,0 +1,171 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <string.h>
+#include <math.h>
+
+#include "FISBDecoder.h"
+
+
+#define UplinkMsgLength   436           // GDL90 message ID, three byte time of reception and the UAT payload
+#define UATHeaderLength   8
+#define FISBFrameType     0
+#define RegionalNEXRAD    63
+#define CONUSNEXRAD       64
+#define BlocksPerRing     450
+#define BlockThreshold    405000        // Blocks at and above this (60 degrees) are twice as wide
+#define BlockWidth        (48.0 / 60.0)
+#define WideBlockWidth    (96.0 / 60.0)
+#define BlockHeight       (4.0 / 60.0)
+
+
+// Decode every NEXRAD block in a GDL90 uplink message (starting at the message ID) and add them to the list
+// Returns the number of blocks added.
+int FISBDecoder::uplink( const uchar *pMsg, int iLength, NexradBlockList &blocks )
+{
+    const uchar *pFrames = pMsg + 4 + UATHeaderLength;
+    int          iFramesLen = UplinkMsgLength - 4 - UATHeaderLength;
+    int          iStartCount = blocks.count();
+    int          iPos = 0, iFrameLen, iFrameType;
+
+    if( iLength < UplinkMsgLength )
+        return 0;
+
+    // UAT header byte 6 bit 5 says whether the application data is valid at all
+    if( (pMsg[4 + 6] & 0x20) == 0 )
+        return 0;
+
+    // Information frames are a 9 bit length, 3 reserved bits and a 4 bit type followed by the data
+    while( (iPos + 2) <= iFramesLen )
+    {
+        iFrameLen = (pFrames[iPos] << 1) | (pFrames[iPos + 1] >> 7);
+        iFrameType = pFrames[iPos + 1] & 0x0F;
+        if( (iFrameLen == 0) || ((iPos + 2 + iFrameLen) > iFramesLen) )
+            break;
+        if( iFrameType == FISBFrameType )
+            apdu( pFrames + iPos + 2, iFrameLen, blocks );
+        iPos += 2 + iFrameLen;
+    }
+
+    return blocks.count() - iStartCount;
+}
+
+
+// Where a block is and how big it is, in degrees
+// Blocks are 4 arcminutes high and 48 arcminutes wide (96 north of 60 degrees) at scale 1; the other
+// scales are 5 and 9 times that. The latitude returned is the north edge and the longitude the west edge.
+void FISBDecoder::blockLocation( int iBlock, bool bSouth, int iScale, double &dLatN, double &dLongW, double &dLatSize, double &dLongSize )
+{
+    double dScale = (iScale == 1) ? 5.0 : ((iScale == 2) ? 9.0 : 1.0);
+    double dRawLat, dRawLong;
+
+    if( iBlock >= BlockThreshold )
+        iBlock &= ~1;
+
+    dRawLat = BlockHeight * static_cast<double>( iBlock / BlocksPerRing );
+    dRawLong = (iBlock % BlocksPerRing) * BlockWidth;
+
+    dLongSize = ((iBlock >= BlockThreshold) ? WideBlockWidth : BlockWidth) * dScale;
+    dLatSize = BlockHeight * dScale;
+    dLongW = (dRawLong >= 180.0) ? (dRawLong - 360.0) : dRawLong;
+    dLatN = bSouth ? -dRawLat : (dRawLat + BlockHeight);
+}
+
+
+// FIS-B APDU header; only NEXRAD products that aren't segmented are decoded
+// The header length depends on which of the four time formats is used.
+void FISBDecoder::apdu( const uchar *pData, int iLength, NexradBlockList &blocks )
+{
+    int  iProduct, iTimeOpt, iHeaderLen;
+    bool bSegmented;
+
+    if( iLength < 4 )
+        return;
+
+    bSegmented = ((pData[0] & 0x10) != 0);
+    iProduct = ((pData[0] & 0x1F) << 6) | (pData[1] >> 2);
+    iTimeOpt = ((pData[1] & 0x01) << 1) | (pData[2] >> 7);
+
+    switch( iTimeOpt )
+    {
+        case 0:     // Hours and minutes
+            iHeaderLen = 4;
+            break;
+        case 1:     // Hours, minutes and seconds
+        case 2:     // Month, day, hours and minutes
+            iHeaderLen = 5;
+            break;
+        default:    // Month, day, hours, minutes and seconds
+            iHeaderLen = 6;
+            break;
+    }
+
+    if( bSegmented || (iLength <= iHeaderLen) || ((iProduct != RegionalNEXRAD) && (iProduct != CONUSNEXRAD)) )
+        return;
+
+    nexrad( pData + iHeaderLen, iLength - iHeaderLen, iProduct == CONUSNEXRAD, blocks );
+}
+
+
+// NEXRAD payload; either one run-length encoded block or the empty block bitmap
+void FISBDecoder::nexrad( const uchar *pData, int iLength, bool bCONUS, NexradBlockList &blocks )
+{
+    NexradBlock block;
+    bool        bRLE;
+    int         iBin, iRun, iBitmapLen, iBits, iRowStart, iRowSize;
+
+    if( iLength < 4 )
+        return;
+
+    bRLE = ((pData[0] & 0x80) != 0);
+    block.bSouth = ((pData[0] & 0x40) != 0);
+    block.iScale = (pData[0] & 0x30) >> 4;
+    block.iBlock = ((pData[0] & 0x0F) << 16) | (pData[1] << 8) | pData[2];
+    block.bCONUS = bCONUS;
+
+    if( bRLE )
+    {
+        // Each byte is a five bit run length (less one) and a three bit intensity, filling the bins row by row
+        iBin = 0;
+        for( int i = 3; (i < iLength) && (iBin < (NEXRAD_BINS_X * NEXRAD_BINS_Y)); i++ )
+        {
+            iRun = (pData[i] >> 3) + 1;
+            if( (iBin + iRun) > (NEXRAD_BINS_X * NEXRAD_BINS_Y) )
+                iRun = (NEXRAD_BINS_X * NEXRAD_BINS_Y) - iBin;
+            memset( block.bins + iBin, pData[i] & 0x07, iRun );
+            iBin += iRun;
+        }
+        if( iBin < (NEXRAD_BINS_X * NEXRAD_BINS_Y) )
+            memset( block.bins + iBin, 0, (NEXRAD_BINS_X * NEXRAD_BINS_Y) - iBin );
+        blocks.append( block );
+        return;
+    }
+
+    // Empty blocks; the block itself and whichever of the ones following it in the same ring are flagged
+    // in the bitmap. The low nibble of the first bitmap byte is the bitmap length and its high nibble
+    // covers the next four blocks; each byte after that covers eight more.
+    memset( block.bins, 0, sizeof( block.bins ) );
+    blocks.append( block );
+
+    iRowSize = (block.iBlock >= BlockThreshold) ? (BlocksPerRing / 2) : BlocksPerRing;
+    iRowStart = block.iBlock - (block.iBlock % BlocksPerRing);
+    iBitmapLen = pData[3] & 0x0F;
+    for( int i = 0; (i < iBitmapLen) && ((3 + i) < iLength); i++ )
+    {
+        iBits = (i == 0) ? (pData[3] & 0xF0) : pData[3 + i];
+        for( int iBit = (i == 0) ? 4 : 0; iBit < 8; iBit++ )
+        {
+            if( (iBits & (1 << iBit)) == 0 )
+                continue;
+            NexradBlock empty = block;
+
+            if( iRowSize == BlocksPerRing )
+                empty.iBlock = iRowStart + (((block.iBlock - iRowStart) + (i * 8) + iBit - 3) % iRowSize);
+            else
+                empty.iBlock = iRowStart + ((((block.iBlock - iRowStart) / 2) + (i * 8) + iBit - 3) % iRowSize) * 2;
+            blocks.append( empty );
+        }
+    }
+}
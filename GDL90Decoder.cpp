@@ -0,0 +1,176 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include "GDL90Decoder.h"
+#include "StringTable.h"
+
+
+#define LatLongScale    (180.0 / 8388608.0)     // 24 bit signed semicircles to degrees
+#define TrackScale      (360.0 / 256.0)
+#define ReportLength    28                      // Ownship and traffic reports including the ID
+#define HeartbeatLength 7
+#define AHRSLength      24
+#define AHRSInvalid     0x7FFF
+
+
+// Big endian signed 16 bit
+static int int16At( const uchar *pData )
+{
+    return static_cast<qint16>( (pData[0] << 8) | pData[1] );
+}
+
+
+// Big endian signed 24 bit
+static int int24At( const uchar *pData )
+{
+    int iVal = (pData[0] << 16) | (pData[1] << 8) | pData[2];
+
+    if( iVal & 0x800000 )
+        iVal -= 0x1000000;
+
+    return iVal;
+}
+
+
+// Heartbeat (once a second); just the GPS state and the receiver message counts
+bool GDL90Decoder::heartbeat( const uchar *pMsg, int iLength, Status &status )
+{
+    if( (iLength < HeartbeatLength) || (pMsg[0] != Heartbeat) )
+        return false;
+
+    status.bGPSValid = ((pMsg[1] & 0x80) != 0);
+    status.iUplinkCount = pMsg[5] >> 3;
+    status.iBasicLongCount = ((pMsg[5] & 0x03) << 8) | pMsg[6];
+
+    return true;
+}
+
+
+// Traffic report; the ownship report has the same layout
+// Only the fields the traffic display uses are filled in, the rest keep whatever the caller initialized them to.
+bool GDL90Decoder::report( const uchar *pMsg, int iLength, int &iICAO, StratuxTraffic &traffic )
+{
+    const char *pCallsign = reinterpret_cast<const char *>( pMsg + 19 );
+    int         iAlt, iSpeed, iVertSpeed, iStart = 0, iEnd = 0;
+
+    if( (iLength < ReportLength) || ((pMsg[0] != TrafficReport) && (pMsg[0] != OwnshipReport)) )
+        return false;
+
+    iICAO = (pMsg[2] << 16) | (pMsg[3] << 8) | pMsg[4];
+    traffic.dLat = int24At( pMsg + 5 ) * LatLongScale;
+    traffic.dLong = int24At( pMsg + 8 ) * LatLongScale;
+    // No lat/long at all or a zero integrity containment means no position
+    traffic.bPosValid = ((traffic.dLat != 0.0) || (traffic.dLong != 0.0)) && ((pMsg[13] >> 4) != 0);
+
+    iAlt = (pMsg[11] << 4) | (pMsg[12] >> 4);
+    if( iAlt != 0xFFF )
+        traffic.fAlt = (iAlt * 25.0f) - 1000.0f;
+    traffic.bOnGround = ((pMsg[12] & 0x08) == 0);
+
+    iSpeed = (pMsg[14] << 4) | (pMsg[15] >> 4);
+    if( iSpeed != 0xFFF )
+        traffic.fSpeed = static_cast<float>( iSpeed );
+    iVertSpeed = ((pMsg[15] & 0x0F) << 8) | pMsg[16];
+    if( iVertSpeed != 0x800 )
+    {
+        if( iVertSpeed & 0x800 )
+            iVertSpeed -= 0x1000;
+        traffic.fVertSpeed = iVertSpeed * 64.0f;
+    }
+    // Track is only meaningful if the track/heading type bits say it's valid
+    if( (pMsg[12] & 0x03) != 0 )
+        traffic.fTrack = static_cast<float>( pMsg[17] * TrackScale );
+
+    // The callsign is eight characters padded with spaces; interned straight out of the message
+    while( (iEnd < 8) && (pCallsign[iEnd] != 0) )
+        iEnd++;
+    while( (iStart < iEnd) && (pCallsign[iStart] == ' ') )
+        iStart++;
+    while( (iEnd > iStart) && (pCallsign[iEnd - 1] == ' ') )
+        iEnd--;
+    traffic.iTail = StringTable::intern( QLatin1String( pCallsign + iStart, iEnd - iStart ) );
+    traffic.fAge = 0.0f;
+
+    return true;
+}
+
+
+// Ownship report into the GPS portion of the situation
+bool GDL90Decoder::ownship( const uchar *pMsg, int iLength, StratuxSituation &situation )
+{
+    StratuxTraffic own;
+    int            iICAO;
+
+    own.dLat = situation.dGPSlat;
+    own.dLong = situation.dGPSlong;
+    own.fAlt = static_cast<float>( situation.dBaroPressAlt );
+    own.fSpeed = static_cast<float>( situation.dGPSGroundSpeed );
+    own.fVertSpeed = static_cast<float>( situation.dGPSVertSpeed * 60.0 );
+    own.fTrack = static_cast<float>( situation.dGPSTrueCourse );
+    if( (iLength < ReportLength) || (pMsg[0] != OwnshipReport) || (!report( pMsg, iLength, iICAO, own )) )
+        return false;
+
+    if( own.bPosValid )
+    {
+        situation.dGPSlat = own.dLat;
+        situation.dGPSlong = own.dLong;
+    }
+    situation.dGPSGroundSpeed = own.fSpeed;
+    situation.dGPSVertSpeed = own.fVertSpeed / 60.0;    // The situation has it in feet per second
+    situation.dGPSTrueCourse = own.fTrack;
+    situation.iGPSNACp = pMsg[13] & 0x0F;
+
+    return true;
+}
+
+
+// Ownship geometric (GPS) altitude
+bool GDL90Decoder::ownshipGeoAlt( const uchar *pMsg, int iLength, StratuxSituation &situation )
+{
+    if( (iLength < 5) || (pMsg[0] != OwnshipGeoAlt) )
+        return false;
+
+    situation.dGPSAltMSL = int16At( pMsg + 1 ) * 5.0;
+
+    return true;
+}
+
+
+// Stratux AHRS extension ("LE" message)
+bool GDL90Decoder::ahrs( const uchar *pMsg, int iLength, StratuxSituation &situation )
+{
+    int iVal;
+
+    if( (iLength < AHRSLength) || (pMsg[0] != StratuxAHRS) || (pMsg[1] != 0x45) || (pMsg[2] != 0x01) )
+        return false;
+
+    if( (iVal = int16At( pMsg + 4 )) != AHRSInvalid )
+        situation.dAHRSroll = iVal / 10.0;
+    if( (iVal = int16At( pMsg + 6 )) != AHRSInvalid )
+        situation.dAHRSpitch = iVal / 10.0;
+    if( (iVal = int16At( pMsg + 8 )) != AHRSInvalid )
+    {
+        situation.dAHRSGyroHeading = iVal / 10.0;
+        if( situation.dAHRSGyroHeading < 0.0 )
+            situation.dAHRSGyroHeading += 360.0;
+        situation.dAHRSMagHeading = situation.dAHRSGyroHeading;
+    }
+    // Stratux flips the sign of slip/skid for GDL90
+    if( (iVal = int16At( pMsg + 10 )) != AHRSInvalid )
+        situation.dAHRSSlipSkid = -iVal / 10.0;
+    if( (iVal = int16At( pMsg + 12 )) != AHRSInvalid )
+        situation.dAHRSTurnRate = iVal / 10.0;
+    if( (iVal = int16At( pMsg + 14 )) != AHRSInvalid )
+        situation.dAHRSGLoad = iVal / 10.0;
+    // Pressure altitude is offset by 5000 ft so it fits unsigned
+    iVal = (pMsg[18] << 8) | pMsg[19];
+    if( iVal != 0xFFFF )
+        situation.dBaroPressAlt = iVal - 5000.0;
+    if( (iVal = int16At( pMsg + 20 )) != AHRSInvalid )
+        situation.dBaroVertSpeed = iVal;
+    situation.iAHRSStatus = 1;
+
+    return true;
+}
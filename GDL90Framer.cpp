@@ -0,0 +1,140 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <string.h>
+
+#include "GDL90Framer.h"
+
+
+#define FlagByte   0x7E
+#define EscapeByte 0x7D
+#define EscapeXOR  0x20
+
+
+quint16 GDL90Framer::m_crcTables[8][256];
+bool    GDL90Framer::m_bTablesBuilt = false;
+
+
+// Find, unstuff and CRC check the next frame in a buffer starting at iPos
+// The buffer is modified in place. On return ppMsg points at the message ID byte and iPos has moved past
+// the frame. Returns the message length without the CRC, -1 for a bad frame (just call again for the next
+// one) or 0 once there are no more frames.
+int GDL90Framer::nextFrame( uchar *pData, int iLength, int &iPos, uchar **ppMsg )
+{
+    int iStart, iEnd, iMsgLen;
+
+    // Opening flag
+    while( (iPos < iLength) && (pData[iPos] != FlagByte) )
+        iPos++;
+    // Back to back flags are just the end of one frame and the start of the next
+    while( ((iPos + 1) < iLength) && (pData[iPos + 1] == FlagByte) )
+        iPos++;
+    if( (iPos + 1) >= iLength )
+    {
+        iPos = iLength;
+        return 0;
+    }
+    iStart = iPos + 1;
+
+    // Closing flag; it's left in place as the opening flag of the next frame
+    iEnd = iStart;
+    while( (iEnd < iLength) && (pData[iEnd] != FlagByte) )
+        iEnd++;
+    iPos = iEnd;
+    if( iEnd >= iLength )
+        return 0;
+
+    iMsgLen = unstuff( pData + iStart, iEnd - iStart );
+    // Needs at least a message ID and the CRC, which is low byte first
+    if( iMsgLen < 3 )
+        return -1;
+    iMsgLen -= 2;
+    if( crc( pData + iStart, iMsgLen ) != static_cast<quint16>( pData[iStart + iMsgLen] | (pData[iStart + iMsgLen + 1] << 8) ) )
+        return -1;
+
+    *ppMsg = pData + iStart;
+
+    return iMsgLen;
+}
+
+
+// Remove the escapes from a frame in place and return the new length, or -1 if it ends in an escape
+// The write position never gets ahead of the read position so one buffer does for both.
+int GDL90Framer::unstuff( uchar *pFrame, int iLength )
+{
+    const uchar *pEscape = static_cast<const uchar *>( memchr( pFrame, EscapeByte, iLength ) );
+    int          iOut, iIn;
+
+    // Most frames have nothing escaped
+    if( pEscape == 0 )
+        return iLength;
+
+    iOut = static_cast<int>( pEscape - pFrame );
+    for( iIn = iOut; iIn < iLength; iIn++ )
+    {
+        if( pFrame[iIn] == EscapeByte )
+        {
+            iIn++;
+            if( iIn >= iLength )
+                return -1;
+            pFrame[iOut++] = pFrame[iIn] ^ EscapeXOR;
+        }
+        else
+            pFrame[iOut++] = pFrame[iIn];
+    }
+
+    return iOut;
+}
+
+
+// CRC-CCITT (polynomial 0x1021, zero initial value) the way the GDL90 spec computes it
+// The spec's byte at a time form is crc = T[crc >> 8] ^ (crc << 8) ^ byte. Each of the eight tables is
+// that step applied to a byte a further time, so eight bytes and the starting CRC fold together with ten
+// lookups and the remaining bytes go one at a time.
+quint16 GDL90Framer::crc( const uchar *pData, int iLength )
+{
+    quint16 uiCRC = 0;
+    int     i = 0;
+
+    if( !m_bTablesBuilt )
+        buildTables();
+
+    for( ; (i + 8) <= iLength; i += 8 )
+    {
+        uiCRC = m_crcTables[7][uiCRC >> 8] ^ m_crcTables[6][uiCRC & 0xFF] ^
+                m_crcTables[5][pData[i]] ^ m_crcTables[4][pData[i + 1]] ^
+                m_crcTables[3][pData[i + 2]] ^ m_crcTables[2][pData[i + 3]] ^
+                m_crcTables[1][pData[i + 4]] ^ m_crcTables[0][pData[i + 5]] ^
+                static_cast<quint16>( (pData[i + 6] << 8) | pData[i + 7] );
+    }
+    for( ; i < iLength; i++ )
+        uiCRC = static_cast<quint16>( m_crcTables[0][uiCRC >> 8] ^ (uiCRC << 8) ^ pData[i] );
+
+    return uiCRC;
+}
+
+
+// Table 0 is the one from the spec; each following table is one more CRC step applied to the previous one
+void GDL90Framer::buildTables()
+{
+    quint16 uiEntry;
+
+    for( int i = 0; i < 256; i++ )
+    {
+        uiEntry = static_cast<quint16>( i << 8 );
+        for( int iBit = 0; iBit < 8; iBit++ )
+            uiEntry = static_cast<quint16>( (uiEntry << 1) ^ ((uiEntry & 0x8000) ? 0x1021 : 0) );
+        m_crcTables[0][i] = uiEntry;
+    }
+    for( int iTable = 1; iTable < 8; iTable++ )
+    {
+        for( int i = 0; i < 256; i++ )
+        {
+            uiEntry = m_crcTables[iTable - 1][i];
+            m_crcTables[iTable][i] = static_cast<quint16>( m_crcTables[0][uiEntry >> 8] ^ (uiEntry << 8) );
+        }
+    }
+    m_bTablesBuilt = true;
+}
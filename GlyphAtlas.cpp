@@ -0,0 +1,119 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QPainter>
+#include <QFont>
+#include <QColor>
+#include <QFontMetricsF>
+#include <QRect>
+
+#include <math.h>
+
+#include "GlyphAtlas.h"
+
+
+#define FirstGlyph 32       // Space
+#define CellPad    2        // Clear pixels around each glyph's ink so antialiasing and bearings aren't cut off
+
+
+GlyphAtlas::GlyphAtlas()
+    : m_iAscent( 0 )
+{
+    for( int i = 0; i < ATLAS_GLYPHS; i++ )
+    {
+        m_glyphs[i].iCell = 0;
+        m_glyphs[i].iCellWidth = 0;
+        m_glyphs[i].iLeft = 0;
+        m_glyphs[i].dAdvance = 0.0;
+    }
+}
+
+
+// Lay out a cell for each character wide enough for its ink and draw them all into the strip
+void GlyphAtlas::build( const QFont &font, const QColor &color )
+{
+    QFontMetricsF metrics( font );
+    QPainter      painter;
+    QRectF        ink;
+    QChar         ch;
+    int           iStripWidth = 0;
+
+    m_iAscent = static_cast<int>( ceil( metrics.ascent() ) ) + CellPad;
+    for( int i = 0; i < ATLAS_GLYPHS; i++ )
+    {
+        ch = QLatin1Char( static_cast<char>( FirstGlyph + i ) );
+        ink = metrics.boundingRect( ch );
+        m_glyphs[i].iCell = iStripWidth;
+        m_glyphs[i].iLeft = static_cast<int>( floor( ink.left() ) ) - CellPad;
+        m_glyphs[i].iCellWidth = static_cast<int>( ceil( ink.right() ) ) + CellPad - m_glyphs[i].iLeft;
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 11, 0 )
+        m_glyphs[i].dAdvance = metrics.horizontalAdvance( ch );
+#else
+        m_glyphs[i].dAdvance = metrics.width( ch );
+#endif
+        iStripWidth += m_glyphs[i].iCellWidth;
+    }
+
+    m_strip = QPixmap( iStripWidth, m_iAscent + static_cast<int>( ceil( metrics.descent() ) ) + CellPad );
+    m_strip.fill( Qt::transparent );
+    painter.begin( &m_strip );
+    painter.setRenderHint( QPainter::TextAntialiasing, true );
+    painter.setFont( font );
+    painter.setPen( color );
+    for( int i = 0; i < ATLAS_GLYPHS; i++ )
+    {
+        ch = QLatin1Char( static_cast<char>( FirstGlyph + i ) );
+        painter.drawText( QPointF( m_glyphs[i].iCell - m_glyphs[i].iLeft, m_iAscent ), QString( ch ) );
+    }
+    painter.end();
+}
+
+
+// Draw text with its baseline starting at dX, dBaseline the way QPainter::drawText would
+// Each character is snapped to a whole pixel while the advances add up unrounded so spacing doesn't drift.
+void GlyphAtlas::draw( QPainter *pPainter, double dX, double dBaseline, const QString &qsText ) const
+{
+    const QChar *pText = qsText.constData();
+    int          iTop = static_cast<int>( floor( dBaseline + 0.5 ) ) - m_iAscent;
+
+    if( m_strip.isNull() )
+        return;
+
+    for( int i = 0; i < qsText.length(); i++ )
+    {
+        const Glyph &g = glyph( pText[i] );
+
+        if( pText[i] != QLatin1Char( ' ' ) )
+            pPainter->drawPixmap( QRect( static_cast<int>( floor( dX + 0.5 ) ) + g.iLeft, iTop, g.iCellWidth, m_strip.height() ),
+                                  m_strip,
+                                  QRect( g.iCell, 0, g.iCellWidth, m_strip.height() ) );
+        dX += g.dAdvance;
+    }
+}
+
+
+// Width of the text as draw() lays it out
+int GlyphAtlas::width( const QString &qsText ) const
+{
+    const QChar *pText = qsText.constData();
+    double       dWidth = 0.0;
+
+    for( int i = 0; i < qsText.length(); i++ )
+        dWidth += glyph( pText[i] ).dAdvance;
+
+    return static_cast<int>( floor( dWidth + 0.5 ) );
+}
+
+
+// The cell a character is drawn from
+const GlyphAtlas::Glyph &GlyphAtlas::glyph( QChar ch ) const
+{
+    ushort uiChar = ch.unicode();
+
+    if( (uiChar < FirstGlyph) || (uiChar >= (FirstGlyph + ATLAS_GLYPHS)) )
+        uiChar = '?';
+
+    return m_glyphs[uiChar - FirstGlyph];
+}
@@ -0,0 +1,236 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QDateTime>
+#include <QSettings>
+
+#include <stdio.h>
+
+#include "HeadlessPipeline.h"
+#include "StreamReader.h"
+
+
+#define TickInterval 16         // Same as the canvas frame timer
+#define TrafficRange 40.0       // Nautical miles; about the outer ring of the heading dial
+#define RadarRange   60.0       // NEXRAD raster range in nautical miles
+
+
+HeadlessPipeline::HeadlessPipeline( QObject *parent )
+    : QObject( parent ),
+      m_pStream( new StreamReader( this ) ),
+      m_bStratux( false ),
+      m_iSituations( 0 ),
+      m_iTrafficBatches( 0 ),
+      m_iTrafficUpdates( 0 ),
+      m_iWeather( 0 ),
+      m_iNexradBlocks( 0 ),
+      m_iTicks( 0 ),
+      m_iTickNs( 0 ),
+      m_iMaxTickNs( 0 ),
+      m_iLastSituations( 0 ),
+      m_iLastTrafficUpdates( 0 ),
+      m_iLastTicks( 0 ),
+      m_iLastTickNs( 0 )
+{
+    QSettings config;
+
+    StreamReader::initSituation( m_situation );
+
+    config.beginGroup( "Global" );
+    m_predictor.setHorizon( config.value( "AttitudeHorizonMs", 100 ).toInt() );
+    config.endGroup();
+
+    connect( m_pStream, SIGNAL( newSituation( SituationSnapshot ) ), this, SLOT( situation( SituationSnapshot ) ) );
+    connect( m_pStream, SIGNAL( newTraffic( TrafficSnapshot ) ), this, SLOT( traffic( TrafficSnapshot ) ) );
+    connect( m_pStream, SIGNAL( newWeather( WeatherSnapshot ) ), this, SLOT( weather( WeatherSnapshot ) ) );
+    connect( m_pStream, SIGNAL( newNexrad( NexradBlock ) ), this, SLOT( nexrad( NexradBlock ) ) );
+    connect( m_pStream, SIGNAL( newStatus( bool, bool, bool, bool, bool ) ), this, SLOT( status( bool, bool, bool, bool, bool ) ) );
+    connect( &m_tickTimer, SIGNAL( timeout() ), this, SLOT( tick() ) );
+    connect( &m_logTimer, SIGNAL( timeout() ), this, SLOT( log() ) );
+}
+
+
+HeadlessPipeline::~HeadlessPipeline()
+{
+    m_pStream->disconnectStreams();
+}
+
+
+// Connect the streams and start the frame and log timers
+void HeadlessPipeline::start( AHRS::StreamSource eSource, int iLogSecs )
+{
+    m_uptime.start();
+    m_sinceLog.start();
+    m_pStream->connectStreams( eSource );
+    m_tickTimer.start( TickInterval );
+    if( iLogSecs > 0 )
+        m_logTimer.start( iLogSecs * 1000 );
+
+    fprintf( stdout, "Rosco headless: %s source, logging every %d s\n", (eSource == AHRS::GDL90Source) ? "GDL90" : "websocket", iLogSecs );
+    fflush( stdout );
+}
+
+
+// Same ownship, predictor and radar bookkeeping as the canvas
+void HeadlessPipeline::situation( SituationSnapshot pSituation )
+{
+    const StratuxSituation &s = *pSituation;
+    qint64                  iNow = QDateTime::currentMSecsSinceEpoch();
+
+    m_iSituations++;
+    m_situation = s;
+    if( s.uiChanged & (AHRS::GPSTrackChanged | AHRS::GPSPosChanged | AHRS::BaroChanged) )
+    {
+        if( s.dBaroPressAlt != 0.0 )
+            m_trafficStore.setOwnship( s.dGPSTrueCourse, s.dGPSGroundSpeed, s.dBaroPressAlt, s.dBaroVertSpeed );
+        else
+            m_trafficStore.setOwnship( s.dGPSTrueCourse, s.dGPSGroundSpeed, s.dGPSAltMSL, s.dGPSVertSpeed * 60.0 );
+    }
+    m_predictor.addSample( s, iNow );
+    m_nexrad.expire( iNow );
+}
+
+
+void HeadlessPipeline::traffic( TrafficSnapshot pBatch )
+{
+    qint64 iNow = QDateTime::currentMSecsSinceEpoch();
+
+    m_iTrafficBatches++;
+    m_iTrafficUpdates += pBatch->count();
+    for( int i = 0; i < pBatch->count(); i++ )
+    {
+        const StratuxTrafficUpdate &trafficUpdate = pBatch->at( i );
+
+        m_trafficStore.update( trafficUpdate.iICAO, trafficUpdate.traffic, iNow );
+        m_trafficTrails.add( trafficUpdate.iICAO, trafficUpdate.traffic, iNow );
+        for( int j = 0; j < m_trafficStore.dropped().count(); j++ )
+            m_trafficTrails.remove( m_trafficStore.dropped().at( j ) );
+    }
+}
+
+
+void HeadlessPipeline::weather( WeatherSnapshot pWeather )
+{
+    m_iWeather++;
+    m_weatherStore.insert( *pWeather, QDateTime::currentMSecsSinceEpoch() );
+}
+
+
+void HeadlessPipeline::nexrad( NexradBlock block )
+{
+    m_iNexradBlocks++;
+    m_nexrad.add( block, QDateTime::currentMSecsSinceEpoch() );
+}
+
+
+void HeadlessPipeline::status( bool bStratux, bool bAHRS, bool bGPS, bool bTraffic, bool bWeather )
+{
+    Q_UNUSED( bAHRS );
+    Q_UNUSED( bGPS );
+    Q_UNUSED( bTraffic );
+    Q_UNUSED( bWeather );
+
+    m_bStratux = bStratux;
+}
+
+
+// Everything a frame computes before it draws
+void HeadlessPipeline::tick()
+{
+    qint64 iNow = QDateTime::currentMSecsSinceEpoch();
+    qint64 iTickNs;
+
+    m_tickTime.start();
+
+    m_predictor.predict( iNow );
+    m_trafficStore.extrapolate( iNow );
+    for( int i = 0; i < m_trafficStore.dropped().count(); i++ )
+        m_trafficTrails.remove( m_trafficStore.dropped().at( i ) );
+    m_trafficStore.inRange( TrafficRange, m_visibleTraffic );
+    for( int i = 0; i < m_visibleTraffic.count(); i++ )
+        m_trafficTrails.relative( m_visibleTraffic.at( i ).iICAO, m_situation.dGPSlat, m_situation.dGPSlong, m_trailPoints );
+    m_trafficStore.threats( m_threats );
+    if( (m_situation.dGPSlat != 0.0) || (m_situation.dGPSlong != 0.0) )
+        m_nexrad.setView( m_situation.dGPSlat, m_situation.dGPSlong, RadarRange );
+
+    iTickNs = m_tickTime.nsecsElapsed();
+    m_iTicks++;
+    m_iTickNs += iTickNs;
+    if( iTickNs > m_iMaxTickNs )
+        m_iMaxTickNs = iTickNs;
+}
+
+
+// One line of throughput, timing and memory since the last line
+void HeadlessPipeline::log()
+{
+    double                dSecs = qMax( m_sinceLog.elapsed(), static_cast<qint64>( 1 ) ) / 1000.0;
+    qint64                iTicks = m_iTicks - m_iLastTicks;
+    qint64                iVirtual = 0, iResident = 0;
+    StreamStats::Counters situationStats, gdl90Stats;
+
+    m_pStream->stats( AHRS::SituationEndpoint ).counters( situationStats );
+    m_pStream->stats( AHRS::GDL90Endpoint ).counters( gdl90Stats );
+    MetricsServer::memoryUsage( iVirtual, iResident );
+
+    fprintf( stdout, "%8.0f s %s | sit %6.1f/s traf %6.1f/s | tracked %4d pos %4d vis %4d thr %3d | wx %4d nexrad %5d | "
+                     "tick %6.1f us max %7.1f us | msgs %lld gdl90 %lld | rss %lld kB\n",
+             m_uptime.elapsed() / 1000.0,
+             m_bStratux ? "up  " : "down",
+             (m_iSituations - m_iLastSituations) / dSecs,
+             (m_iTrafficUpdates - m_iLastTrafficUpdates) / dSecs,
+             m_trafficStore.count(),
+             m_trafficStore.positionCount(),
+             m_visibleTraffic.count(),
+             m_threats.count(),
+             m_weatherStore.count(),
+             m_nexrad.count(),
+             (iTicks > 0) ? ((m_iTickNs - m_iLastTickNs) / iTicks / 1000.0) : 0.0,
+             m_iMaxTickNs / 1000.0,
+             static_cast<long long>( situationStats.iMessages ),
+             static_cast<long long>( gdl90Stats.iMessages ),
+             static_cast<long long>( iResident / 1024 ) );
+    fflush( stdout );
+
+    m_iLastSituations = m_iSituations;
+    m_iLastTrafficUpdates = m_iTrafficUpdates;
+    m_iLastTicks = m_iTicks;
+    m_iLastTickNs = m_iTickNs;
+    m_sinceLog.start();
+}
+
+
+// Pipeline counters for the metrics endpoint
+void HeadlessPipeline::metrics( MetricsWriter &writer ) const
+{
+    writer.family( "rosco_headless_situations_total", "counter", "Situations taken in." );
+    writer.value( "rosco_headless_situations_total", m_iSituations );
+    writer.family( "rosco_headless_traffic_updates_total", "counter", "Traffic updates taken in." );
+    writer.value( "rosco_headless_traffic_updates_total", m_iTrafficUpdates );
+    writer.family( "rosco_headless_traffic_batches_total", "counter", "Traffic batches taken in." );
+    writer.value( "rosco_headless_traffic_batches_total", m_iTrafficBatches );
+    writer.family( "rosco_headless_weather_total", "counter", "Weather products taken in." );
+    writer.value( "rosco_headless_weather_total", m_iWeather );
+    writer.family( "rosco_headless_nexrad_blocks_total", "counter", "NEXRAD blocks taken in." );
+    writer.value( "rosco_headless_nexrad_blocks_total", m_iNexradBlocks );
+    writer.family( "rosco_frames_total", "counter", "Frames computed." );
+    writer.value( "rosco_frames_total", m_iTicks );
+    writer.family( "rosco_frame_seconds_total", "counter", "Time spent computing frames." );
+    writer.value( "rosco_frame_seconds_total", m_iTickNs / 1.0e9 );
+    writer.family( "rosco_frame_max_seconds", "gauge", "Longest frame computation." );
+    writer.value( "rosco_frame_max_seconds", m_iMaxTickNs / 1.0e9 );
+    writer.family( "rosco_traffic_tracked", "gauge", "Aircraft being tracked." );
+    writer.value( "rosco_traffic_tracked", m_trafficStore.count() );
+    writer.family( "rosco_traffic_positioned", "gauge", "Tracked aircraft with a position." );
+    writer.value( "rosco_traffic_positioned", m_trafficStore.positionCount() );
+    writer.family( "rosco_traffic_visible", "gauge", "Aircraft in range on the last frame." );
+    writer.value( "rosco_traffic_visible", m_visibleTraffic.count() );
+    writer.family( "rosco_traffic_threats", "gauge", "Aircraft with a closest point of approach on the last frame." );
+    writer.value( "rosco_traffic_threats", m_threats.count() );
+    writer.family( "rosco_weather_products", "gauge", "Weather products held." );
+    writer.value( "rosco_weather_products", m_weatherStore.count() );
+    writer.family( "rosco_nexrad_tiles", "gauge", "NEXRAD blocks held." );
+    writer.value( "rosco_nexrad_tiles", m_nexrad.count() );
+}
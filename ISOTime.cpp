@@ -0,0 +1,175 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include "ISOTime.h"
+
+
+#define FixedLength 19              // YYYY-MM-DDTHH:MM:SS
+#define MinValidSec -62135596800LL  // Start of year 1 (Go's zero time) and anything before it is never valid
+#define MaxNSecsSec 9223372035LL    // Last second whose nanoseconds fit in 64 bits
+
+
+// Read a fixed number of decimal digits
+template <typename T>
+static bool digits( const T *pText, int iCount, int &iValue )
+{
+    unsigned int uiDigit;
+
+    iValue = 0;
+    for( int i = 0; i < iCount; i++ )
+    {
+        uiDigit = static_cast<unsigned int>( pText[i] ) - '0';
+        if( uiDigit > 9 )
+            return false;
+        iValue = (iValue * 10) + static_cast<int>( uiDigit );
+    }
+
+    return true;
+}
+
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's days_from_civil)
+static qint64 daysFromCivil( int iYear, int iMonth, int iDay )
+{
+    int iEra, iYearOfEra, iDayOfYear, iDayOfEra;
+
+    iYear -= (iMonth <= 2) ? 1 : 0;
+    iEra = ((iYear >= 0) ? iYear : (iYear - 399)) / 400;
+    iYearOfEra = iYear - (iEra * 400);
+    iDayOfYear = (((153 * (iMonth + ((iMonth > 2) ? -3 : 9))) + 2) / 5) + iDay - 1;
+    iDayOfEra = (iYearOfEra * 365) + (iYearOfEra / 4) - (iYearOfEra / 100) + iDayOfYear;
+
+    return (static_cast<qint64>( iEra ) * 146097) + iDayOfEra - 719468;
+}
+
+
+// Shared by the UTF-16 and Latin-1 versions
+template <typename T>
+static bool parseTime( const T *pText, int iLength, qint64 &iSecs, int &iNanos )
+{
+    int iYear, iMonth, iDay, iHour, iMinute, iSecond, iPos = FixedLength;
+    int iDigits = 0, iOffsetHours = 0, iOffsetMinutes = 0, iOffsetSign = 0;
+
+    if( (iLength < FixedLength) ||
+        (pText[4] != '-') || (pText[7] != '-') || (pText[13] != ':') || (pText[16] != ':') ||
+        ((pText[10] != 'T') && (pText[10] != 't') && (pText[10] != ' ')) )
+        return false;
+    if( (!digits( pText, 4, iYear )) || (!digits( pText + 5, 2, iMonth )) || (!digits( pText + 8, 2, iDay )) ||
+        (!digits( pText + 11, 2, iHour )) || (!digits( pText + 14, 2, iMinute )) || (!digits( pText + 17, 2, iSecond )) )
+        return false;
+    if( (iMonth < 1) || (iMonth > 12) || (iDay < 1) || (iDay > 31) || (iHour > 23) || (iMinute > 59) || (iSecond > 60) )
+        return false;
+
+    // Fraction of a second; anything past nanoseconds is dropped
+    iNanos = 0;
+    if( (iPos < iLength) && (pText[iPos] == '.') )
+    {
+        int iDigit;
+
+        for( iPos++; (iPos < iLength) && digits( pText + iPos, 1, iDigit ); iPos++ )
+        {
+            if( iDigits < 9 )
+            {
+                iNanos = (iNanos * 10) + iDigit;
+                iDigits++;
+            }
+        }
+        if( iDigits == 0 )
+            return false;
+        for( ; iDigits < 9; iDigits++ )
+            iNanos *= 10;
+    }
+
+    // Zone; no zone at all is taken as UTC
+    if( iPos < iLength )
+    {
+        if( (pText[iPos] == 'Z') || (pText[iPos] == 'z') )
+            iPos++;
+        else if( (pText[iPos] == '+') || (pText[iPos] == '-') )
+        {
+            iOffsetSign = (pText[iPos] == '+') ? 1 : -1;
+            iPos++;
+            if( ((iPos + 2) > iLength) || (!digits( pText + iPos, 2, iOffsetHours )) )
+                return false;
+            iPos += 2;
+            if( (iPos < iLength) && (pText[iPos] == ':') )
+                iPos++;
+            if( iPos < iLength )
+            {
+                if( ((iPos + 2) > iLength) || (!digits( pText + iPos, 2, iOffsetMinutes )) )
+                    return false;
+                iPos += 2;
+            }
+        }
+        else
+            return false;
+    }
+    if( iPos != iLength )
+        return false;
+
+    iSecs = (daysFromCivil( iYear, iMonth, iDay ) * 86400) + (iHour * 3600) + (iMinute * 60) + iSecond -
+            (iOffsetSign * ((iOffsetHours * 3600) + (iOffsetMinutes * 60)));
+
+    return true;
+}
+
+
+// Parse a time held in a QString; reads the UTF-16 data directly
+bool ISOTime::parse( const QString &qsTime, qint64 &iSecs, int &iNanos )
+{
+    return parseTime( qsTime.utf16(), qsTime.length(), iSecs, iNanos );
+}
+
+
+// Parse a time in part of a larger string such as a field of a message
+bool ISOTime::parse( const QStringRef &time, qint64 &iSecs, int &iNanos )
+{
+    return parseTime( reinterpret_cast<const ushort *>( time.unicode() ), time.length(), iSecs, iNanos );
+}
+
+
+// Parse a time straight out of a (Latin-1/UTF-8) message buffer
+bool ISOTime::parse( const char *szTime, int iLength, qint64 &iSecs, int &iNanos )
+{
+    return parseTime( reinterpret_cast<const uchar *>( szTime ), iLength, iSecs, iNanos );
+}
+
+
+// Milliseconds since the epoch or 0 if it isn't a valid time
+qint64 ISOTime::toMSecs( const QString &qsTime )
+{
+    return toMSecs( QStringRef( &qsTime ) );
+}
+
+
+qint64 ISOTime::toMSecs( const QStringRef &time )
+{
+    qint64 iSecs;
+    int    iNanos;
+
+    if( (!parse( time, iSecs, iNanos )) || (iSecs <= MinValidSec) )
+        return 0;
+
+    return (iSecs * 1000) + (iNanos / 1000000);
+}
+
+
+// Nanoseconds since the epoch or 0 if it isn't a valid time or is too far out to fit
+qint64 ISOTime::toNSecs( const QString &qsTime )
+{
+    return toNSecs( QStringRef( &qsTime ) );
+}
+
+
+qint64 ISOTime::toNSecs( const QStringRef &time )
+{
+    qint64 iSecs;
+    int    iNanos;
+
+    if( (!parse( time, iSecs, iNanos )) || (iSecs <= MinValidSec) || (iSecs < -MaxNSecsSec) || (iSecs > MaxNSecsSec) )
+        return 0;
+
+    return (iSecs * 1000000000LL) + iNanos;
+}
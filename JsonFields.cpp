@@ -0,0 +1,99 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include "JsonFields.h"
+
+
+JsonFields::JsonFields( const QString &qsMessage )
+    : m_pMessage( &qsMessage ),
+      m_pText( qsMessage.constData() ),
+      m_iLength( qsMessage.length() ),
+      m_iPos( 0 )
+{
+}
+
+
+// Move on to the next tagged field; false once there are no more
+// Anything outside a string that isn't a value (braces, brackets, commas and untagged array elements) is
+// stepped over a character at a time looking for the next quote.
+bool JsonFields::next()
+{
+    ushort uiChar;
+    int    iStart;
+
+    while( m_iPos < m_iLength )
+    {
+        if( m_pText[m_iPos] != QLatin1Char( '\"' ) )
+        {
+            m_iPos++;
+            continue;
+        }
+        if( !quoted( m_tag ) )
+            return false;
+
+        // A string with no colon after it is an array element rather than a tag
+        skipSpace();
+        if( (m_iPos >= m_iLength) || (m_pText[m_iPos] != QLatin1Char( ':' )) )
+            continue;
+        m_iPos++;
+        skipSpace();
+
+        iStart = m_iPos;
+        uiChar = (m_iPos < m_iLength) ? m_pText[m_iPos].unicode() : 0;
+        if( uiChar == '\"' )
+            quoted( m_value );
+        else if( (uiChar == '{') || (uiChar == '[') )
+            m_value = QStringRef( m_pMessage, iStart, 0 );  // Left for the next call to walk into
+        else
+        {
+            while( m_iPos < m_iLength )
+            {
+                uiChar = m_pText[m_iPos].unicode();
+                if( (uiChar == ',') || (uiChar == '}') || (uiChar == ']') || (uiChar == ' ') || (uiChar == '\t') ||
+                    (uiChar == '\r') || (uiChar == '\n') )
+                    break;
+                m_iPos++;
+            }
+            m_value = QStringRef( m_pMessage, iStart, m_iPos - iStart );
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+// The string starting at the quote under the current position, without the quotes
+// A string missing its closing quote runs to the end of the message and returns false.
+bool JsonFields::quoted( QStringRef &text )
+{
+    int iStart = m_iPos + 1;
+
+    for( m_iPos = iStart; m_iPos < m_iLength; m_iPos++ )
+    {
+        if( m_pText[m_iPos] == QLatin1Char( '\\' ) )
+            m_iPos++;
+        else if( m_pText[m_iPos] == QLatin1Char( '\"' ) )
+            break;
+    }
+    if( m_iPos >= m_iLength )
+    {
+        text = QStringRef( m_pMessage, iStart, m_iLength - iStart );
+        m_iPos = m_iLength;
+        return false;
+    }
+    text = QStringRef( m_pMessage, iStart, m_iPos - iStart );
+    m_iPos++;
+
+    return true;
+}
+
+
+void JsonFields::skipSpace()
+{
+    while( (m_iPos < m_iLength) && m_pText[m_iPos].isSpace() )
+        m_iPos++;
+}
@@ -29,12 +29,16 @@ MenuDialog::MenuDialog( QWidget *pParent )
     config.beginGroup( "Global" );
     m_eTrafficDisp = static_cast<AHRS::TrafficDisp>( config.value( "TrafficDisp", static_cast<int>( AHRS::AllTraffic ) ).toInt() );
     updateTrafficButton();
+    m_eStreamSource = static_cast<AHRS::StreamSource>( config.value( "StreamSource", static_cast<int>( AHRS::WebSocketSource ) ).toInt() );
+    updateStreamButton();
     config.endGroup();
 
     connect( m_pExitButton, SIGNAL( clicked() ), this, SLOT( exit() ) );
     connect( m_pTrafficButton, SIGNAL( clicked() ), this, SLOT( traffic() ) );
+    connect( m_pStreamButton, SIGNAL( clicked() ), this, SLOT( streamSource() ) );
     connect( m_pGarminToggleButton, SIGNAL( clicked() ), this, SLOT( garminToggle() ) );
     connect( m_pResetLevelButton, SIGNAL( clicked() ), this, SLOT( resetLevel() ) );
+    connect( m_pDiagnosticsButton, SIGNAL( clicked() ), this, SLOT( diagnostics() ) );
     connect( m_pDoneButton, SIGNAL( clicked() ), this, SLOT( accept() ) );
 }
 
@@ -68,6 +72,22 @@ void MenuDialog::traffic()
 }
 
 
+// Switch between the JSON websockets and the binary GDL90 stream
+// The main window reconnects using the new source when the dialog is accepted.
+void MenuDialog::streamSource()
+{
+    QSettings config;
+
+    m_eStreamSource = (m_eStreamSource == AHRS::GDL90Source) ? AHRS::WebSocketSource : AHRS::GDL90Source;
+    updateStreamButton();
+
+    config.beginGroup( "Global" );
+    config.setValue( "StreamSource", static_cast<int>( m_eStreamSource ) );
+    config.endGroup();
+    config.sync();
+}
+
+
 // Set screen to stay on or not
 void MenuDialog::garminToggle()
 {
@@ -91,6 +111,16 @@ void MenuDialog::resetLevel()
 }
 
 
+// Close the menu and have the main window bring up the stream diagnostics
+void MenuDialog::diagnostics()
+{
+    QSettings config;
+
+    config.sync();
+    done( Diagnostics );
+}
+
+
 // Sync the config and close the dialog
 void MenuDialog::exit()
 {
@@ -135,3 +165,18 @@ void MenuDialog::updateTrafficButton()
     }
 }
 
+
+// Show which stream source is selected
+void MenuDialog::updateStreamButton()
+{
+    if( m_eStreamSource == AHRS::GDL90Source )
+    {
+        m_pStreamButton->setStyleSheet( "QPushButton { background-color: qlineargradient( x1:0, y1:0, x2:0, y2:1, stop: 0 white, stop:1 #ffa500 ); }" );
+        m_pStreamButton->setText( " GDL90 (UDP)  " );
+    }
+    else
+    {
+        m_pStreamButton->setStyleSheet( "QPushButton { background-color: qlineargradient( x1:0, y1:0, x2:0, y2:1, stop: 0 white, stop:1 green ); }" );
+        m_pStreamButton->setText( " WEBSOCKETS  " );
+    }
+}
@@ -0,0 +1,206 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QFile>
+#include <QDateTime>
+
+#if defined( Q_OS_LINUX )
+#include <unistd.h>
+#endif
+
+#include "MetricsServer.h"
+
+
+#define MaxRequestSize 8192     // Anything bigger than this isn't a scrape
+
+
+MetricsWriter::MetricsWriter( QByteArray &page )
+    : m_page( page )
+{
+}
+
+
+// HELP and TYPE lines that go once before the values of a metric
+void MetricsWriter::family( const char *szName, const char *szType, const char *szHelp )
+{
+    m_page += "# HELP ";
+    m_page += szName;
+    m_page += ' ';
+    m_page += szHelp;
+    m_page += "\n# TYPE ";
+    m_page += szName;
+    m_page += ' ';
+    m_page += szType;
+    m_page += '\n';
+}
+
+
+void MetricsWriter::value( const char *szName, double dValue )
+{
+    m_page += szName;
+    m_page += ' ';
+    m_page += QByteArray::number( dValue, 'g', 15 );
+    m_page += '\n';
+}
+
+
+void MetricsWriter::value( const char *szName, const char *szLabel, const char *szLabelValue, double dValue )
+{
+    m_page += szName;
+    m_page += '{';
+    m_page += szLabel;
+    m_page += "=\"";
+    m_page += szLabelValue;
+    m_page += "\"} ";
+    m_page += QByteArray::number( dValue, 'g', 15 );
+    m_page += '\n';
+}
+
+
+MetricsServer::MetricsServer( QObject *parent )
+    : QObject( parent ),
+      m_iScrapes( 0 ),
+      m_iStartTime( QDateTime::currentMSecsSinceEpoch() )
+{
+    connect( &m_server, SIGNAL( newConnection() ), this, SLOT( newClient() ) );
+}
+
+
+// Start serving on the loopback interface
+bool MetricsServer::listen( quint16 uiPort )
+{
+    return m_server.listen( QHostAddress::LocalHost, uiPort );
+}
+
+
+void MetricsServer::addSource( const MetricsSource *pSource )
+{
+    if( (pSource != 0) && (!m_sources.contains( pSource )) )
+        m_sources.append( pSource );
+}
+
+
+void MetricsServer::newClient()
+{
+    QTcpSocket *pClient;
+
+    while( (pClient = m_server.nextPendingConnection()) != 0 )
+    {
+        connect( pClient, SIGNAL( readyRead() ), this, SLOT( clientData() ) );
+        connect( pClient, SIGNAL( disconnected() ), pClient, SLOT( deleteLater() ) );
+    }
+}
+
+
+// Gather the request until the end of the headers and then answer it
+// The request is kept in the socket's read buffer until it's complete so nothing has to be held per client.
+void MetricsServer::clientData()
+{
+    QTcpSocket *pClient = qobject_cast<QTcpSocket *>( sender() );
+
+    if( pClient == 0 )
+        return;
+
+    QByteArray request( pClient->peek( MaxRequestSize ) );
+
+    if( request.contains( "\r\n\r\n" ) || request.contains( "\n\n" ) )
+    {
+        pClient->readAll();
+        respond( pClient, request );
+    }
+    else if( request.size() >= MaxRequestSize )
+    {
+        pClient->abort();
+        pClient->deleteLater();
+    }
+}
+
+
+// Send the metrics for GET /metrics (or /) and a 404 for anything else, then hang up
+void MetricsServer::respond( QTcpSocket *pClient, const QByteArray &request )
+{
+    QByteArray qbaBody;
+    QByteArray qbaStatus;
+
+    disconnect( pClient, SIGNAL( readyRead() ), this, SLOT( clientData() ) );
+
+    if( request.startsWith( "GET /metrics " ) || request.startsWith( "GET / " ) )
+    {
+        m_iScrapes++;
+        qbaStatus = "200 OK";
+        qbaBody = page();
+    }
+    else
+    {
+        qbaStatus = "404 Not Found";
+        qbaBody = "Not found\n";
+    }
+
+    pClient->write( "HTTP/1.0 " + qbaStatus + "\r\n"
+                    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                    "Content-Length: " + QByteArray::number( qbaBody.size() ) + "\r\n"
+                    "Connection: close\r\n\r\n" );
+    pClient->write( qbaBody );
+    pClient->disconnectFromHost();
+}
+
+
+// Process level metrics followed by each source's
+QByteArray MetricsServer::page() const
+{
+    QByteArray    qbaPage;
+    MetricsWriter writer( qbaPage );
+    qint64        iVirtual, iResident;
+
+    qbaPage.reserve( 16384 );
+
+    writer.family( "rosco_uptime_seconds", "gauge", "Seconds since the metrics server started." );
+    writer.value( "rosco_uptime_seconds", (QDateTime::currentMSecsSinceEpoch() - m_iStartTime) / 1000.0 );
+    writer.family( "rosco_scrapes_total", "counter", "Metrics pages served." );
+    writer.value( "rosco_scrapes_total", static_cast<double>( m_iScrapes ) );
+
+    if( memoryUsage( iVirtual, iResident ) )
+    {
+        writer.family( "rosco_virtual_memory_bytes", "gauge", "Virtual memory size." );
+        writer.value( "rosco_virtual_memory_bytes", static_cast<double>( iVirtual ) );
+        writer.family( "rosco_resident_memory_bytes", "gauge", "Resident memory size." );
+        writer.value( "rosco_resident_memory_bytes", static_cast<double>( iResident ) );
+    }
+
+    foreach( const MetricsSource *pSource, m_sources )
+        pSource->metrics( writer );
+
+    return qbaPage;
+}
+
+
+// Virtual and resident size of the process from the kernel (Linux and Android only)
+bool MetricsServer::memoryUsage( qint64 &iVirtual, qint64 &iResident )
+{
+#if defined( Q_OS_LINUX )
+    QFile statm( "/proc/self/statm" );
+
+    if( !statm.open( QIODevice::ReadOnly ) )
+        return false;
+
+    QList<QByteArray> pages( statm.readAll().simplified().split( ' ' ) );
+    qint64            iPageSize = static_cast<qint64>( sysconf( _SC_PAGESIZE ) );
+
+    if( pages.count() < 2 )
+        return false;
+
+    iVirtual = pages.at( 0 ).toLongLong() * iPageSize;
+    iResident = pages.at( 1 ).toLongLong() * iPageSize;
+
+    return true;
+#else
+    iVirtual = 0;
+    iResident = 0;
+
+    return false;
+#endif
+}
@@ -0,0 +1,301 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <string.h>
+#include <math.h>
+
+#include "NexradCache.h"
+
+
+#define MaxTiles       8192         // Most blocks held at once
+#define MaxTileAge     900000       // Blocks not refreshed in this long (milliseconds) are dropped
+#define ExpireInterval 10000        // How often (milliseconds) to look for old blocks
+#define RasterSize     256          // Raster width and height in pixels
+#define RecenterFactor 0.25         // Rebuild the raster once ownship is this fraction of the range from its centre
+#define RadarAlpha     160
+
+
+NexradCache::NexradCache()
+    : m_raster( RasterSize, RasterSize, QImage::Format_ARGB32_Premultiplied ),
+      m_bCentered( false ),
+      m_bRegional( false ),
+      m_iLastRegional( 0 ),
+      m_iLastExpire( 0 ),
+      m_dCenterLat( 0.0 ),
+      m_dCenterLong( 0.0 ),
+      m_dLongScale( 1.0 ),
+      m_dRangeNM( 0.0 )
+{
+    // Levels 0 and 1 are no echo (or too light to matter) and clear whatever was there before
+    m_colors[0] = 0;
+    m_colors[1] = 0;
+    m_colors[2] = qPremultiply( qRgba( 0, 140, 0, RadarAlpha ) );
+    m_colors[3] = qPremultiply( qRgba( 0, 220, 0, RadarAlpha ) );
+    m_colors[4] = qPremultiply( qRgba( 255, 255, 0, RadarAlpha ) );
+    m_colors[5] = qPremultiply( qRgba( 255, 140, 0, RadarAlpha ) );
+    m_colors[6] = qPremultiply( qRgba( 255, 0, 0, RadarAlpha ) );
+    m_colors[7] = qPremultiply( qRgba( 255, 0, 255, RadarAlpha ) );
+
+    m_raster.fill( 0 );
+    m_index.reserve( MaxTiles );
+}
+
+
+// Add or replace a block and draw it into the raster if it's one being displayed
+void NexradCache::add( const NexradBlock &block, qint64 iReceived )
+{
+    quint32 uiKey = static_cast<quint32>( block.iBlock ) |
+                    (block.bSouth ? 0x100000 : 0) |
+                    (static_cast<quint32>( block.iScale & 0x03 ) << 21) |
+                    (block.bCONUS ? 0x800000 : 0);
+    int     iTile = m_index.value( uiKey, -1 );
+
+    if( iTile < 0 )
+    {
+        // Out of room so make some by dropping the block that's gone longest without an update
+        if( m_tiles.count() >= MaxTiles )
+        {
+            int iOldest = 0;
+
+            for( int i = 1; i < m_tiles.count(); i++ )
+            {
+                if( m_tiles.at( i ).iReceived < m_tiles.at( iOldest ).iReceived )
+                    iOldest = i;
+            }
+            remove( iOldest );
+        }
+        iTile = m_tiles.count();
+        m_tiles.resize( iTile + 1 );
+        m_index.insert( uiKey, iTile );
+    }
+
+    Tile &tile = m_tiles[iTile];
+
+    tile.uiKey = uiKey;
+    tile.iReceived = iReceived;
+    tile.bCONUS = block.bCONUS;
+    memcpy( tile.bins, block.bins, sizeof( tile.bins ) );
+    FISBDecoder::blockLocation( block.iBlock, block.bSouth, block.iScale, tile.dLatN, tile.dLongW, tile.dLatSize, tile.dLongSize );
+
+    if( !block.bCONUS )
+    {
+        m_iLastRegional = iReceived;
+        if( !m_bRegional )
+        {
+            m_bRegional = true;
+            recomposite();
+            return;
+        }
+    }
+
+    if( m_bCentered && (tile.bCONUS != m_bRegional) )
+        rasterize( tile );
+}
+
+
+// Centre the raster on ownship; it's only rebuilt when this is far enough from where it was built
+void NexradCache::setView( double dLat, double dLong, double dRangeNM )
+{
+    double dX, dY;
+
+    if( m_bCentered && (fabs( dRangeNM - m_dRangeNM ) < (m_dRangeNM * 0.01)) )
+    {
+        offset( dLat, dLong, dX, dY );
+        if( ((dX * dX) + (dY * dY)) < (m_dRangeNM * m_dRangeNM * RecenterFactor * RecenterFactor) )
+            return;
+    }
+
+    m_dCenterLat = dLat;
+    m_dCenterLong = dLong;
+    m_dLongScale = cos( dLat * 0.017453292519943296 );
+    m_dRangeNM = dRangeNM;
+    m_bCentered = true;
+    recomposite();
+}
+
+
+// Drop blocks that haven't been refreshed recently and go back to CONUS if the regional composite stops
+// Returns true if the raster changed.
+bool NexradCache::expire( qint64 iNow )
+{
+    bool bChanged = false;
+
+    if( (iNow - m_iLastExpire) < ExpireInterval )
+        return false;
+    m_iLastExpire = iNow;
+
+    for( int i = m_tiles.count() - 1; i >= 0; i-- )
+    {
+        if( (iNow - m_tiles.at( i ).iReceived) > MaxTileAge )
+        {
+            if( m_tiles.at( i ).bCONUS != m_bRegional )
+                bChanged = true;
+            remove( i );
+        }
+    }
+    if( m_bRegional && ((iNow - m_iLastRegional) > MaxTileAge) )
+    {
+        m_bRegional = false;
+        bChanged = true;
+    }
+
+    if( bChanged )
+        recomposite();
+
+    return bChanged && m_bCentered;
+}
+
+
+// Throw out every block
+void NexradCache::clear()
+{
+    m_index.clear();
+    m_tiles.clear();
+    m_bRegional = false;
+    m_iLastRegional = 0;
+    m_raster.fill( 0 );
+}
+
+
+// Nautical miles east and north from a position to the centre of the raster
+void NexradCache::offset( double dLat, double dLong, double &dX, double &dY ) const
+{
+    double dLongDiff = m_dCenterLong - dLong;
+
+    if( dLongDiff >= 180.0 )
+        dLongDiff -= 360.0;
+    else if( dLongDiff < -180.0 )
+        dLongDiff += 360.0;
+    dX = dLongDiff * 60.0 * m_dLongScale;
+    dY = (m_dCenterLat - dLat) * 60.0;
+}
+
+
+// Turn the part of the raster that falls on a round dial centred on ownship to the heading the dial is drawn at
+// The dial image is square with the dial filling it; everything inside the circle is written each time and
+// everything outside it is left alone so it stays clear, which lets the result go to the screen as a plain blit
+// with no clip. Pixels are sampled nearest-neighbour stepping along each row, the same as the painter's own
+// transformed image drawing without smoothing.
+void NexradCache::drawDial( QImage &dial, double dLat, double dLong, double dHeading, double dPixPerNM ) const
+{
+    double dRadius = dial.width() / 2.0;
+    double dSin = sin( dHeading * 0.017453292519943296 );
+    double dCos = cos( dHeading * 0.017453292519943296 );
+    double dRasterScale = RasterSize / (2.0 * m_dRangeNM);
+    double dStepX = dCos / dPixPerNM * dRasterScale;    // Raster pixels moved for each dial pixel along a row
+    double dStepY = dSin / dPixPerNM * dRasterScale;
+    double dCenterX, dCenterY, dDialX, dDialY, dHalf, dX, dY;
+    int    iFirst, iLast, iCol, iRow;
+    QRgb  *pLine;
+
+    offset( dLat, dLong, dCenterX, dCenterY );
+    for( int y = 0; y < dial.height(); y++ )
+    {
+        dDialY = y + 0.5 - dRadius;
+        dHalf = (dRadius * dRadius) - (dDialY * dDialY);
+        if( dHalf <= 0.0 )
+            continue;
+        dHalf = sqrt( dHalf );
+        iFirst = qMax( 0, static_cast<int>( ceil( dRadius - dHalf - 0.5 ) ) );
+        iLast = qMin( dial.width() - 1, static_cast<int>( floor( dRadius + dHalf - 0.5 ) ) );
+
+        // Dial pixels are turned back to NM east and south of ownship and then into the raster, which has its top row north
+        dDialX = iFirst + 0.5 - dRadius;
+        dX = ((((dCos * dDialX) - (dSin * dDialY)) / dPixPerNM) - dCenterX + m_dRangeNM) * dRasterScale;
+        dY = ((((dSin * dDialX) + (dCos * dDialY)) / dPixPerNM) + dCenterY + m_dRangeNM) * dRasterScale;
+        pLine = reinterpret_cast<QRgb *>( dial.scanLine( y ) );
+        for( int x = iFirst; x <= iLast; x++ )
+        {
+            iCol = static_cast<int>( floor( dX ) );
+            iRow = static_cast<int>( floor( dY ) );
+            if( (iCol >= 0) && (iCol < RasterSize) && (iRow >= 0) && (iRow < RasterSize) )
+                pLine[x] = reinterpret_cast<const QRgb *>( m_raster.constScanLine( iRow ) )[iCol];
+            else
+                pLine[x] = 0;
+            dX += dStepX;
+            dY += dStepY;
+        }
+    }
+}
+
+
+// Redraw the raster from every block of the composite being displayed
+void NexradCache::recomposite()
+{
+    m_raster.fill( 0 );
+    if( !m_bCentered )
+        return;
+
+    for( int i = 0; i < m_tiles.count(); i++ )
+    {
+        if( m_tiles.at( i ).bCONUS != m_bRegional )
+            rasterize( m_tiles.at( i ) );
+    }
+}
+
+
+// Write the bins of one block straight into the raster scanlines
+// Empty bins are written too so a block that cleared up erases what it used to show.
+void NexradCache::rasterize( const Tile &tile )
+{
+    double dPixPerNM = RasterSize / (2.0 * m_dRangeNM);
+    double dLongDiff = tile.dLongW - m_dCenterLong;
+    double dLeft, dTop, dBinWidth, dBinHeight;
+    int    colEdges[NEXRAD_BINS_X + 1];
+    int    iRowTop, iRowBottom, iCol;
+    QRgb  *pLine;
+
+    if( dLongDiff >= 180.0 )
+        dLongDiff -= 360.0;
+    else if( dLongDiff < -180.0 )
+        dLongDiff += 360.0;
+
+    dLeft = (RasterSize / 2.0) + (dLongDiff * 60.0 * m_dLongScale * dPixPerNM);
+    dTop = (RasterSize / 2.0) - ((tile.dLatN - m_dCenterLat) * 60.0 * dPixPerNM);
+    dBinWidth = tile.dLongSize * 60.0 * m_dLongScale * dPixPerNM / NEXRAD_BINS_X;
+    dBinHeight = tile.dLatSize * 60.0 * dPixPerNM / NEXRAD_BINS_Y;
+
+    // Nothing to do for the vast majority of blocks that are nowhere near ownship
+    if( (dLeft >= RasterSize) || ((dLeft + (dBinWidth * NEXRAD_BINS_X)) <= 0.0) ||
+        (dTop >= RasterSize) || ((dTop + (dBinHeight * NEXRAD_BINS_Y)) <= 0.0) )
+        return;
+
+    for( int x = 0; x <= NEXRAD_BINS_X; x++ )
+        colEdges[x] = qBound( 0, static_cast<int>( floor( dLeft + (dBinWidth * x) + 0.5 ) ), RasterSize );
+
+    for( int y = 0; y < NEXRAD_BINS_Y; y++ )
+    {
+        const uchar *pBins = tile.bins + (y * NEXRAD_BINS_X);
+
+        iRowTop = qBound( 0, static_cast<int>( floor( dTop + (dBinHeight * y) + 0.5 ) ), RasterSize );
+        iRowBottom = qBound( 0, static_cast<int>( floor( dTop + (dBinHeight * (y + 1)) + 0.5 ) ), RasterSize );
+        for( int iRow = iRowTop; iRow < iRowBottom; iRow++ )
+        {
+            pLine = reinterpret_cast<QRgb *>( m_raster.scanLine( iRow ) );
+            for( int x = 0; x < NEXRAD_BINS_X; x++ )
+            {
+                QRgb color = m_colors[pBins[x] & 0x07];
+
+                for( iCol = colEdges[x]; iCol < colEdges[x + 1]; iCol++ )
+                    pLine[iCol] = color;
+            }
+        }
+    }
+}
+
+
+// Remove a block by moving the last one into its slot
+void NexradCache::remove( int iTile )
+{
+    int iLast = m_tiles.count() - 1;
+
+    m_index.remove( m_tiles.at( iTile ).uiKey );
+    if( iTile != iLast )
+    {
+        m_tiles[iTile] = m_tiles.at( iLast );
+        m_index.insert( m_tiles.at( iTile ).uiKey, iTile );
+    }
+    m_tiles.resize( iLast );
+}
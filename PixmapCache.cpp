@@ -0,0 +1,174 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QPixmap>
+#include <QImage>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDir>
+#include <QStringList>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+
+#include <utility>
+
+#include "PixmapCache.h"
+#include "Canvas.h"
+#include "Builder.h"
+
+
+extern bool g_bEmulated;
+
+
+#define PIXMAP_CACHE_MAGIC 0x43585052   // "RPXC"
+
+
+// Fixed header at the start of each cache file; the premultiplied ARGB32 scanlines follow immediately.
+// It's exactly five 32 bit words so the pixel data that follows stays 32 bit aligned in the mapped file.
+struct PixmapCacheHeader
+{
+    quint32 uiMagic;
+    quint32 uiVersion;
+    qint32  iWidth;
+    qint32  iHeight;
+    qint32  iBytesPerLine;
+};
+
+
+// Called by QImage once nothing references the mapped pixels anymore; deleting the file unmaps it
+static void unmapCachedImage( void *pInfo )
+{
+    delete static_cast<QFile *>( pInfo );
+}
+
+
+// Build the cache key from everything that changes what the Builder produces
+PixmapCache::PixmapCache( Canvas *pCanvas, int iDPI, double dPixelRatio )
+    : m_qsCacheDir( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + "/pixmaps" )
+{
+    CanvasConstants    c = pCanvas->contants();
+    QCryptographicHash keyHash( QCryptographicHash::Md5 );
+    QString            qsKeySource = QString( "%1x%2 %3dpi %4x %5/%6/%7/%8/%9" )
+                                         .arg( static_cast<int>( c.dW ) )
+                                         .arg( static_cast<int>( c.dH ) )
+                                         .arg( iDPI )
+                                         .arg( dPixelRatio )
+                                         .arg( c.iTinyFontHeight )
+                                         .arg( c.iSmallFontHeight )
+                                         .arg( c.iMedFontHeight )
+                                         .arg( c.iLargeFontHeight )
+                                         .arg( c.iTinyFontWidth );
+
+    qsKeySource += QString( " v%1 %2" ).arg( BUILDER_VERSION ).arg( g_bEmulated ? "emulated" : "device" );
+    keyHash.addData( qsKeySource.toUtf8() );
+    m_qsKey = QString( keyHash.result().toHex().left( 16 ) );
+}
+
+
+// Load a cached pixmap by memory mapping the cache file
+// The pixmap must already be created at the size the caller expects; a size mismatch is treated as a miss.
+bool PixmapCache::load( const QString &qsName, QPixmap *pPixmap )
+{
+    QFile *pFile = new QFile( fileName( qsName ) );
+
+    if( !pFile->open( QIODevice::ReadOnly ) )
+    {
+        delete pFile;
+        return false;
+    }
+
+    qint64                   iSize = pFile->size();
+    uchar                   *pData = 0;
+    const PixmapCacheHeader *pHeader = 0;
+
+    if( iSize > static_cast<qint64>( sizeof( PixmapCacheHeader ) ) )
+        pData = pFile->map( 0, iSize );
+    if( pData == 0 )
+    {
+        delete pFile;
+        return false;
+    }
+
+    pHeader = reinterpret_cast<const PixmapCacheHeader *>( pData );
+    if( (pHeader->uiMagic != PIXMAP_CACHE_MAGIC) ||
+        (pHeader->uiVersion != BUILDER_VERSION) ||
+        (pHeader->iWidth != pPixmap->width()) ||
+        (pHeader->iHeight != pPixmap->height()) ||
+        (pHeader->iBytesPerLine < (pHeader->iWidth * 4)) ||
+        (iSize != static_cast<qint64>( sizeof( PixmapCacheHeader ) ) + (static_cast<qint64>( pHeader->iBytesPerLine ) * pHeader->iHeight)) )
+    {
+        delete pFile;
+        return false;
+    }
+
+    // The image reads straight out of the mapping and takes ownership of the file so it stays mapped
+    // for as long as the pixmap still refers to the pixels. It's handed over as read-only data so the first
+    // thing to paint into the pixmap gets its own copy rather than writing to the (read-only) mapping.
+    QImage cachedImage( static_cast<const uchar *>( pData + sizeof( PixmapCacheHeader ) ),
+                        pHeader->iWidth,
+                        pHeader->iHeight,
+                        pHeader->iBytesPerLine,
+                        QImage::Format_ARGB32_Premultiplied,
+                        unmapCachedImage,
+                        pFile );
+
+    // Moving the image in lets a raster pixmap adopt it as is (the format already matches) instead of
+    // copying the pixels, so the mapping itself stays the backing store.
+    *pPixmap = QPixmap::fromImage( std::move( cachedImage ) );
+
+    return (!pPixmap->isNull());
+}
+
+
+// Write a freshly built pixmap to the cache and throw out any entries it replaces
+void PixmapCache::save( const QString &qsName, const QPixmap *pPixmap )
+{
+    QImage            image( pPixmap->toImage().convertToFormat( QImage::Format_ARGB32_Premultiplied ) );
+    PixmapCacheHeader header;
+
+    if( image.isNull() || (!QDir().mkpath( m_qsCacheDir )) )
+        return;
+
+    purge( qsName );
+
+    header.uiMagic = PIXMAP_CACHE_MAGIC;
+    header.uiVersion = BUILDER_VERSION;
+    header.iWidth = image.width();
+    header.iHeight = image.height();
+    header.iBytesPerLine = image.bytesPerLine();
+
+    // QSaveFile only replaces the old file on commit so a partially written entry is never seen
+    QSaveFile cacheFile( fileName( qsName ) );
+
+    if( !cacheFile.open( QIODevice::WriteOnly ) )
+        return;
+    cacheFile.write( reinterpret_cast<const char *>( &header ), sizeof( PixmapCacheHeader ) );
+    cacheFile.write( reinterpret_cast<const char *>( image.constBits() ), static_cast<qint64>( image.bytesPerLine() ) * image.height() );
+    cacheFile.commit();
+}
+
+
+// Full path of the cache file for this pixmap and key
+QString PixmapCache::fileName( const QString &qsName )
+{
+    return QString( "%1/%2-%3.pxc" ).arg( m_qsCacheDir ).arg( qsName ).arg( m_qsKey );
+}
+
+
+// Remove entries for this pixmap built for some other geometry or builder version so the cache doesn't grow forever
+void PixmapCache::purge( const QString &qsName )
+{
+    QDir        cacheDir( m_qsCacheDir );
+    QStringList qslStale( cacheDir.entryList( QStringList() << QString( "%1-*.pxc" ).arg( qsName ), QDir::Files ) );
+    QString     qsCurrent( QFileInfo( fileName( qsName ) ).fileName() );
+    QString     qsStale;
+
+    foreach( qsStale, qslStale )
+    {
+        if( qsStale != qsCurrent )
+            cacheDir.remove( qsStale );
+    }
+}
@@ -0,0 +1,373 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QPainter>
+#include <QFile>
+#include <QTextStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "RenderHarness.h"
+#include "StringTable.h"
+#include "AllocCounter.h"
+
+
+#define BaseTime          1530000000000LL   // Fixed start of the scenario clock in ms since the epoch
+#define SituationInterval 100               // Synthetic AHRS/GPS rate in ms
+#define TrafficInterval   1000              // Synthetic traffic rate in ms
+#define SyntheticTargets  12
+#define AttitudeHorizon   100               // Fixed so the frames don't depend on the configured lead
+#define ToRad             0.017453292519943296
+
+
+RenderHarness::RenderHarness( const Options &options )
+    : m_options( options ),
+      m_reader( 0 ),
+      m_iNextRecord( 0 ),
+      m_iNextSituation( 0 ),
+      m_iNextTraffic( 0 )
+{
+    QObject::connect( &m_reader, SIGNAL( newSituation( SituationSnapshot ) ), &m_canvas, SLOT( situation( SituationSnapshot ) ) );
+    QObject::connect( &m_reader, SIGNAL( newTraffic( TrafficSnapshot ) ), &m_canvas, SLOT( traffic( TrafficSnapshot ) ) );
+    QObject::connect( &m_reader, SIGNAL( newWeather( WeatherSnapshot ) ), &m_canvas, SLOT( weather( WeatherSnapshot ) ) );
+}
+
+
+void RenderHarness::defaultOptions( Options &options )
+{
+    options.iWidth = 733;
+    options.iHeight = 1100;
+    options.iFrames = 200;
+    options.iFrameMs = 50;
+    options.iTolerance = 0;
+    options.iAllocBudget = AllocCounter::isEnabled() ? 0 : -1;
+    options.qsScenario.clear();
+    options.qsOutDir.clear();
+    options.qsGoldenDir.clear();
+}
+
+
+// Render every frame and report; returns the process exit code (1 if any frame didn't match its golden image,
+// 3 if any frame past the warm-up went over the allocation budget)
+int RenderHarness::run()
+{
+    QImage          frame( m_options.iWidth, m_options.iHeight, QImage::Format_ARGB32_Premultiplied );
+    QElapsedTimer   frameTime;
+    QVector<double> frameMs;
+    int             iFrame, iMismatches = 0, iMaxDiff, iDiffPixels, iOverBudget = 0;
+    qint64          iTime, iAllocs;
+    qint64          iSteadyAllocs = 0, iMaxSteadyAllocs = 0;
+    QString         qsName;
+    double          dTotal = 0.0;
+    bool            bCountAllocs = AllocCounter::isEnabled();
+
+    if( (!m_options.qsScenario.isEmpty()) && (!loadScenario()) )
+    {
+        fprintf( stderr, "Unable to read scenario %s\n", qPrintable( m_options.qsScenario ) );
+        return 2;
+    }
+    if( (!m_options.qsOutDir.isEmpty()) && (!QDir().mkpath( m_options.qsOutDir )) )
+    {
+        fprintf( stderr, "Unable to create %s\n", qPrintable( m_options.qsOutDir ) );
+        return 2;
+    }
+    if( (m_options.iAllocBudget >= 0) && (!bCountAllocs) )
+    {
+        fprintf( stderr, "Allocation budget needs a build with CONFIG+=alloc_tracking\n" );
+        return 2;
+    }
+
+    // The canvas is never shown; it just needs its size to build its pixmaps
+    m_canvas.setClock( BaseTime );
+    m_canvas.setAttitudeHorizon( AttitudeHorizon );
+    m_canvas.resize( m_options.iWidth, m_options.iHeight );
+    m_canvas.init();
+
+    frameMs.reserve( m_options.iFrames );
+    m_frameAllocs.clear();
+    m_frameAllocs.reserve( m_options.iFrames );
+    for( iFrame = 0; iFrame < m_options.iFrames; iFrame++ )
+    {
+        iTime = static_cast<qint64>( iFrame ) * m_options.iFrameMs;
+        feed( iTime );
+        m_canvas.setClock( BaseTime + iTime );
+
+        frame.fill( Qt::black );
+        frameTime.start();
+        {
+            QPainter ahrs( &frame );
+
+            // Only the frame itself is counted for allocations; the painter setup and teardown are the same every time
+            iAllocs = AllocCounter::count();
+            m_canvas.paintFrame( &ahrs );
+            iAllocs = AllocCounter::count() - iAllocs;
+        }
+        frameMs.append( frameTime.nsecsElapsed() / 1.0e6 );
+        m_frameAllocs.append( iAllocs );
+        dTotal += frameMs.last();
+
+        fprintf( stdout, "frame %4d %8.3f ms", iFrame, frameMs.last() );
+        if( bCountAllocs )
+        {
+            fprintf( stdout, " %6lld allocs", iAllocs );
+            if( iFrame >= ALLOC_WARMUP_FRAMES )
+            {
+                iSteadyAllocs += iAllocs;
+                iMaxSteadyAllocs = qMax( iMaxSteadyAllocs, iAllocs );
+                if( (m_options.iAllocBudget >= 0) && (iAllocs > m_options.iAllocBudget) )
+                {
+                    iOverBudget++;
+                    fprintf( stdout, "  OVER BUDGET" );
+                }
+            }
+        }
+
+        qsName = QString( "frame_%1.png" ).arg( iFrame, 4, 10, QChar( '0' ) );
+        if( !m_options.qsOutDir.isEmpty() )
+            frame.save( m_options.qsOutDir + "/" + qsName );
+        if( !m_options.qsGoldenDir.isEmpty() )
+        {
+            iDiffPixels = compare( frame, qsName, iMaxDiff );
+            if( iDiffPixels < 0 )
+                fprintf( stdout, "  no golden image" );
+            else if( iDiffPixels > 0 )
+                fprintf( stdout, "  MISMATCH %d pixels, max difference %d", iDiffPixels, iMaxDiff );
+            if( iDiffPixels != 0 )
+                iMismatches++;
+        }
+        fprintf( stdout, "\n" );
+    }
+
+    // Summary over all frames
+    if( !frameMs.isEmpty() )
+    {
+        QVector<double> sorted( frameMs );
+
+        std::sort( sorted.begin(), sorted.end() );
+        fprintf( stdout, "%d frames at %dx%d: mean %.3f ms, median %.3f ms, 95%% %.3f ms, 99%% %.3f ms, max %.3f ms\n",
+                 sorted.count(),
+                 m_options.iWidth,
+                 m_options.iHeight,
+                 dTotal / sorted.count(),
+                 sorted.at( sorted.count() / 2 ),
+                 sorted.at( (sorted.count() * 95) / 100 ),
+                 sorted.at( (sorted.count() * 99) / 100 ),
+                 sorted.last() );
+    }
+    if( bCountAllocs && (frameMs.count() > ALLOC_WARMUP_FRAMES) )
+    {
+        fprintf( stdout, "allocations per frame after %d warm-up frames: mean %.1f, max %lld\n",
+                 ALLOC_WARMUP_FRAMES,
+                 static_cast<double>( iSteadyAllocs ) / (frameMs.count() - ALLOC_WARMUP_FRAMES),
+                 iMaxSteadyAllocs );
+        if( m_options.iAllocBudget >= 0 )
+            fprintf( stdout, "%d frames over the budget of %d allocations\n", iOverBudget, m_options.iAllocBudget );
+    }
+    if( !m_options.qsGoldenDir.isEmpty() )
+        fprintf( stdout, "%d of %d frames differ from %s\n", iMismatches, frameMs.count(), qPrintable( m_options.qsGoldenDir ) );
+    fflush( stdout );
+
+    if( iMismatches > 0 )
+        return 1;
+
+    return (iOverBudget > 0) ? 3 : 0;
+}
+
+
+// Heap allocations made painting each frame of the last run, warm-up frames included; all zero unless
+// allocation tracking is compiled in
+const QVector<qint64> &RenderHarness::frameAllocs() const
+{
+    return m_frameAllocs;
+}
+
+
+// Read a recorded session into memory so file reads don't land in the frame loop
+bool RenderHarness::loadScenario()
+{
+    QFile       scenario( m_options.qsScenario );
+    QString     qsLine;
+    QStringList qslParts;
+    Record      record;
+
+    if( !scenario.open( QIODevice::ReadOnly | QIODevice::Text ) )
+        return false;
+
+    QTextStream in( &scenario );
+
+    while( !in.atEnd() )
+    {
+        qsLine = in.readLine().trimmed();
+        if( qsLine.isEmpty() || qsLine.startsWith( '#' ) )
+            continue;
+
+        qslParts = qsLine.split( ' ' );
+        if( qslParts.count() < 3 )
+            continue;
+
+        record.iTime = qslParts.at( 0 ).toLongLong();
+        if( qslParts.at( 1 ) == "situation" )
+            record.eEndpoint = AHRS::SituationEndpoint;
+        else if( qslParts.at( 1 ) == "traffic" )
+            record.eEndpoint = AHRS::TrafficEndpoint;
+        else if( qslParts.at( 1 ) == "status" )
+            record.eEndpoint = AHRS::StatusEndpoint;
+        else if( qslParts.at( 1 ) == "weather" )
+            record.eEndpoint = AHRS::WeatherEndpoint;
+        else
+            continue;
+        record.qsMessage = qsLine.section( ' ', 2 );
+        m_records.append( record );
+    }
+
+    return true;
+}
+
+
+// Hand the canvas everything due up to this point in the scenario, each at its own time
+void RenderHarness::feed( qint64 iTime )
+{
+    if( m_options.qsScenario.isEmpty() )
+    {
+        while( m_iNextSituation <= iTime )
+        {
+            m_canvas.setClock( BaseTime + m_iNextSituation );
+            syntheticSituation( m_iNextSituation );
+            m_iNextSituation += SituationInterval;
+        }
+        while( m_iNextTraffic <= iTime )
+        {
+            m_canvas.setClock( BaseTime + m_iNextTraffic );
+            syntheticTraffic( m_iNextTraffic );
+            m_iNextTraffic += TrafficInterval;
+        }
+    }
+    else
+    {
+        while( (m_iNextRecord < m_records.count()) && (m_records.at( m_iNextRecord ).iTime <= iTime) )
+        {
+            const Record &record = m_records.at( m_iNextRecord );
+
+            m_canvas.setClock( BaseTime + record.iTime );
+            m_reader.inject( record.eEndpoint, record.qsMessage );
+            m_iNextRecord++;
+        }
+    }
+}
+
+
+// A standard rate turn with a gentle climb and some roll and pitch wobble on top
+void RenderHarness::syntheticSituation( qint64 iTime )
+{
+    StratuxSituation *pSituation = new StratuxSituation;
+    double            dSecs = iTime / 1000.0;
+    double            dHeading = fmod( 90.0 + (3.0 * dSecs), 360.0 );
+
+    StreamReader::initSituation( *pSituation );
+    pSituation->dGPSlat = 45.0 + (dSecs * 0.0005);
+    pSituation->dGPSlong = -93.0 + (dSecs * 0.0005);
+    pSituation->iGPSFixQuality = 1;
+    pSituation->iGPSSats = 9;
+    pSituation->dGPSAltMSL = 4500.0 + (dSecs * 5.0);
+    pSituation->dGPSTrueCourse = dHeading;
+    pSituation->dGPSGroundSpeed = 110.0;
+    pSituation->dGPSVertSpeed = 5.0;
+    pSituation->dBaroPressAlt = pSituation->dGPSAltMSL;
+    pSituation->dBaroVertSpeed = 300.0;
+    pSituation->dAHRSroll = 20.0 + (5.0 * sin( dSecs * 0.9 ));
+    pSituation->dAHRSpitch = 3.0 + (2.0 * sin( dSecs * 0.5 ));
+    pSituation->dAHRSGyroHeading = dHeading;
+    pSituation->dAHRSMagHeading = dHeading;
+    pSituation->dAHRSSlipSkid = 10.0 * sin( dSecs * 0.3 );
+    pSituation->dAHRSTurnRate = 3.0;
+    pSituation->dAHRSGLoad = 1.06;
+    pSituation->dAHRSGLoadMin = 0.9;
+    pSituation->dAHRSGLoadMax = 1.2;
+    pSituation->iAHRSStatus = 1;
+    pSituation->uiChanged = AHRS::AllChanged;
+
+    m_canvas.situation( SituationSnapshot( pSituation ) );
+}
+
+
+// Targets on circles of different sizes around ownship at a spread of relative altitudes
+void RenderHarness::syntheticTraffic( qint64 iTime )
+{
+    TrafficBatch        *pBatch = new TrafficBatch;
+    StratuxTrafficUpdate update;
+    double               dSecs = iTime / 1000.0;
+    double               dOwnLat = 45.0 + (dSecs * 0.0005);
+    double               dOwnLong = -93.0 + (dSecs * 0.0005);
+    double               dBearing;
+    int                  i;
+
+    for( i = 0; i < SyntheticTargets; i++ )
+    {
+        StratuxTraffic &t = update.traffic;
+
+        StreamReader::initTraffic( t );
+        dBearing = fmod( (i * 30.0) + (dSecs * (2.0 + i)), 360.0 );
+        update.iICAO = 0xA00000 + i;
+        t.fDist = static_cast<float>( 2.0 + (i * 1.5) );
+        t.fBearing = static_cast<float>( dBearing );
+        t.dLat = dOwnLat + (t.fDist * cos( dBearing * ToRad ) / 60.0);
+        t.dLong = dOwnLong + (t.fDist * sin( dBearing * ToRad ) / (60.0 * cos( dOwnLat * ToRad )));
+        t.fAlt = static_cast<float>( 4500.0 + (dSecs * 5.0) + ((i - (SyntheticTargets / 2)) * 500.0) );
+        t.fTrack = static_cast<float>( fmod( dBearing + 90.0, 360.0 ) );
+        t.fSpeed = static_cast<float>( 90.0 + (i * 10.0) );
+        t.fVertSpeed = static_cast<float>( (i % 3 - 1) * 500 );
+        t.iSquawk = 1200 + i;
+        t.iReg = StringTable::intern( QString( "N%1RS" ).arg( 100 + i ) );
+        t.iTail = t.iReg;
+        t.fAge = 0.0f;
+        t.iLastSeen = BaseTime + iTime;
+        t.iTimestamp = BaseTime + iTime;
+        t.bPosValid = true;
+        t.bHasADSB = true;
+        pBatch->append( update );
+    }
+
+    m_canvas.traffic( TrafficSnapshot( pBatch ) );
+}
+
+
+// Count the pixels that differ from the golden image by more than the tolerance in any channel
+// Returns -1 if there's no golden image of the same size to compare against.
+int RenderHarness::compare( const QImage &frame, const QString &qsName, int &iMaxDiff )
+{
+    QImage golden( m_options.qsGoldenDir + "/" + qsName );
+    int    x, y, iDiff, iPixels = 0;
+
+    iMaxDiff = 0;
+    if( golden.isNull() || (golden.size() != frame.size()) )
+        return -1;
+    golden = golden.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+
+    for( y = 0; y < frame.height(); y++ )
+    {
+        const QRgb *pFrame = reinterpret_cast<const QRgb *>( frame.constScanLine( y ) );
+        const QRgb *pGolden = reinterpret_cast<const QRgb *>( golden.constScanLine( y ) );
+
+        for( x = 0; x < frame.width(); x++ )
+        {
+            if( pFrame[x] == pGolden[x] )
+                continue;
+
+            iDiff = qMax( qMax( qAbs( qRed( pFrame[x] ) - qRed( pGolden[x] ) ), qAbs( qGreen( pFrame[x] ) - qGreen( pGolden[x] ) ) ),
+                          qMax( qAbs( qBlue( pFrame[x] ) - qBlue( pGolden[x] ) ), qAbs( qAlpha( pFrame[x] ) - qAlpha( pGolden[x] ) ) ) );
+            if( iDiff > iMaxDiff )
+                iMaxDiff = iDiff;
+            if( iDiff > m_options.iTolerance )
+                iPixels++;
+        }
+    }
+
+    return iPixels;
+}
@@ -16,6 +16,11 @@ TEMPLATE = app
 DEFINES += QT_DEPRECATED_WARNINGS \
            QT_AUTO_SCREEN_SCALE_FACTOR
 
+# Count heap allocations (qmake CONFIG+=alloc_tracking) for finding paint code that allocates every frame
+alloc_tracking {
+    DEFINES += ALLOC_TRACKING
+}
+
 INCLUDEPATH += ./include
 
 VPATH += ./include \
@@ -31,7 +36,29 @@ SOURCES += \
     TrafficMath.cpp \
     Canvas.cpp \
     MenuDialog.cpp \
-    Builder.cpp
+    Builder.cpp \
+    PixmapCache.cpp \
+    GlyphAtlas.cpp \
+    TrafficStore.cpp \
+    AttitudePredictor.cpp \
+    TrafficTrails.cpp \
+    WeatherStore.cpp \
+    WeatherDecoder.cpp \
+    GDL90Decoder.cpp \
+    GDL90Framer.cpp \
+    FISBDecoder.cpp \
+    NexradCache.cpp \
+    StringTable.cpp \
+    ISOTime.cpp \
+    JsonFields.cpp \
+    StreamQueue.cpp \
+    StreamConnection.cpp \
+    StreamStats.cpp \
+    DiagnosticsDialog.cpp \
+    MetricsServer.cpp \
+    HeadlessPipeline.cpp \
+    RenderHarness.cpp \
+    AllocCounter.cpp
 
 HEADERS += \
     StratuxStreams.h \
@@ -44,13 +71,36 @@ HEADERS += \
     Canvas.h \
     AppDefs.h \
     MenuDialog.h \
-    Builder.h
+    Builder.h \
+    PixmapCache.h \
+    GlyphAtlas.h \
+    TrafficStore.h \
+    AttitudePredictor.h \
+    TrafficTrails.h \
+    WeatherStore.h \
+    WeatherDecoder.h \
+    GDL90Decoder.h \
+    GDL90Framer.h \
+    FISBDecoder.h \
+    NexradCache.h \
+    StringTable.h \
+    ISOTime.h \
+    JsonFields.h \
+    StreamQueue.h \
+    StreamConnection.h \
+    StreamStats.h \
+    DiagnosticsDialog.h \
+    MetricsServer.h \
+    HeadlessPipeline.h \
+    RenderHarness.h \
+    AllocCounter.h
 
 FORMS += \
     AHRSMainWin.ui \
     BugSelector.ui \
     Keypad.ui \
-    MenuDialog.ui
+    MenuDialog.ui \
+    DiagnosticsDialog.ui
 
 CONFIG += mobility
 MOBILITY = 
@@ -0,0 +1,236 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QRandomGenerator>
+
+#include "StreamConnection.h"
+
+
+#define FirstBackoff    250         // Milliseconds before the second attempt; the first is immediate
+#define MaxBackoff      5000
+#define PingInterval    1000
+#define LivenessTimeout 3000        // Nothing heard for this long means the connection is dead
+#define ConnectTimeout  1000        // An attempt that hasn't connected in this long is aborted and retried
+
+
+StreamConnection::StreamConnection( QObject *parent )
+    : QObject( parent ),
+      m_eState( Closed ),
+      m_iBackoffMs( 0 ),
+      m_bEverConnected( false )
+{
+    m_counters.iConnects = 0;
+    m_counters.iReconnects = 0;
+    m_counters.iFailures = 0;
+    m_counters.iConnectTimeouts = 0;
+    m_counters.iLivenessTimeouts = 0;
+    m_counters.iDuplicateConnects = 0;
+    m_counters.iDowntimeMs = 0;
+    m_counters.iRoundTripMs = 0;
+
+    m_retryTimer.setSingleShot( true );
+    m_connectTimer.setSingleShot( true );
+    m_connectTimer.setInterval( ConnectTimeout );
+    m_livenessTimer.setInterval( PingInterval );
+
+    connect( &m_socket, SIGNAL( connected() ), this, SLOT( socketConnected() ) );
+    connect( &m_socket, SIGNAL( disconnected() ), this, SLOT( socketDisconnected() ) );
+    connect( &m_socket, SIGNAL( error( QAbstractSocket::SocketError ) ), this, SLOT( socketError( QAbstractSocket::SocketError ) ) );
+    connect( &m_socket, SIGNAL( textMessageReceived( const QString& ) ), this, SLOT( messageReceived() ) );
+    connect( &m_socket, SIGNAL( pong( quint64, const QByteArray& ) ), this, SLOT( pongReceived( quint64, const QByteArray& ) ) );
+    connect( &m_retryTimer, SIGNAL( timeout() ), this, SLOT( retry() ) );
+    connect( &m_connectTimer, SIGNAL( timeout() ), this, SLOT( connectTimeout() ) );
+    connect( &m_livenessTimer, SIGNAL( timeout() ), this, SLOT( checkLiveness() ) );
+}
+
+
+// Start connecting and keep the connection up until closed
+void StreamConnection::open( const QUrl &url )
+{
+    if( (m_eState != Closed) && (url == m_url) )
+        return;
+
+    m_url = url;
+    m_iBackoffMs = 0;
+    m_eState = Connecting;
+    m_downSince.start();
+    m_connectTimer.start();
+    m_socket.open( m_url );
+}
+
+
+// Stop wanting the connection
+void StreamConnection::close()
+{
+    bool bWasConnected = (m_eState == Connected);
+
+    if( m_eState == Closed )
+        return;
+
+    if( m_downSince.isValid() )
+    {
+        m_counters.iDowntimeMs += m_downSince.elapsed();
+        m_downSince.invalidate();
+    }
+    m_eState = Closed;
+    m_retryTimer.stop();
+    m_connectTimer.stop();
+    m_livenessTimer.stop();
+    m_socket.close();
+    if( bWasConnected )
+        emit connectionChanged( false );
+}
+
+
+// Connect the text messages to a receiver; the connection is unique so a second attempt for the same slot is
+// refused and counted instead of doubling up every message.
+bool StreamConnection::connectMessages( QObject *pReceiver, const char *szSlot )
+{
+    if( connect( &m_socket, SIGNAL( textMessageReceived( const QString& ) ), pReceiver, szSlot, Qt::UniqueConnection ) )
+        return true;
+
+    m_counters.iDuplicateConnects++;
+
+    return false;
+}
+
+
+// Counters including the outage in progress, if any
+StreamConnection::Counters StreamConnection::counters() const
+{
+    Counters counters = m_counters;
+
+    if( m_downSince.isValid() )
+        counters.iDowntimeMs += m_downSince.elapsed();
+
+    return counters;
+}
+
+
+void StreamConnection::socketConnected()
+{
+    if( m_eState == Closed )
+        return;
+
+    if( m_downSince.isValid() )
+    {
+        m_counters.iDowntimeMs += m_downSince.elapsed();
+        m_downSince.invalidate();
+    }
+    m_counters.iConnects++;
+    if( m_bEverConnected )
+        m_counters.iReconnects++;
+    m_bEverConnected = true;
+    m_iBackoffMs = 0;
+    m_connectTimer.stop();
+    m_eState = Connected;
+    m_lastHeard.start();
+    m_livenessTimer.start();
+
+    emit connectionChanged( true );
+}
+
+
+void StreamConnection::socketDisconnected()
+{
+    // Closed on purpose or already handled by the error that came first
+    if( (m_eState == Closed) || (m_eState == Waiting) )
+        return;
+
+    connectionLost();
+}
+
+
+void StreamConnection::socketError( QAbstractSocket::SocketError eError )
+{
+    Q_UNUSED( eError );
+
+    if( (m_eState == Closed) || (m_eState == Waiting) )
+        return;
+
+    connectionLost();
+}
+
+
+// Anything heard at all counts as the connection being alive
+void StreamConnection::messageReceived()
+{
+    m_lastHeard.restart();
+}
+
+
+void StreamConnection::pongReceived( quint64 uiElapsed, const QByteArray &payload )
+{
+    Q_UNUSED( payload );
+
+    m_lastHeard.restart();
+    m_counters.iRoundTripMs = static_cast<qint64>( uiElapsed );
+}
+
+
+void StreamConnection::retry()
+{
+    if( m_eState != Waiting )
+        return;
+
+    m_eState = Connecting;
+    m_connectTimer.start();
+    m_socket.open( m_url );
+}
+
+
+// Give up on an attempt that's still going after the connect timeout
+// A connect whose SYN was lost in a Wi-Fi blip would otherwise wait out the OS connect timeout, which can be
+// tens of seconds, before failing and being retried.
+void StreamConnection::connectTimeout()
+{
+    if( m_eState != Connecting )
+        return;
+
+    m_counters.iConnectTimeouts++;
+    connectionLost();
+}
+
+
+// Ping while connected and restart the connection if it's gone quiet
+void StreamConnection::checkLiveness()
+{
+    if( m_eState != Connected )
+        return;
+
+    if( m_lastHeard.elapsed() > LivenessTimeout )
+    {
+        m_counters.iLivenessTimeouts++;
+        connectionLost();
+    }
+    else
+        m_socket.ping();
+}
+
+
+// Drop what's left of the socket and schedule the next attempt
+// The first retry is immediate; after that the delay doubles up to the limit and is jittered between half and all
+// of it so several sockets (or several displays) don't all hammer the Stratux in step.
+void StreamConnection::connectionLost()
+{
+    bool bWasConnected = (m_eState == Connected);
+    int  iDelay = 0;
+
+    m_counters.iFailures++;
+    m_connectTimer.stop();
+    m_livenessTimer.stop();
+    m_eState = Waiting;             // Before the abort so the disconnected() it fires is ignored
+    if( !m_downSince.isValid() )
+        m_downSince.start();
+    m_socket.abort();
+
+    if( m_iBackoffMs > 0 )
+        iDelay = (m_iBackoffMs / 2) + QRandomGenerator::global()->bounded( (m_iBackoffMs / 2) + 1 );
+    m_iBackoffMs = (m_iBackoffMs == 0) ? FirstBackoff : qMin( m_iBackoffMs * 2, MaxBackoff );
+    m_retryTimer.start( iDelay );
+
+    if( bWasConnected )
+        emit connectionChanged( false );
+}
@@ -0,0 +1,77 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include "StreamQueue.h"
+
+
+// A keep-latest queue only ever needs the one slot
+StreamQueue::StreamQueue( Policy ePolicy, int iCapacity )
+    : m_ePolicy( ePolicy ),
+      m_ring( (ePolicy == KeepLatest) ? 1 : qMax( iCapacity, 1 ) ),
+      m_iHead( 0 ),
+      m_iCount( 0 )
+{
+    m_counters.iReceived = 0;
+    m_counters.iDelivered = 0;
+    m_counters.iDropped = 0;
+    m_counters.iCoalesced = 0;
+    m_counters.iHighWater = 0;
+}
+
+
+// Queue a message; QString is implicitly shared so this doesn't copy the text
+void StreamQueue::push( const QString &qsMessage )
+{
+    m_counters.iReceived++;
+
+    if( m_ePolicy == KeepLatest )
+    {
+        if( m_iCount > 0 )
+            m_counters.iCoalesced++;
+        m_ring[0] = qsMessage;
+        m_iCount = 1;
+    }
+    else
+    {
+        if( m_iCount == m_ring.count() )
+        {
+            // Full; the oldest goes
+            m_iHead = (m_iHead + 1) % m_ring.count();
+            m_iCount--;
+            m_counters.iDropped++;
+        }
+        m_ring[(m_iHead + m_iCount) % m_ring.count()] = qsMessage;
+        m_iCount++;
+    }
+
+    if( m_iCount > m_counters.iHighWater )
+        m_counters.iHighWater = m_iCount;
+}
+
+
+// Take the oldest message; returns false if there isn't one
+bool StreamQueue::pop( QString &qsMessage )
+{
+    if( m_iCount == 0 )
+        return false;
+
+    qsMessage = m_ring.at( m_iHead );
+    m_ring[m_iHead].clear();    // Don't hold on to the text
+    m_iHead = (m_iHead + 1) % m_ring.count();
+    m_iCount--;
+    m_counters.iDelivered++;
+
+    return true;
+}
+
+
+// Throw away anything waiting; the counters keep running
+void StreamQueue::clear()
+{
+    for( int i = 0; i < m_ring.count(); i++ )
+        m_ring[i].clear();
+    m_iHead = 0;
+    m_iCount = 0;
+}
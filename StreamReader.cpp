@@ -6,13 +6,25 @@ Stratux AHRS Display
 #include <QtDebug>
 #include <QApplication>
 #include <QUrl>
-#include <QStringList>
 #include <QColor>
 #include <QPalette>
 #include <QNetworkInterface>
+#include <QSettings>
 
 #include "StreamReader.h"
 #include "TrafficMath.h"
+#include "GDL90Decoder.h"
+#include "GDL90Framer.h"
+#include "StringTable.h"
+#include "ISOTime.h"
+#include "JsonFields.h"
+
+
+#define GDL90Port        4000
+#define TrafficQueueSize 256     // Raw traffic messages held between drains before the oldest are dropped
+#define WeatherQueueSize 128
+#define GDL90RebindTime  1000    // Milliseconds between attempts to listen for GDL90 if the port couldn't be bound
+#define GDL90SilentTime  3000    // No datagrams for this long means the Stratux is gone
 
 
 extern bool g_bEmulated;
@@ -25,11 +37,47 @@ StreamReader::StreamReader( QObject *parent )
       m_bStratuxStatus( false ),
       m_bGPSStatus( false ),
       m_bWeatherStatus( false ),
+      m_bTrafficStatus( false ),
+      m_eSource( AHRS::WebSocketSource ),
+      m_situationQueue( StreamQueue::KeepLatest, 1 ),
+      m_trafficQueue( StreamQueue::KeepAll, TrafficQueueSize ),
+      m_weatherQueue( StreamQueue::KeepAll, WeatherQueueSize ),
+      m_bHaveLastSituation( false ),
+      m_bSituationPending( false ),
+      m_uiPendingChanges( 0 ),
+      m_iSituationsCoalesced( 0 ),
+      m_iTrafficCoalesced( 0 ),
       m_bConnected( false )
 {
+    initSituation( m_gdl90Situation );
+    initSituation( m_lastSituation );
+
+    qRegisterMetaType<SituationSnapshot>( "SituationSnapshot" );
+    qRegisterMetaType<TrafficSnapshot>( "TrafficSnapshot" );
+    qRegisterMetaType<WeatherSnapshot>( "WeatherSnapshot" );
+
+    // The queues are drained once whatever's already waiting to be read has been handled
+    m_drainTimer.setSingleShot( true );
+    m_drainTimer.setInterval( 0 );
+    connect( &m_drainTimer, SIGNAL( timeout() ), this, SLOT( drainQueues() ) );
+
+    // The message slots are connected once for the life of the reader; connecting and disconnecting the
+    // streams only opens and closes the sockets so repeated connects can't stack up duplicate deliveries.
+    m_stratuxSituation.connectMessages( this, SLOT( situationUpdate( const QString& ) ) );
+    m_stratuxTraffic.connectMessages( this, SLOT( trafficUpdate( const QString& ) ) );
+    m_stratuxStatus.connectMessages( this, SLOT( statusUpdate( const QString& ) ) );
+    m_stratuxWeather.connectMessages( this, SLOT( weatherUpdate( const QString& ) ) );
+    connect( &m_stratuxGDL90, SIGNAL( readyRead() ), this, SLOT( gdl90Update() ), Qt::UniqueConnection );
+
     // If one connects there's a 99.99% chance they all will so just use the status
-    connect( &m_stratuxStatus, SIGNAL( connected() ), this, SLOT( stratuxConnected() ) );
-    connect( &m_stratuxStatus, SIGNAL( connected() ), this, SLOT( stratuxDisconnected() ) );
+    connect( &m_stratuxStatus, SIGNAL( connectionChanged( bool ) ), this, SLOT( stratuxConnectionChanged( bool ) ) );
+
+    m_gdl90RebindTimer.setSingleShot( true );
+    m_gdl90RebindTimer.setInterval( GDL90RebindTime );
+    connect( &m_gdl90RebindTimer, SIGNAL( timeout() ), this, SLOT( gdl90Bind() ) );
+    m_gdl90SilenceTimer.setSingleShot( true );
+    m_gdl90SilenceTimer.setInterval( GDL90SilentTime );
+    connect( &m_gdl90SilenceTimer, SIGNAL( timeout() ), this, SLOT( gdl90Silent() ) );
 }
 
 
@@ -38,139 +86,358 @@ StreamReader::~StreamReader()
 }
 
 
-// Open the websocket URLs from the Stratux
+// Open the websocket URLs from the Stratux or start listening for GDL90 depending on the configured source
+// Weather always comes from the websocket since the GDL90 stream only carries the raw FIS-B uplinks.
 void StreamReader::connectStreams()
 {
+    QSettings config;
+
+    config.beginGroup( "Global" );
+    connectStreams( static_cast<AHRS::StreamSource>( config.value( "StreamSource", static_cast<int>( AHRS::WebSocketSource ) ).toInt() ) );
+    config.endGroup();
+}
+
+
+// Open the streams for a source given by the caller instead of the settings
+void StreamReader::connectStreams( AHRS::StreamSource eSource )
+{
+    m_eSource = eSource;
+
+    // The first situation after connecting is all new
+    m_bHaveLastSituation = false;
+
     // Open the streams
-    m_stratuxSituation.open( QUrl( QString( "ws://192.168.10.1/situation" ) ) );
-    m_stratuxTraffic.open( QUrl( QString( "ws://192.168.10.1/traffic" ) ) );
-    m_stratuxStatus.open( QUrl( QString( "ws://192.168.10.1/status" ) ) );
-    connect( &m_stratuxTraffic, SIGNAL( textMessageReceived( const QString& ) ), this, SLOT( trafficUpdate( const QString& ) ) );
-    connect( &m_stratuxSituation, SIGNAL( textMessageReceived( const QString& ) ), this, SLOT( situationUpdate( const QString& ) ) );
-    connect( &m_stratuxStatus, SIGNAL( textMessageReceived( const QString& ) ), this, SLOT( statusUpdate( const QString& ) ) );
-    connect( &m_stratuxWeather, SIGNAL( textMessageReceived( const QString& ) ), this, SLOT( weatherUpdate( const QString& ) ) );
+    if( m_eSource == AHRS::GDL90Source )
+    {
+        initSituation( m_gdl90Situation );
+        m_gdl90Datagram.reserve( 65536 );
+        gdl90Bind();
+    }
+    else
+    {
+        // Each stream reconnects on its own from here on until it's closed
+        m_stratuxSituation.open( QUrl( QString( "ws://192.168.10.1/situation" ) ) );
+        m_stratuxTraffic.open( QUrl( QString( "ws://192.168.10.1/traffic" ) ) );
+        m_stratuxStatus.open( QUrl( QString( "ws://192.168.10.1/status" ) ) );
+    }
+    m_stratuxWeather.open( QUrl( QString( "ws://192.168.10.1/weather" ) ) );
 }
 
 
 // Close all the streams
 void StreamReader::disconnectStreams()
 {
-    disconnect( &m_stratuxTraffic, SIGNAL( textMessageReceived( const QString& ) ), this, SLOT( trafficUpdate( const QString& ) ) );
-    disconnect( &m_stratuxSituation, SIGNAL( textMessageReceived( const QString& ) ), this, SLOT( situationUpdate( const QString& ) ) );
-    disconnect( &m_stratuxStatus, SIGNAL( textMessageReceived( const QString& ) ), this, SLOT( statusUpdate( const QString& ) ) );
-    disconnect( &m_stratuxWeather, SIGNAL( textMessageReceived( const QString& ) ), this, SLOT( weatherUpdate( const QString& ) ) );
     m_stratuxSituation.close();
     m_stratuxTraffic.close();
     m_stratuxStatus.close();
     m_stratuxWeather.close();
+    m_stratuxGDL90.close();
+    m_gdl90RebindTimer.stop();
+    m_gdl90SilenceTimer.stop();
+    m_drainTimer.stop();
+    m_situationQueue.clear();
+    m_trafficQueue.clear();
+    m_weatherQueue.clear();
+    m_bSituationPending = false;
+    m_uiPendingChanges = 0;
+    m_trafficBatch.resize( 0 );
+    m_trafficBatchIndex.clear();
+    m_bConnected = false;
     emit newStatus( false, false, false, false, false );
 }
 
 
-// Updates from the situation stream
-// String is received from stratux and the situation struct filled in
+// Start the arrival and parse statistics over for every endpoint
+void StreamReader::resetStats()
+{
+    int i;
+
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        m_stats[i].reset();
+}
+
+
+// Stream, queue and connection counters for the metrics endpoint
+// Parse times, gaps and jitter only cover the time something had timing turned on (see StreamStats).
+void StreamReader::metrics( MetricsWriter &writer ) const
+{
+    static const char *szEndpoints[AHRS::EndpointCount] = { "situation", "traffic", "status", "weather", "gdl90" };
+    static const char *szQueues[3] = { "situation", "traffic", "weather" };
+
+    StreamStats::Counters       stats[AHRS::EndpointCount];
+    const StreamQueue          *queues[3] = { &m_situationQueue, &m_trafficQueue, &m_weatherQueue };
+    const StreamConnection     *connections[4] = { &m_stratuxSituation, &m_stratuxTraffic, &m_stratuxStatus, &m_stratuxWeather };
+    StreamConnection::Counters  conn[4];
+    int                         i;
+
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        m_stats[i].counters( stats[i] );
+    for( i = 0; i < 4; i++ )
+        conn[i] = connections[i]->counters();
+
+    writer.family( "rosco_stream_messages_total", "counter", "Messages received." );
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        writer.value( "rosco_stream_messages_total", "stream", szEndpoints[i], stats[i].iMessages );
+    writer.family( "rosco_stream_bytes_total", "counter", "Bytes received." );
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        writer.value( "rosco_stream_bytes_total", "stream", szEndpoints[i], stats[i].iBytes );
+    writer.family( "rosco_stream_parsed_total", "counter", "Messages timed through the parser." );
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        writer.value( "rosco_stream_parsed_total", "stream", szEndpoints[i], stats[i].iParsed );
+    writer.family( "rosco_stream_parse_seconds_total", "counter", "Time spent parsing the timed messages." );
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        writer.value( "rosco_stream_parse_seconds_total", "stream", szEndpoints[i], stats[i].iParseNs / 1.0e9 );
+    writer.family( "rosco_stream_parse_max_seconds", "gauge", "Longest parse of one message." );
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        writer.value( "rosco_stream_parse_max_seconds", "stream", szEndpoints[i], stats[i].iMaxParseNs / 1.0e9 );
+    writer.family( "rosco_stream_max_gap_seconds", "gauge", "Longest time between two messages." );
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        writer.value( "rosco_stream_max_gap_seconds", "stream", szEndpoints[i], stats[i].iMaxGapMs / 1000.0 );
+    writer.family( "rosco_stream_jitter_seconds", "gauge", "Smoothed inter-arrival jitter." );
+    for( i = 0; i < AHRS::EndpointCount; i++ )
+        writer.value( "rosco_stream_jitter_seconds", "stream", szEndpoints[i], stats[i].iJitterUs / 1.0e6 );
+
+    writer.family( "rosco_queue_depth", "gauge", "Raw messages waiting to be parsed." );
+    for( i = 0; i < 3; i++ )
+        writer.value( "rosco_queue_depth", "queue", szQueues[i], queues[i]->count() );
+    writer.family( "rosco_queue_high_water", "gauge", "Most raw messages waiting at once." );
+    for( i = 0; i < 3; i++ )
+        writer.value( "rosco_queue_high_water", "queue", szQueues[i], queues[i]->counters().iHighWater );
+    writer.family( "rosco_queue_dropped_total", "counter", "Raw messages dropped because the queue was full." );
+    for( i = 0; i < 3; i++ )
+        writer.value( "rosco_queue_dropped_total", "queue", szQueues[i], queues[i]->counters().iDropped );
+    writer.family( "rosco_queue_coalesced_total", "counter", "Raw messages superseded by a newer one before being parsed." );
+    for( i = 0; i < 3; i++ )
+        writer.value( "rosco_queue_coalesced_total", "queue", szQueues[i], queues[i]->counters().iCoalesced );
+    writer.family( "rosco_situations_coalesced_total", "counter", "Parsed situations superseded before being sent on." );
+    writer.value( "rosco_situations_coalesced_total", m_iSituationsCoalesced );
+    writer.family( "rosco_traffic_coalesced_total", "counter", "Traffic updates merged into an earlier one in the same batch." );
+    writer.value( "rosco_traffic_coalesced_total", m_iTrafficCoalesced );
+
+    writer.family( "rosco_connection_up", "gauge", "Whether the websocket is connected." );
+    for( i = 0; i < 4; i++ )
+        writer.value( "rosco_connection_up", "stream", szEndpoints[i], connections[i]->isConnected() ? 1 : 0 );
+    writer.family( "rosco_connection_reconnects_total", "counter", "Connects after the first." );
+    for( i = 0; i < 4; i++ )
+        writer.value( "rosco_connection_reconnects_total", "stream", szEndpoints[i], conn[i].iReconnects );
+    writer.family( "rosco_connection_failures_total", "counter", "Errors, drops, connect and liveness timeouts." );
+    for( i = 0; i < 4; i++ )
+        writer.value( "rosco_connection_failures_total", "stream", szEndpoints[i], conn[i].iFailures );
+    writer.family( "rosco_connection_connect_timeouts_total", "counter", "Connect attempts aborted for taking too long." );
+    for( i = 0; i < 4; i++ )
+        writer.value( "rosco_connection_connect_timeouts_total", "stream", szEndpoints[i], conn[i].iConnectTimeouts );
+    writer.family( "rosco_connection_downtime_seconds_total", "counter", "Time the stream was wanted but not connected." );
+    for( i = 0; i < 4; i++ )
+        writer.value( "rosco_connection_downtime_seconds_total", "stream", szEndpoints[i], conn[i].iDowntimeMs / 1000.0 );
+    writer.family( "rosco_connection_rtt_seconds", "gauge", "Latest ping round trip." );
+    for( i = 0; i < 4; i++ )
+        writer.value( "rosco_connection_rtt_seconds", "stream", szEndpoints[i], conn[i].iRoundTripMs / 1000.0 );
+}
+
+
+// Feed one recorded message through as if it had just come in on its websocket and pass on the results right away
+// Used to replay a recorded session without a Stratux; the snapshots go out before this returns.
+void StreamReader::inject( AHRS::StreamEndpoint eEndpoint, const QString &qsMessage )
+{
+    switch( eEndpoint )
+    {
+        case AHRS::SituationEndpoint:
+            situationUpdate( qsMessage );
+            break;
+        case AHRS::TrafficEndpoint:
+            trafficUpdate( qsMessage );
+            break;
+        case AHRS::StatusEndpoint:
+            statusUpdate( qsMessage );
+            break;
+        case AHRS::WeatherEndpoint:
+            weatherUpdate( qsMessage );
+            break;
+        default:
+            return;
+    }
+    m_drainTimer.stop();
+    drainQueues();
+}
+
+
+// Raw messages from the websockets are only queued as they come in and parsed when the queues are drained
 void StreamReader::situationUpdate( const QString &qsMessage )
 {
-    QStringList      qslFields( qsMessage.split( ',' ) );
-    QString          qsField;
+    m_stats[AHRS::SituationEndpoint].arrived( qsMessage.size() );
+    m_situationQueue.push( qsMessage );
+    scheduleDrain();
+}
+
+
+void StreamReader::trafficUpdate( const QString &qsMessage )
+{
+    m_stats[AHRS::TrafficEndpoint].arrived( qsMessage.size() );
+    m_trafficQueue.push( qsMessage );
+    scheduleDrain();
+}
+
+
+void StreamReader::weatherUpdate( const QString &qsMessage )
+{
+    m_stats[AHRS::WeatherEndpoint].arrived( qsMessage.size() );
+    m_weatherQueue.push( qsMessage );
+    scheduleDrain();
+}
+
+
+// Drain the queues on the next pass through the event loop if that isn't already going to happen
+void StreamReader::scheduleDrain()
+{
+    if( !m_drainTimer.isActive() )
+        m_drainTimer.start();
+}
+
+
+// Parse whatever is queued and send on the newest situation and one batch of traffic
+void StreamReader::drainQueues()
+{
+    QString       qsMessage;
+    TrafficBatch *pBatch;
+    qint64        iStart;
+    int           iParsed;
+
+    iStart = StreamStats::startTiming();
+    for( iParsed = 0; m_situationQueue.pop( qsMessage ); iParsed++ )
+        parseSituation( qsMessage );
+    m_stats[AHRS::SituationEndpoint].parsed( iStart, iParsed );
+
+    iStart = StreamStats::startTiming();
+    for( iParsed = 0; m_trafficQueue.pop( qsMessage ); iParsed++ )
+        parseTraffic( qsMessage );
+    m_stats[AHRS::TrafficEndpoint].parsed( iStart, iParsed );
+
+    iStart = StreamStats::startTiming();
+    for( iParsed = 0; m_weatherQueue.pop( qsMessage ); iParsed++ )
+        parseWeather( qsMessage );
+    m_stats[AHRS::WeatherEndpoint].parsed( iStart, iParsed );
+
+    if( m_bSituationPending )
+    {
+        m_lastSituation.uiChanged = m_uiPendingChanges;
+        m_bSituationPending = false;
+        m_uiPendingChanges = 0;
+        emit newSituation( SituationSnapshot( new StratuxSituation( m_lastSituation ) ) );
+    }
+
+    if( !m_trafficBatch.isEmpty() )
+    {
+        pBatch = new TrafficBatch;
+        pBatch->swap( m_trafficBatch );
+        m_trafficBatchIndex.clear();
+        emit newTraffic( TrafficSnapshot( pBatch ) );
+    }
+}
+
+
+// Situation stream message
+// String is received from stratux and the situation struct filled in; the fields are read in place so the
+// only thing copied out of the message is the NMEA sentence, and only when it's changed.
+void StreamReader::parseSituation( const QString &qsMessage )
+{
+    JsonFields       fields( qsMessage );
     StratuxSituation situation;
-    QStringList      qslThisField;
-    QString          qsTag;
-    QString          qsVal;
     double           dVal;
     int              iVal;
 
     initSituation( situation );
 
-    foreach( qsField, qslFields )
+    while( fields.next() )
     {
-        qslThisField = qsField.split( "\":" );
-        if( qslThisField.count() != 2 )
-            continue;
-
         // Tag and value - see https://github.com/cyoung/stratux/blob/master/notes/app-vendor-integration.md
-        qsTag = qslThisField.first().remove( 0, 1 ).trimmed().remove( '\"' );
-        qsVal = qslThisField.last().trimmed().remove( '\"' ).remove( '}' );
+        const QStringRef &qsTag = fields.tag();
+        const QStringRef &qsVal = fields.value();
+
         dVal = qsVal.toDouble();
         iVal = qsVal.toInt();
 
-        if( qsTag == "GPSLastFixSinceMidnightUTC" )
+        if( qsTag == QLatin1String( "GPSLastFixSinceMidnightUTC" ) )
             situation.dLastGPSFixSinceMidnight = dVal;
-        else if( qsTag == "GPSLatitude" )
+        else if( qsTag == QLatin1String( "GPSLatitude" ) )
             situation.dGPSlat = dVal;
-        else if( qsTag == "GPSLongitude" )
+        else if( qsTag == QLatin1String( "GPSLongitude" ) )
             situation.dGPSlong = dVal;
-        else if( qsTag == "GPSFixQuality" )
+        else if( qsTag == QLatin1String( "GPSFixQuality" ) )
             situation.iGPSFixQuality = iVal;
-        else if( qsTag == "GPSHeightAboveEllipsoid" )
+        else if( qsTag == QLatin1String( "GPSHeightAboveEllipsoid" ) )
             situation.dGPSHeightAboveEllipsoid = dVal;
-        else if( qsTag == "GPSGeoidSep" )
+        else if( qsTag == QLatin1String( "GPSGeoidSep" ) )
             situation.dGPSGeoidSep = dVal;
-        else if( qsTag == "GPSSatellites" )
+        else if( qsTag == QLatin1String( "GPSSatellites" ) )
             situation.iGPSSats = iVal;
-        else if( qsTag == "GPSSatellitesTracked" )
+        else if( qsTag == QLatin1String( "GPSSatellitesTracked" ) )
             situation.iGPSSatsTracked = iVal;
-        else if( qsTag == "GPSSatellitesSeen" )
+        else if( qsTag == QLatin1String( "GPSSatellitesSeen" ) )
             situation.iGPSSatsSeen = iVal;
-        else if( qsTag == "GPSHorizontalAccuracy" )
+        else if( qsTag == QLatin1String( "GPSHorizontalAccuracy" ) )
             situation.dGPSHorizAccuracy = dVal;
-        else if( qsTag == "GPSNACp" )
+        else if( qsTag == QLatin1String( "GPSNACp" ) )
             situation.iGPSNACp = iVal;
-        else if( qsTag == "GPSAltitudeMSL" )
+        else if( qsTag == QLatin1String( "GPSAltitudeMSL" ) )
             situation.dGPSAltMSL = iVal;
-        else if( qsTag == "GPSVerticalAccuracy" )
+        else if( qsTag == QLatin1String( "GPSVerticalAccuracy" ) )
             situation.dGPSVertAccuracy = dVal;
-        else if( qsTag == "GPSVerticalSpeed" )
+        else if( qsTag == QLatin1String( "GPSVerticalSpeed" ) )
             situation.dGPSVertSpeed = dVal;
-        else if( qsTag == "GPSLastFixLocalTime" )
-            situation.lastGPSFixTime.fromString( qsVal, Qt::ISODate );
-        else if( qsTag == "GPSTrueCourse" )
+        else if( qsTag == QLatin1String( "GPSLastFixLocalTime" ) )
+            situation.iLastGPSFixTime = ISOTime::toMSecs( qsVal );
+        else if( qsTag == QLatin1String( "GPSTrueCourse" ) )
             situation.dGPSTrueCourse = dVal;
-        else if( qsTag == "GPSTurnRate" )
+        else if( qsTag == QLatin1String( "GPSTurnRate" ) )
             situation.dGPSTurnRate = dVal;
-        else if( qsTag == "GPSGroundSpeed" )
+        else if( qsTag == QLatin1String( "GPSGroundSpeed" ) )
             situation.dGPSGroundSpeed = dVal;
-        else if( qsTag == "GPSLastGroundTrackTime" )
-            situation.lastGPSGroundTrackTime.fromString( qsVal, Qt::ISODate );
-        else if( qsTag == "GPSTime" )
-            situation.gpsDateTime.fromString( qsVal, Qt::ISODate );
-        else if( qsTag == "GPSLastGPSTimeStratuxTime" )
-            situation.lastGPSTimeStratuxTime.fromString( qsVal, Qt::ISODate );
-        else if( qsTag == "GPSLastValidNMEAMessageTime" )
-            situation.lastValidNMEAMessageTime.fromString( qsVal, Qt::ISODate );
-        else if( qsTag == "GPSLastValidNMEAMessage" )
-            situation.qsLastNMEAMsg = qsVal;
-        else if( qsTag == "GPSPositionSampleRate" )
+        else if( qsTag == QLatin1String( "GPSLastGroundTrackTime" ) )
+            situation.iLastGPSGroundTrackTime = ISOTime::toMSecs( qsVal );
+        else if( qsTag == QLatin1String( "GPSTime" ) )
+            situation.iGPSDateTime = ISOTime::toMSecs( qsVal );
+        else if( qsTag == QLatin1String( "GPSLastGPSTimeStratuxTime" ) )
+            situation.iLastGPSTimeStratuxTime = ISOTime::toMSecs( qsVal );
+        else if( qsTag == QLatin1String( "GPSLastValidNMEAMessageTime" ) )
+            situation.iLastValidNMEAMessageTime = ISOTime::toMSecs( qsVal );
+        else if( qsTag == QLatin1String( "GPSLastValidNMEAMessage" ) )
+        {
+            if( qsVal == m_lastSituation.qsLastNMEAMsg )
+                situation.qsLastNMEAMsg = m_lastSituation.qsLastNMEAMsg;
+            else
+                situation.qsLastNMEAMsg = qsVal.toString();
+        }
+        else if( qsTag == QLatin1String( "GPSPositionSampleRate" ) )
             situation.iGPSPosSampleRate = iVal;
-        else if( qsTag == "BaroTemperature" )
+        else if( qsTag == QLatin1String( "BaroTemperature" ) )
             situation.dBaroTemp = dVal;
-        else if( qsTag == "BaroPressureAltitude" )
+        else if( qsTag == QLatin1String( "BaroPressureAltitude" ) )
             situation.dBaroPressAlt = dVal;
-        else if( qsTag == "BaroVerticalSpeed" )
+        else if( qsTag == QLatin1String( "BaroVerticalSpeed" ) )
             situation.dBaroVertSpeed = dVal;
-        else if( qsTag == "BaroLastMeasurementTime" )
-            situation.lastBaroMeasTime.fromString( qsVal, Qt::ISODate );
-        else if( qsTag == "AHRSPitch" )
+        else if( qsTag == QLatin1String( "BaroLastMeasurementTime" ) )
+            situation.iLastBaroMeasTime = ISOTime::toMSecs( qsVal );
+        else if( qsTag == QLatin1String( "AHRSPitch" ) )
             situation.dAHRSpitch = dVal;
-        else if( qsTag == "AHRSRoll" )
+        else if( qsTag == QLatin1String( "AHRSRoll" ) )
             situation.dAHRSroll = dVal;
-        else if( qsTag == "AHRSGyroHeading" )
+        else if( qsTag == QLatin1String( "AHRSGyroHeading" ) )
             situation.dAHRSGyroHeading = dVal;
-        else if( qsTag == "AHRSMagHeading" )
+        else if( qsTag == QLatin1String( "AHRSMagHeading" ) )
             situation.dAHRSMagHeading = dVal;
-        else if( qsTag == "AHRSSlipSkid" )
+        else if( qsTag == QLatin1String( "AHRSSlipSkid" ) )
             situation.dAHRSSlipSkid = dVal;
-        else if( qsTag == "AHRSTurnRate" )
+        else if( qsTag == QLatin1String( "AHRSTurnRate" ) )
             situation.dAHRSTurnRate = dVal;
-        else if( qsTag == "AHRSGLoad" )
+        else if( qsTag == QLatin1String( "AHRSGLoad" ) )
             situation.dAHRSGLoad = dVal;
-        else if( qsTag == "AHRSGLoadMin" )
+        else if( qsTag == QLatin1String( "AHRSGLoadMin" ) )
             situation.dAHRSGLoadMin = dVal;
-        else if( qsTag == "AHRSGLoadMax" )
+        else if( qsTag == QLatin1String( "AHRSGLoadMax" ) )
             situation.dAHRSGLoadMax = dVal;
-        else if( qsTag == "AHRSLastAttitudeTime" )
-            situation.lastAHRSAttTime.fromString( qsVal, Qt::ISODate );
-        else if( qsTag == "AHRSStatus" )
+        else if( qsTag == QLatin1String( "AHRSLastAttitudeTime" ) )
+            situation.iLastAHRSAttTime = ISOTime::toMSecs( qsVal );
+        else if( qsTag == QLatin1String( "AHRSStatus" ) )
             situation.iAHRSStatus = iVal;
     }
 
@@ -179,28 +446,92 @@ void StreamReader::situationUpdate( const QString &qsMessage )
     while( situation.dAHRSMagHeading > 360.0 )
         situation.dAHRSMagHeading -= 360.0;
 
-    if( (situation.dGPSlat != 0.0) && (situation.dGPSlong != 0.0) )
+    myPosition( situation );
+
+    m_bAHRSStatus = (situation.iAHRSStatus > 0);
+
+    queueSituation( situation );
+}
+
+
+// Keep the newest situation to send on the next drain
+// Its change mask covers everything that changed since the last one actually sent.
+void StreamReader::queueSituation( const StratuxSituation &situation )
+{
+    m_uiPendingChanges |= m_bHaveLastSituation ? situationChanges( m_lastSituation, situation ) : static_cast<uint>( AHRS::AllChanged );
+    if( m_bSituationPending )
+        m_iSituationsCoalesced++;
+    m_lastSituation = situation;
+    m_bHaveLastSituation = true;
+    m_bSituationPending = true;
+    scheduleDrain();
+}
+
+
+// Add an aircraft to the batch going out on the next drain; a later update for the same aircraft replaces it
+void StreamReader::queueTraffic( int iICAO, const StratuxTraffic &traffic )
+{
+    QHash<int, int>::const_iterator it = m_trafficBatchIndex.constFind( iICAO );
+    StratuxTrafficUpdate            trafficUpdate;
+
+    if( it != m_trafficBatchIndex.constEnd() )
     {
-        m_bHaveMyPos = true;
-        m_dMyLat = situation.dGPSlat;
-        m_dMyLong = situation.dGPSlong;
+        m_trafficBatch[it.value()].traffic = traffic;
+        m_iTrafficCoalesced++;
+    }
+    else
+    {
+        trafficUpdate.iICAO = iICAO;
+        trafficUpdate.traffic = traffic;
+        m_trafficBatchIndex.insert( iICAO, m_trafficBatch.count() );
+        m_trafficBatch.append( trafficUpdate );
     }
+    scheduleDrain();
+}
 
-    m_bAHRSStatus = (situation.iAHRSStatus > 0);
 
-    emit newSituation( situation );
+// Which groups of fields differ between two situations (AHRS::SituationChange bits)
+// Exact comparisons on purpose; the values are only ever copied from the stream so a repeated value is bit for bit the same.
+uint StreamReader::situationChanges( const StratuxSituation &prev, const StratuxSituation &cur )
+{
+    uint uiChanged = 0;
+
+    if( (cur.dAHRSpitch != prev.dAHRSpitch) || (cur.dAHRSroll != prev.dAHRSroll) || (cur.dAHRSSlipSkid != prev.dAHRSSlipSkid) )
+        uiChanged |= AHRS::AttitudeChanged;
+    if( (cur.dAHRSMagHeading != prev.dAHRSMagHeading) || (cur.dAHRSGyroHeading != prev.dAHRSGyroHeading) || (cur.dAHRSTurnRate != prev.dAHRSTurnRate) )
+        uiChanged |= AHRS::HeadingChanged;
+    if( (cur.dBaroPressAlt != prev.dBaroPressAlt) || (cur.dBaroVertSpeed != prev.dBaroVertSpeed) || (cur.dBaroTemp != prev.dBaroTemp) )
+        uiChanged |= AHRS::BaroChanged;
+    if( (cur.dGPSlat != prev.dGPSlat) || (cur.dGPSlong != prev.dGPSlong) || (cur.dGPSAltMSL != prev.dGPSAltMSL) ||
+        (cur.dGPSHeightAboveEllipsoid != prev.dGPSHeightAboveEllipsoid) || (cur.dGPSGeoidSep != prev.dGPSGeoidSep) ||
+        (cur.dLastGPSFixSinceMidnight != prev.dLastGPSFixSinceMidnight) )
+        uiChanged |= AHRS::GPSPosChanged;
+    if( (cur.dGPSTrueCourse != prev.dGPSTrueCourse) || (cur.dGPSGroundSpeed != prev.dGPSGroundSpeed) ||
+        (cur.dGPSTurnRate != prev.dGPSTurnRate) || (cur.dGPSVertSpeed != prev.dGPSVertSpeed) )
+        uiChanged |= AHRS::GPSTrackChanged;
+    if( (cur.iGPSFixQuality != prev.iGPSFixQuality) || (cur.iGPSSats != prev.iGPSSats) || (cur.iGPSSatsTracked != prev.iGPSSatsTracked) ||
+        (cur.iGPSSatsSeen != prev.iGPSSatsSeen) || (cur.dGPSHorizAccuracy != prev.dGPSHorizAccuracy) || (cur.iGPSNACp != prev.iGPSNACp) ||
+        (cur.dGPSVertAccuracy != prev.dGPSVertAccuracy) || (cur.iGPSPosSampleRate != prev.iGPSPosSampleRate) )
+        uiChanged |= AHRS::GPSStatusChanged;
+    if( (cur.dAHRSGLoad != prev.dAHRSGLoad) || (cur.dAHRSGLoadMin != prev.dAHRSGLoadMin) || (cur.dAHRSGLoadMax != prev.dAHRSGLoadMax) )
+        uiChanged |= AHRS::GLoadChanged;
+    if( cur.iAHRSStatus != prev.iAHRSStatus )
+        uiChanged |= AHRS::AHRSStatusChanged;
+    if( (cur.iLastGPSFixTime != prev.iLastGPSFixTime) || (cur.iLastGPSGroundTrackTime != prev.iLastGPSGroundTrackTime) ||
+        (cur.iGPSDateTime != prev.iGPSDateTime) || (cur.iLastGPSTimeStratuxTime != prev.iLastGPSTimeStratuxTime) ||
+        (cur.iLastValidNMEAMessageTime != prev.iLastValidNMEAMessageTime) || (cur.iLastBaroMeasTime != prev.iLastBaroMeasTime) ||
+        (cur.iLastAHRSAttTime != prev.iLastAHRSAttTime) || (cur.qsLastNMEAMsg != prev.qsLastNMEAMsg) )
+        uiChanged |= AHRS::TimesChanged;
+
+    return uiChanged;
 }
 
 
-// Updates from the traffic stream
-void StreamReader::trafficUpdate( const QString &qsMessage )
+// Traffic stream message
+void StreamReader::parseTraffic( const QString &qsMessage )
 {
-    QStringList    qslFields( qsMessage.split( ',' ) );
-    QString        qsField;
+    JsonFields     fields( qsMessage );
     StratuxTraffic traffic;
-    QStringList    qslThisField;
-    QString        qsTag;
-    QString        qsVal;
     double         dVal;
     int            iVal;
     bool           bVal;
@@ -211,122 +542,238 @@ void StreamReader::trafficUpdate( const QString &qsMessage )
 
     initTraffic( traffic );
 
-    foreach( qsField, qslFields )
+    while( fields.next() )
     {
-        qslThisField = qsField.split( "\":" );
-        if( qslThisField.count() != 2 )
-            continue;
-
         // Tag and value - see https://github.com/cyoung/stratux/blob/master/notes/app-vendor-integration.md
-        qsTag = qslThisField.first().remove( 0, 1 ).trimmed().remove( '\"' );
-        qsVal = qslThisField.last().trimmed().remove( '\"' ).remove( '}' );
+        const QStringRef &qsTag = fields.tag();
+        const QStringRef &qsVal = fields.value();
+
         dVal = qsVal.toDouble();
         iVal = qsVal.toInt();
-        bVal = (qsVal == "true");
+        bVal = (qsVal == QLatin1String( "true" ));
 
-        if( qsTag == "Icao_addr" )
+        if( qsTag == QLatin1String( "Icao_addr" ) )
             iICAO = iVal;   // Note this is not part of the struct
-        else if( qsTag == "OnGround" )
+        else if( qsTag == QLatin1String( "OnGround" ) )
             traffic.bOnGround = bVal;
-        else if( qsTag == "Lat" )
+        else if( qsTag == QLatin1String( "Lat" ) )
             traffic.dLat = dVal;
-        else if( qsTag == "Lng" )
+        else if( qsTag == QLatin1String( "Lng" ) )
             traffic.dLong = dVal;
-        else if( qsTag == "Position_valid" )
+        else if( qsTag == QLatin1String( "Position_valid" ) )
             traffic.bPosValid = bVal;
-        else if( qsTag == "Alt" )
-            traffic.dAlt = dVal;
-        else if( qsTag == "Track" )
-            traffic.dTrack = dVal;
-        else if( qsTag == "Speed" )
-            traffic.dSpeed = dVal;
-        else if( qsTag == "Vvel" )
-            traffic.dVertSpeed = dVal;
-        else if( qsTag == "Tail" )
-            traffic.qsTail = qsVal;
-        else if( qsTag == "Last_seen" )
-            traffic.lastSeen.fromString( qsVal, Qt::ISODate );
-        else if( qsTag == "Last_source" )
+        else if( qsTag == QLatin1String( "Alt" ) )
+            traffic.fAlt = static_cast<float>( dVal );
+        else if( qsTag == QLatin1String( "Track" ) )
+            traffic.fTrack = static_cast<float>( dVal );
+        else if( qsTag == QLatin1String( "Speed" ) )
+            traffic.fSpeed = static_cast<float>( dVal );
+        else if( qsTag == QLatin1String( "Vvel" ) )
+            traffic.fVertSpeed = static_cast<float>( dVal );
+        else if( qsTag == QLatin1String( "Tail" ) )
+            traffic.iTail = StringTable::intern( qsVal );
+        else if( qsTag == QLatin1String( "Last_seen" ) )
+            traffic.iLastSeen = ISOTime::toMSecs( qsVal );
+        else if( qsTag == QLatin1String( "Last_source" ) )
             traffic.iLastSource = iVal;
-        else if( qsTag == "Reg" )
-            traffic.qsReg = qsVal;
-        else if( qsTag == "SignalLevel" )
-            traffic.dSigLevel = dVal;
-        else if( qsTag == "Squawk" )
+        else if( qsTag == QLatin1String( "Reg" ) )
+            traffic.iReg = StringTable::intern( qsVal );
+        else if( qsTag == QLatin1String( "SignalLevel" ) )
+            traffic.fSigLevel = static_cast<float>( dVal );
+        else if( qsTag == QLatin1String( "Squawk" ) )
             traffic.iSquawk = iVal;
-        else if( qsTag == "Timestamp" )
-            traffic.timestamp.fromString( qsVal, Qt::ISODate );
-        else if( qsTag == "Last_source" )
-            traffic.iLastSource = iVal;
-        else if( qsTag == "Bearing" )
-            traffic.dBearing = dVal;
-        else if( qsTag == "Distance" )
-            traffic.dDist = dVal * 0.000539957;  // Meters to Nautical Miles
-        else if( qsTag == "Age" )
-            traffic.dAge = dVal;
+        else if( qsTag == QLatin1String( "Timestamp" ) )
+            traffic.iTimestamp = ISOTime::toMSecs( qsVal );
+        else if( qsTag == QLatin1String( "Bearing" ) )
+            traffic.fBearing = static_cast<float>( dVal );
+        else if( qsTag == QLatin1String( "Distance" ) )
+            traffic.fDist = static_cast<float>( dVal * 0.000539957 );  // Meters to Nautical Miles
+        else if( qsTag == QLatin1String( "Age" ) )
+            traffic.fAge = static_cast<float>( dVal );
     }
 
-    // If we know where we are, figure out where they are
+    trafficPosition( traffic );
+
+    if( iICAO > 0 )
+        queueTraffic( iICAO, traffic );
+}
+
+
+// Keep track of where we are for working out where the traffic is
+void StreamReader::myPosition( const StratuxSituation &situation )
+{
+    if( (situation.dGPSlat != 0.0) && (situation.dGPSlong != 0.0) )
+    {
+        m_bHaveMyPos = true;
+        m_dMyLat = situation.dGPSlat;
+        m_dMyLong = situation.dGPSlong;
+    }
+}
+
+
+// If we know where we are, figure out where they are
+void StreamReader::trafficPosition( StratuxTraffic &traffic )
+{
     if( (traffic.bPosValid) && m_bHaveMyPos )
     {
         // Modified haversine algorithm for calculating distance and bearing
         TrafficMath::BearingDist bd = TrafficMath::haversine( m_dMyLat, m_dMyLong, traffic.dLat, traffic.dLong );
 
-        traffic.dBearing = bd.dBearing;
-        traffic.dDist = bd.dDistance;
+        traffic.fBearing = static_cast<float>( bd.dBearing );
+        traffic.fDist = static_cast<float>( bd.dDistance );
         traffic.bHasADSB = true;
     }
     else
         traffic.bHasADSB = false;
+}
 
-    if( iICAO > 0 )
-        emit newTraffic( iICAO, traffic );
+
+// Datagrams from the GDL90 stream
+// Each datagram holds one or more frames; they're unframed in place in the datagram buffer.
+void StreamReader::gdl90Update()
+{
+    uchar *pData, *pMsg;
+    int    iPos, iLength, iMsgLen;
+    qint64 iStart;
+
+    m_bConnected = true;
+    m_gdl90SilenceTimer.start();
+
+    while( m_stratuxGDL90.hasPendingDatagrams() )
+    {
+        m_gdl90Datagram.resize( static_cast<int>( m_stratuxGDL90.pendingDatagramSize() ) );
+        iLength = static_cast<int>( m_stratuxGDL90.readDatagram( m_gdl90Datagram.data(), m_gdl90Datagram.size() ) );
+        if( iLength <= 0 )
+            continue;
+
+        m_stats[AHRS::GDL90Endpoint].arrived( iLength );
+        iStart = StreamStats::startTiming();
+        pData = reinterpret_cast<uchar *>( m_gdl90Datagram.data() );
+        iPos = 0;
+        while( (iMsgLen = GDL90Framer::nextFrame( pData, iLength, iPos, &pMsg )) != 0 )
+        {
+            if( iMsgLen > 0 )
+                gdl90Message( pMsg, iMsgLen );
+        }
+        m_stats[AHRS::GDL90Endpoint].parsed( iStart );
+    }
+}
+
+
+// Hand one unframed GDL90 message to the decoder and pass on what it found the same way the websocket streams do
+void StreamReader::gdl90Message( const uchar *pMsg, int iLength )
+{
+    switch( pMsg[0] )
+    {
+        case GDL90Decoder::Heartbeat:
+        {
+            GDL90Decoder::Status status;
+
+            if( GDL90Decoder::heartbeat( pMsg, iLength, status ) )
+            {
+                m_bStratuxStatus = true;
+                m_bGPSStatus = status.bGPSValid;
+                m_gdl90Situation.iGPSFixQuality = status.bGPSValid ? 1 : 0;
+                emit newStatus( m_bStratuxStatus, m_bAHRSStatus, m_bGPSStatus, m_bTrafficStatus, m_bWeatherStatus );
+            }
+            break;
+        }
+        case GDL90Decoder::TrafficReport:
+        {
+            StratuxTraffic traffic;
+            int            iICAO = 0;
+
+            initTraffic( traffic );
+            if( GDL90Decoder::report( pMsg, iLength, iICAO, traffic ) && (iICAO > 0) )
+            {
+                trafficPosition( traffic );
+                m_bTrafficStatus = true;
+                queueTraffic( iICAO, traffic );
+            }
+            break;
+        }
+        case GDL90Decoder::OwnshipReport:
+            if( GDL90Decoder::ownship( pMsg, iLength, m_gdl90Situation ) )
+            {
+                myPosition( m_gdl90Situation );
+                queueSituation( m_gdl90Situation );
+            }
+            break;
+        case GDL90Decoder::OwnshipGeoAlt:
+            GDL90Decoder::ownshipGeoAlt( pMsg, iLength, m_gdl90Situation );
+            break;
+        case GDL90Decoder::StratuxAHRS:
+            if( GDL90Decoder::ahrs( pMsg, iLength, m_gdl90Situation ) )
+            {
+                m_bAHRSStatus = true;
+                queueSituation( m_gdl90Situation );
+            }
+            break;
+        case GDL90Decoder::Uplink:
+            // FIS-B; only the NEXRAD blocks are picked out, the text products come over the weather websocket
+            m_nexradBlocks.resize( 0 );
+            if( FISBDecoder::uplink( pMsg, iLength, m_nexradBlocks ) > 0 )
+            {
+                m_bWeatherStatus = true;
+                for( int i = 0; i < m_nexradBlocks.count(); i++ )
+                    emit newNexrad( m_nexradBlocks.at( i ) );
+            }
+            break;
+        default:
+            break;
+    }
 }
 
 
 // Updates from the status stream
+// They're few and small so they're parsed as they come in rather than queued.
 void StreamReader::statusUpdate( const QString &qsMessage )
 {
-    QStringList   qslFields( qsMessage.split( ',' ) );
-    QString       qsField;
-    QStringList   qslThisField;
-    QString       qsTag;
-    QString       qsVal;
+    qint64 iStart;
+
+    m_stats[AHRS::StatusEndpoint].arrived( qsMessage.size() );
+    iStart = StreamStats::startTiming();
+    parseStatus( qsMessage );
+    m_stats[AHRS::StatusEndpoint].parsed( iStart );
+}
+
+
+// Status stream message
+void StreamReader::parseStatus( const QString &qsMessage )
+{
+    JsonFields    fields( qsMessage );
     int           iVal;
     bool          bVal;
     StratuxStatus status;
 
     initStatus( status );
 
-    foreach( qsField, qslFields )
+    while( fields.next() )
     {
-        qslThisField = qsField.split( "\":" );
-        if( qslThisField.count() != 2 )
-            continue;
-
         // Tag and value - see https://github.com/cyoung/stratux/blob/master/notes/app-vendor-integration.md
-        qsTag = qslThisField.first().remove( 0, 1 ).trimmed().remove( '\"' );
-        qsVal = qslThisField.last().trimmed().remove( '\"' ).remove( '}' );
+        const QStringRef &qsTag = fields.tag();
+        const QStringRef &qsVal = fields.value();
+
         iVal = qsVal.toInt();
-        bVal = (qsVal == "true");
+        bVal = (qsVal == QLatin1String( "true" ));
 
-        if( qsTag == "UAT_traffic_targets_tracking" )
+        if( qsTag == QLatin1String( "UAT_traffic_targets_tracking" ) )
             status.iUATTrafficTracking = iVal;
-        else if( qsTag == "ES_traffic_targets_tracking" )
+        else if( qsTag == QLatin1String( "ES_traffic_targets_tracking" ) )
             status.iESTrafficTracking = iVal;
-        else if( qsTag == "GPS_satellites_locked" )
+        else if( qsTag == QLatin1String( "GPS_satellites_locked" ) )
             status.iGPSSatsLocked = iVal;
-        else if( qsTag == "GPS_connected" )
+        else if( qsTag == QLatin1String( "GPS_connected" ) )
             status.bGPSConnected = bVal;
-        else if( qsTag == "UAT_METAR_total" )
+        else if( qsTag == QLatin1String( "UAT_METAR_total" ) )
             status.iUATMETARTotal = iVal;
-        else if( qsTag == "UAT_TAF_total" )
+        else if( qsTag == QLatin1String( "UAT_TAF_total" ) )
             status.iUATTAFTotal = iVal;
-        else if( qsTag == "UAT_NEXRAD_total" )
+        else if( qsTag == QLatin1String( "UAT_NEXRAD_total" ) )
             status.iUATNEXRADTotal = iVal;
-        else if( qsTag == "UAT_SIGMET_total" )
+        else if( qsTag == QLatin1String( "UAT_SIGMET_total" ) )
             status.iUATSIGMETTotal = iVal;
-        else if( qsTag == "UAT_PIREP_total" )
+        else if( qsTag == QLatin1String( "UAT_PIREP_total" ) )
             status.iUATPIREPTotal = iVal;
     }
 
@@ -339,14 +786,38 @@ void StreamReader::statusUpdate( const QString &qsMessage )
 }
 
 
-// Updates from the weather stream
-void StreamReader::weatherUpdate( const QString &qsMessage )
+// FIS-B product times are just day of month, hour and minute UTC (DDHHMMZ)
+// The month and year are taken from the current date; a day later than today is from last month.
+static QDateTime fisbTime( const QStringRef &qsTime )
 {
-    QStringList    qslFields( qsMessage.split( ',' ) );
-    QString        qsField;
-    QStringList    qslThisField;
-    QString        qsTag;
-    QString        qsVal;
+    QDateTime now( QDateTime::currentDateTimeUtc() );
+    QDate     prodDate;
+    int       iDay, iHour, iMinute;
+    bool      bDay, bHour, bMinute;
+
+    if( (qsTime.length() < 6) || ((qsTime.length() > 6) && (qsTime.at( 6 ) != 'Z')) )
+        return QDateTime( QDate( 2000, 1, 1 ), QTime( 0, 0, 0 ), Qt::UTC );
+
+    iDay = qsTime.mid( 0, 2 ).toInt( &bDay );
+    iHour = qsTime.mid( 2, 2 ).toInt( &bHour );
+    iMinute = qsTime.mid( 4, 2 ).toInt( &bMinute );
+    if( (!bDay) || (!bHour) || (!bMinute) || (iDay < 1) || (iDay > 31) || (iHour > 23) || (iMinute > 59) )
+        return QDateTime( QDate( 2000, 1, 1 ), QTime( 0, 0, 0 ), Qt::UTC );
+
+    prodDate = QDate( now.date().year(), now.date().month(), 1 );
+    if( iDay > now.date().day() )
+        prodDate = prodDate.addMonths( -1 );
+    // Clamp in case the day doesn't exist in that month
+    prodDate = prodDate.addDays( qMin( iDay, prodDate.daysInMonth() ) - 1 );
+
+    return QDateTime( prodDate, QTime( iHour, iMinute, 0 ), Qt::UTC );
+}
+
+
+// Weather stream message
+void StreamReader::parseWeather( const QString &qsMessage )
+{
+    JsonFields     fields( qsMessage );
     StratuxWeather weather;
 
     initWeather( weather );
@@ -354,30 +825,26 @@ void StreamReader::weatherUpdate( const QString &qsMessage )
     // Testing only
     weather.qsLastMessage = qsMessage;
 
-    foreach( qsField, qslFields )
+    while( fields.next() )
     {
-        qslThisField = qsField.split( "\":" );
-        if( qslThisField.count() != 2 )
-            continue;
-
         // Tag and value - see https://github.com/cyoung/stratux/blob/master/notes/app-vendor-integration.md
-        qsTag = qslThisField.first().remove( 0, 1 ).trimmed().remove( '\"' );
-        qsVal = qslThisField.last().trimmed().remove( '\"' ).remove( '}' );
-
-        if( qsTag == "Type" )
-            weather.qsType = qsVal;
-        else if( qsTag == "Location" )
-            weather.qsLocation = qsVal;
-        else if( qsTag == "Time" )
-            weather.prodTime.fromString( qsVal );
-        else if( qsTag == "Data" )
-            weather.qsData = qsVal;
+        const QStringRef &qsTag = fields.tag();
+        const QStringRef &qsVal = fields.value();
+
+        if( qsTag == QLatin1String( "Type" ) )
+            weather.qsType = qsVal.toString();
+        else if( qsTag == QLatin1String( "Location" ) )
+            weather.qsLocation = qsVal.toString();
+        else if( qsTag == QLatin1String( "Time" ) )
+            weather.prodTime = fisbTime( qsVal );
+        else if( qsTag == QLatin1String( "Data" ) )
+            weather.qsData = qsVal.toString();
     }
 
     m_bStratuxStatus = true;    // If this signal fired then we're at least talking to the Stratux
     m_bWeatherStatus = true;
 
-    emit newWeather( weather );
+    emit newWeather( WeatherSnapshot( new StratuxWeather( weather ) ) );
     emit newStatus( m_bStratuxStatus, m_bAHRSStatus, m_bGPSStatus, m_bTrafficStatus, m_bWeatherStatus );
 
 }
@@ -397,27 +864,26 @@ void StreamReader::initWeather( StratuxWeather &weather )
 // Initialize the traffic struct
 void StreamReader::initTraffic( StratuxTraffic &traffic )
 {
+    static const int iNotAvailable = StringTable::intern( "N/A" );
+
     traffic.bOnGround = false;
     traffic.dLat = 0.0;
     traffic.dLong = 0.0;
     traffic.bPosValid = false;
-    traffic.dAlt = 0.0;
-    traffic.dTrack = 0.0;
-    traffic.dSpeed = 0.0;
-    traffic.dVertSpeed = false;
-    traffic.qsTail = "N/A";
-    traffic.lastSeen.setDate( QDate( 2000, 1, 1 ) );
-    traffic.lastSeen.setTime( QTime( 0, 0, 0 ) );
+    traffic.fAlt = 0.0f;
+    traffic.fTrack = 0.0f;
+    traffic.fSpeed = 0.0f;
+    traffic.fVertSpeed = 0.0f;
+    traffic.iTail = iNotAvailable;
+    traffic.iLastSeen = 0;
     traffic.iLastSource = 0;
-    traffic.qsReg = "N/A";
-    traffic.dSigLevel = 0.0;
+    traffic.iReg = iNotAvailable;
+    traffic.fSigLevel = 0.0f;
     traffic.iSquawk = 1200;
-    traffic.timestamp.setDate( QDate( 2000, 1, 1 ) );
-    traffic.timestamp.setTime( QTime( 0, 0, 0 ) );
-    traffic.iLastSource = 0;
-    traffic.dBearing = 0.0;
-    traffic.dDist = 0.0;
-    traffic.dAge = 3600.0;
+    traffic.iTimestamp = 0;
+    traffic.fBearing = 0.0f;
+    traffic.fDist = 0.0f;
+    traffic.fAge = 3600.0f;
     traffic.bHasADSB = false;
 }
 
@@ -440,8 +906,6 @@ void StreamReader::initStatus( StratuxStatus &status )
 // Initialize the situation struct
 void StreamReader::initSituation( StratuxSituation &situation )
 {
-    QDateTime nullDateTime( QDate( 2000, 1, 1 ), QTime( 0, 0, 0 ) );
-
     situation.dLastGPSFixSinceMidnight = 0.0;
     situation.dGPSlat = 0.0;
     situation.dGPSlong = 0.0;
@@ -456,20 +920,20 @@ void StreamReader::initSituation( StratuxSituation &situation )
     situation.dGPSAltMSL = 0;
     situation.dGPSVertAccuracy = 0.0;
     situation.dGPSVertSpeed = 0.0;
-    situation.lastGPSFixTime = nullDateTime;
+    situation.iLastGPSFixTime = 0;
     situation.dGPSTrueCourse = 0.0;
     situation.dGPSTurnRate = 0.0;
     situation.dGPSGroundSpeed = 0.0;
-    situation.lastGPSGroundTrackTime = nullDateTime;
-    situation.gpsDateTime = nullDateTime;
-    situation.lastGPSTimeStratuxTime = nullDateTime;
-    situation.lastValidNMEAMessageTime = nullDateTime;
-    situation.qsLastNMEAMsg = "";
+    situation.iLastGPSGroundTrackTime = 0;
+    situation.iGPSDateTime = 0;
+    situation.iLastGPSTimeStratuxTime = 0;
+    situation.iLastValidNMEAMessageTime = 0;
+    situation.qsLastNMEAMsg.clear();
     situation.iGPSPosSampleRate = 0;
     situation.dBaroTemp = 0.0;
     situation.dBaroPressAlt = 0.0;
     situation.dBaroVertSpeed = 0.0;
-    situation.lastBaroMeasTime = nullDateTime;
+    situation.iLastBaroMeasTime = 0;
     situation.dAHRSpitch = 0.0;
     situation.dAHRSroll = 0.0;
     situation.dAHRSGyroHeading = 0.0;
@@ -479,20 +943,42 @@ void StreamReader::initSituation( StratuxSituation &situation )
     situation.dAHRSGLoad = 0.0;
     situation.dAHRSGLoadMin = 0.0;
     situation.dAHRSGLoadMax = 0.0;
-    situation.lastAHRSAttTime = nullDateTime;
+    situation.iLastAHRSAttTime = 0;
     situation.iAHRSStatus = 0;
+    situation.uiChanged = AHRS::AllChanged;
 }
 
 
-void StreamReader::stratuxConnected()
+// The status stream came up or went down; the stream itself is already reconnecting if it went down
+void StreamReader::stratuxConnectionChanged( bool bConnected )
 {
-    m_bConnected = true;
+    if( m_eSource != AHRS::WebSocketSource )
+        return;
+
+    m_bConnected = bConnected;
+    if( !bConnected )
+        emit newStatus( false, false, false, false, false );
 }
 
 
-void StreamReader::stratuxDisconnected()
+// Listen for GDL90, trying again shortly if the port isn't available yet
+// The Stratux sends GDL90 to every client it hands a DHCP lease to so it just has to be listened for.
+void StreamReader::gdl90Bind()
+{
+    if( m_stratuxGDL90.state() == QAbstractSocket::BoundState )
+        return;
+
+    if( m_stratuxGDL90.bind( QHostAddress::AnyIPv4, GDL90Port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint ) )
+        m_gdl90SilenceTimer.start();
+    else
+        m_gdl90RebindTimer.start();
+}
+
+
+// Nothing has arrived on the GDL90 port for a while; there's no connection to drop so just say so until datagrams resume
+void StreamReader::gdl90Silent()
 {
-    emit newStatus( false, false, false, false, false );
     m_bConnected = false;
+    emit newStatus( false, false, false, false, false );
 }
 
@@ -0,0 +1,169 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QElapsedTimer>
+
+#include "StreamStats.h"
+
+
+#define SmoothingShift 4            // Gap and jitter smoothing weight of 1/16 like RTP (RFC 3550)
+
+
+QAtomicInt StreamStats::s_timing( 0 );
+
+
+static const int g_jitterBinLimits[StreamStats::JitterBins] = { 2, 5, 10, 25, 50, 100, 250, 0x7FFFFFFF };    // Milliseconds
+
+
+// One monotonic clock for every endpoint so gaps are comparable
+static QElapsedTimer &statsClock()
+{
+    static QElapsedTimer clock;
+
+    if( !clock.isValid() )
+        clock.start();
+
+    return clock;
+}
+
+
+StreamStats::StreamStats()
+{
+    reset();
+}
+
+
+// Count a message as it comes off the socket
+void StreamStats::arrived( int iBytes )
+{
+    m_iMessages.fetchAndAddRelaxed( 1 );
+    m_iBytes.fetchAndAddRelaxed( iBytes );
+
+    if( s_timing.load() == 0 )
+    {
+        m_iLastArrivalUs = 0;
+        return;
+    }
+
+    qint64 iNowUs = statsClock().nsecsElapsed() / 1000;
+
+    m_iTimedMessages.fetchAndAddRelaxed( 1 );
+
+    // The first message after timing is turned on only sets the reference point
+    if( m_iLastArrivalUs == 0 )
+    {
+        m_iLastArrivalUs = iNowUs;
+        return;
+    }
+
+    qint64 iGapUs = iNowUs - m_iLastArrivalUs;
+    qint64 iDevUs;
+    int    iDevMs, iBin;
+
+    m_iLastArrivalUs = iNowUs;
+    if( (iGapUs / 1000) > m_iMaxGapMs.load() )
+        m_iMaxGapMs.store( static_cast<int>( iGapUs / 1000 ) );
+
+    if( m_iMeanGapUs == 0 )
+    {
+        m_iMeanGapUs = iGapUs;
+        return;
+    }
+
+    iDevUs = qAbs( iGapUs - m_iMeanGapUs );
+    m_iMeanGapUs += (iGapUs - m_iMeanGapUs) >> SmoothingShift;
+    m_iJitterUs.store( m_iJitterUs.load() + static_cast<int>( (iDevUs - m_iJitterUs.load()) >> SmoothingShift ) );
+
+    iDevMs = static_cast<int>( qMin( iDevUs / 1000, static_cast<qint64>( 0x7FFFFFFE ) ) );
+    for( iBin = 0; iBin < (JitterBins - 1); iBin++ )
+    {
+        if( iDevMs < g_jitterBinLimits[iBin] )
+            break;
+    }
+    m_histogram[iBin].fetchAndAddRelaxed( 1 );
+}
+
+
+// Time spent parsing since iStart (from startTiming()); nothing is recorded if timing was off when it was taken
+void StreamStats::parsed( qint64 iStart, int iMessages )
+{
+    if( (iStart < 0) || (iMessages <= 0) )
+        return;
+
+    qint64 iNs = statsClock().nsecsElapsed() - iStart;
+
+    m_iParsed.fetchAndAddRelaxed( iMessages );
+    m_iParseNs.fetchAndAddRelaxed( iNs );
+    if( (iNs / iMessages) > m_iMaxParseNs.load() )
+        m_iMaxParseNs.store( iNs / iMessages );
+}
+
+
+// Copy out the current counters
+void StreamStats::counters( Counters &counters ) const
+{
+    int iBin;
+
+    counters.iMessages = m_iMessages.load();
+    counters.iBytes = m_iBytes.load();
+    counters.iTimedMessages = m_iTimedMessages.load();
+    counters.iMaxGapMs = m_iMaxGapMs.load();
+    counters.iJitterUs = m_iJitterUs.load();
+    for( iBin = 0; iBin < JitterBins; iBin++ )
+        counters.histogram[iBin] = m_histogram[iBin].load();
+    counters.iParsed = m_iParsed.load();
+    counters.iParseNs = m_iParseNs.load();
+    counters.iMaxParseNs = m_iMaxParseNs.load();
+}
+
+
+void StreamStats::reset()
+{
+    int iBin;
+
+    m_iMessages.store( 0 );
+    m_iBytes.store( 0 );
+    m_iTimedMessages.store( 0 );
+    m_iMaxGapMs.store( 0 );
+    m_iJitterUs.store( 0 );
+    for( iBin = 0; iBin < JitterBins; iBin++ )
+        m_histogram[iBin].store( 0 );
+    m_iParsed.store( 0 );
+    m_iParseNs.store( 0 );
+    m_iMaxParseNs.store( 0 );
+    m_iLastArrivalUs = 0;
+    m_iMeanGapUs = 0;
+}
+
+
+// Turn the clock reads on or off for every endpoint
+// Calls nest: timing stays on until everything that turned it on has turned it off again.
+void StreamStats::setTiming( bool bTiming )
+{
+    if( bTiming )
+    {
+        statsClock();
+        s_timing.ref();
+    }
+    else if( s_timing.load() > 0 )
+        s_timing.deref();
+}
+
+
+// Start of a parse to pass to parsed() afterwards, or -1 if timing is off
+qint64 StreamStats::startTiming()
+{
+    if( s_timing.load() == 0 )
+        return -1;
+
+    return statsClock().nsecsElapsed();
+}
+
+
+// Upper edge of a jitter histogram bin in milliseconds
+int StreamStats::jitterBinLimit( int iBin )
+{
+    return g_jitterBinLimits[qBound( 0, iBin, JitterBins - 1 )];
+}
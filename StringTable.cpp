@@ -0,0 +1,111 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include "StringTable.h"
+
+
+#define MaxStrings 65536
+
+
+QMultiHash<uint, int> StringTable::m_index;
+QVector<QString>      StringTable::m_strings;
+
+
+// Hash of a run of characters; the same for the same text whether it's UTF-16 or Latin-1
+template <typename T>
+static uint textHash( const T *pText, int iLength )
+{
+    uint uiHash = 0;
+
+    for( int i = 0; i < iLength; i++ )
+        uiHash = (uiHash * 31) + static_cast<uint>( pText[i] );
+
+    return uiHash;
+}
+
+
+// Index of a string, adding it to the table if it hasn't been seen before
+int StringTable::intern( const QString &qs )
+{
+    return intern( QStringRef( &qs ) );
+}
+
+
+// Index of part of a larger string; it's only copied out if it's new
+int StringTable::intern( const QStringRef &text )
+{
+    uint uiHash;
+    int  iIndex;
+
+    if( text.isEmpty() )
+        return 0;
+
+    uiHash = textHash( reinterpret_cast<const ushort *>( text.unicode() ), text.length() );
+    iIndex = find( text, uiHash );
+
+    return (iIndex >= 0) ? iIndex : add( text.toString(), uiHash );
+}
+
+
+// Index of Latin-1 text such as a callsign straight out of a GDL90 message
+int StringTable::intern( QLatin1String text )
+{
+    uint uiHash;
+    int  iIndex;
+
+    if( text.size() == 0 )
+        return 0;
+
+    uiHash = textHash( reinterpret_cast<const uchar *>( text.data() ), text.size() );
+    iIndex = find( text, uiHash );
+
+    return (iIndex >= 0) ? iIndex : add( QString( text ), uiHash );
+}
+
+
+// The string behind an index; anything out of range is the empty string
+const QString &StringTable::string( int iIndex )
+{
+    static const QString qsEmpty;
+
+    if( (iIndex <= 0) || (iIndex >= m_strings.count()) )
+        return qsEmpty;
+
+    return m_strings.at( iIndex );
+}
+
+
+// Index of a string already in the table with this hash or -1 if it isn't there
+template <typename T>
+int StringTable::find( const T &text, uint uiHash )
+{
+    QMultiHash<uint, int>::const_iterator it;
+
+    for( it = m_index.constFind( uiHash ); (it != m_index.constEnd()) && (it.key() == uiHash); ++it )
+    {
+        if( m_strings.at( it.value() ) == text )
+            return it.value();
+    }
+
+    return -1;
+}
+
+
+// Add a string that isn't in the table yet
+int StringTable::add( const QString &qs, uint uiHash )
+{
+    int iIndex;
+
+    if( m_strings.isEmpty() )
+        m_strings.append( QString() );
+    if( m_strings.count() >= MaxStrings )
+        return 0;
+
+    iIndex = m_strings.count();
+    m_strings.append( qs );
+    m_index.insert( uiHash, iIndex );
+
+    return iIndex;
+}
@@ -0,0 +1,532 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <math.h>
+#include <algorithm>
+
+#include "TrafficStore.h"
+
+
+#define ToRad         0.017453292519943296
+#define GridCellNM    10.0  // Size of a grid cell in nautical miles
+#define GridMaxRings  32    // Furthest ring of cells a nearest-N search will go out to
+#define MaxTrafficAge 60.0  // Anything older than this many seconds is discarded
+#define MaxDeadReckon 20.0  // Longest a target is projected forward from its last fix in seconds
+
+// Threat limits for the closest point of approach (seconds ahead, nautical miles, feet)
+#define AdvisoryTime  120.0
+#define AdvisoryHoriz 2.0
+#define AdvisoryVert  2000.0
+#define AlertTime     40.0
+#define AlertHoriz    1.0
+#define AlertVert     1000.0
+
+
+static bool targetCloser( const TrafficStore::Target &t1, const TrafficStore::Target &t2 )
+{
+    return t1.dDist < t2.dDist;
+}
+
+
+// Alerts first, then soonest closest approach, then tightest
+static bool threatFirst( const TrafficStore::Threat &t1, const TrafficStore::Threat &t2 )
+{
+    if( t1.bAlert != t2.bAlert )
+        return t1.bAlert;
+    if( t1.dTCPA != t2.dTCPA )
+        return t1.dTCPA < t2.dTCPA;
+
+    return t1.dDCPA < t2.dDCPA;
+}
+
+
+// Take a slot out of a grid cell's list
+static void removeSlot( QVector<int> &cellSlots, int iSlot )
+{
+    int iIndex = cellSlots.indexOf( iSlot );
+
+    if( iIndex >= 0 )
+        cellSlots.remove( iIndex );
+}
+
+
+TrafficStore::TrafficStore()
+    : m_iExtrapolated( 0 ),
+      m_dOwnVelX( 0.0 ),
+      m_dOwnVelY( 0.0 ),
+      m_dOwnAlt( 0.0 ),
+      m_dOwnVertSpeed( 0.0 )
+{
+}
+
+
+// Add or replace an aircraft and drop anything that has aged out
+// The fix time is in milliseconds on whatever clock is later passed to extrapolate().
+void TrafficStore::update( int iICAO, const StratuxTraffic &traffic, qint64 iFixTime )
+{
+    m_dropped.resize( 0 );
+    m_trafficMap.insert( iICAO, traffic );
+    m_received.insert( iICAO, iFixTime );
+    place( iICAO, traffic, iFixTime );
+
+    // Each time this is updated, remove old entries
+    expire( iFixTime );
+}
+
+
+// Ownship ground track (degrees true), speed (knots), altitude (feet) and vertical speed (feet per minute)
+// Traffic is projected relative to this.
+void TrafficStore::setOwnship( double dTrack, double dSpeed, double dAlt, double dVertSpeed )
+{
+    m_dOwnVelX = (dSpeed / 3600.0) * sin( dTrack * ToRad );
+    m_dOwnVelY = (dSpeed / 3600.0) * cos( dTrack * ToRad );
+    m_dOwnAlt = dAlt;
+    m_dOwnVertSpeed = dVertSpeed / 60.0;
+}
+
+
+// Dead-reckon every positioned aircraft forward from its last fix to the given time
+// The projection runs over the flat arrays with no branching on the aircraft so it's one tight pass
+// the compiler can vectorize; only the handful that drift into a different grid cell get re-bucketed after.
+// An aircraft whose last fix is older than the dead-reckoning limit loses its position instead of sitting
+// frozen where it was last projected; it stays in the traffic map until it ages out or reports again.
+void TrafficStore::extrapolate( qint64 iNow )
+{
+    m_iExtrapolated = iNow;
+    m_dropped.resize( 0 );
+    expire( iNow );
+
+    // Backwards so the slot moved into a hole has already been checked
+    for( int i = m_icao.count() - 1; i >= 0; i-- )
+    {
+        if( (iNow - m_fixTime.at( i )) > static_cast<qint64>( MaxDeadReckon * 1000.0 ) )
+        {
+            m_dropped.append( m_icao.at( i ) );
+            unplace( m_icao.at( i ) );
+        }
+    }
+
+    int           iCount = m_icao.count();
+    const qint64 *pFixTime = m_fixTime.constData();
+    const double *pFixX = m_fixX.constData();
+    const double *pFixY = m_fixY.constData();
+    const double *pVelX = m_velX.constData();
+    const double *pVelY = m_velY.constData();
+    double       *pX = m_x.data();
+    double       *pY = m_y.data();
+    double       *pDist = m_dist.data();
+    double        dOwnVelX = m_dOwnVelX;
+    double        dOwnVelY = m_dOwnVelY;
+    double        dDT;
+    quint32       uiKey;
+
+    for( int i = 0; i < iCount; i++ )
+    {
+        dDT = static_cast<double>( iNow - pFixTime[i] ) * 0.001;
+        dDT = (dDT < 0.0) ? 0.0 : ((dDT > MaxDeadReckon) ? MaxDeadReckon : dDT);
+        pX[i] = pFixX[i] + ((pVelX[i] - dOwnVelX) * dDT);
+        pY[i] = pFixY[i] + ((pVelY[i] - dOwnVelY) * dDT);
+        pDist[i] = sqrt( (pX[i] * pX[i]) + (pY[i] * pY[i]) );
+    }
+
+    for( int i = 0; i < iCount; i++ )
+    {
+        uiKey = cellKey( cellIndex( pX[i] ), cellIndex( pY[i] ) );
+        if( uiKey != m_cell.at( i ) )
+            moveToCell( i, uiKey );
+    }
+}
+
+
+void TrafficStore::clear()
+{
+    m_dropped.resize( 0 );
+    m_trafficMap.clear();
+    m_received.clear();
+    m_slotOf.clear();
+    m_icao.clear();
+    m_fixTime.clear();
+    m_fixX.clear();
+    m_fixY.clear();
+    m_velX.clear();
+    m_velY.clear();
+    m_alt.clear();
+    m_vertSpeed.clear();
+    m_x.clear();
+    m_y.clear();
+    m_dist.clear();
+    m_cell.clear();
+    m_grid.clear();
+}
+
+
+// All aircraft with a known position within the range ring, nearest first
+void TrafficStore::inRange( double dRangeNM, TargetList &targets ) const
+{
+    int    iMinCell = cellIndex( -dRangeNM );
+    int    iMaxCell = cellIndex( dRangeNM );
+    Target t;
+
+    targets.resize( 0 );
+    for( int iCellX = iMinCell; iCellX <= iMaxCell; iCellX++ )
+    {
+        for( int iCellY = iMinCell; iCellY <= iMaxCell; iCellY++ )
+        {
+            QHash<quint32, QVector<int> >::const_iterator cell = m_grid.constFind( cellKey( iCellX, iCellY ) );
+
+            if( cell == m_grid.constEnd() )
+                continue;
+
+            const QVector<int> &cellSlots = cell.value();
+
+            for( int i = 0; i < cellSlots.count(); i++ )
+            {
+                if( m_dist.at( cellSlots.at( i ) ) <= dRangeNM )
+                {
+                    target( cellSlots.at( i ), t );
+                    targets.append( t );
+                }
+            }
+        }
+    }
+    std::sort( targets.begin(), targets.end(), targetCloser );
+}
+
+
+// The closest iCount aircraft with a known position, nearest first
+// Searches outward one ring of cells at a time and stops once nothing in the next ring could be
+// closer than the furthest of the iCount found so far.
+void TrafficStore::nearest( int iCount, TargetList &targets ) const
+{
+    Target t;
+
+    targets.resize( 0 );
+    if( iCount <= 0 )
+        return;
+
+    for( int iRing = 0; iRing < GridMaxRings; iRing++ )
+    {
+        for( int iCellX = -iRing - 1; iCellX <= iRing; iCellX++ )
+        {
+            for( int iCellY = -iRing - 1; iCellY <= iRing; iCellY++ )
+            {
+                // Only the cells on the edge of this ring; the inner ones were covered already
+                if( (iCellX != (-iRing - 1)) && (iCellX != iRing) && (iCellY != (-iRing - 1)) && (iCellY != iRing) )
+                    continue;
+
+                QHash<quint32, QVector<int> >::const_iterator cell = m_grid.constFind( cellKey( iCellX, iCellY ) );
+
+                if( cell == m_grid.constEnd() )
+                    continue;
+
+                const QVector<int> &cellSlots = cell.value();
+
+                for( int i = 0; i < cellSlots.count(); i++ )
+                {
+                    target( cellSlots.at( i ), t );
+                    targets.append( t );
+                }
+            }
+        }
+        if( targets.count() == m_icao.count() )
+            break;
+        if( targets.count() >= iCount )
+        {
+            std::nth_element( targets.begin(), targets.begin() + (iCount - 1), targets.end(), targetCloser );
+            // The next ring out is at least this far away
+            if( targets.at( iCount - 1 ).dDist <= ((iRing + 1) * GridCellNM) )
+                break;
+        }
+    }
+
+    std::sort( targets.begin(), targets.end(), targetCloser );
+    if( targets.count() > iCount )
+        targets.resize( iCount );
+}
+
+
+// ICAO of the closest aircraft within the radius of a point, or -1 if there isn't one
+int TrafficStore::hitTest( double dX, double dY, double dRadiusNM ) const
+{
+    int    iMinCellX = cellIndex( dX - dRadiusNM );
+    int    iMaxCellX = cellIndex( dX + dRadiusNM );
+    int    iMinCellY = cellIndex( dY - dRadiusNM );
+    int    iMaxCellY = cellIndex( dY + dRadiusNM );
+    int    iHit = -1;
+    double dBest = dRadiusNM * dRadiusNM;
+    double dDX, dDY;
+
+    for( int iCellX = iMinCellX; iCellX <= iMaxCellX; iCellX++ )
+    {
+        for( int iCellY = iMinCellY; iCellY <= iMaxCellY; iCellY++ )
+        {
+            QHash<quint32, QVector<int> >::const_iterator cell = m_grid.constFind( cellKey( iCellX, iCellY ) );
+
+            if( cell == m_grid.constEnd() )
+                continue;
+
+            const QVector<int> &cellSlots = cell.value();
+
+            for( int i = 0; i < cellSlots.count(); i++ )
+            {
+                dDX = m_x.at( cellSlots.at( i ) ) - dX;
+                dDY = m_y.at( cellSlots.at( i ) ) - dY;
+                if( ((dDX * dDX) + (dDY * dDY)) <= dBest )
+                {
+                    dBest = (dDX * dDX) + (dDY * dDY);
+                    iHit = m_icao.at( cellSlots.at( i ) );
+                }
+            }
+        }
+    }
+
+    return iHit;
+}
+
+
+// Closest point of approach for every positioned aircraft against ownship, worst first
+// Only aircraft that come inside the advisory limits within the advisory time are returned. Uses the
+// positions from the last extrapolate(), and anything whose fix was already too old to dead-reckon at that
+// time is left out so a target that has gone quiet can't raise a threat. The CPA itself is one straight pass over the flat arrays with
+// the diverging and parallel cases handled by clamping instead of branching so it vectorizes; only the
+// handful that pass the limits are gathered into the list.
+void TrafficStore::threats( ThreatList &threats )
+{
+    int           iCount = m_icao.count();
+    const double *pX = m_x.constData();
+    const double *pY = m_y.constData();
+    const double *pVelX = m_velX.constData();
+    const double *pVelY = m_velY.constData();
+    const double *pAlt = m_alt.constData();
+    const double *pVertSpeed = m_vertSpeed.constData();
+    const qint64 *pFixTime = m_fixTime.constData();
+    qint64        iOldestFix = m_iExtrapolated - static_cast<qint64>( MaxDeadReckon * 1000.0 );
+    double       *pTCPA, *pDCPA, *pVCPA;
+    double        dOwnVelX = m_dOwnVelX;
+    double        dOwnVelY = m_dOwnVelY;
+    double        dOwnAlt = m_dOwnAlt;
+    double        dOwnVertSpeed = m_dOwnVertSpeed;
+    double        dRelVelX, dRelVelY, dSpeedSq, dT, dCPAX, dCPAY, dCPAZ;
+    Threat        threat;
+
+    m_tcpa.resize( iCount );
+    m_dcpa.resize( iCount );
+    m_vcpa.resize( iCount );
+    pTCPA = m_tcpa.data();
+    pDCPA = m_dcpa.data();
+    pVCPA = m_vcpa.data();
+
+    for( int i = 0; i < iCount; i++ )
+    {
+        dRelVelX = pVelX[i] - dOwnVelX;
+        dRelVelY = pVelY[i] - dOwnVelY;
+        dSpeedSq = (dRelVelX * dRelVelX) + (dRelVelY * dRelVelY);
+        // The tiny bias keeps the divide safe for aircraft holding station; their CPA is now anyway
+        dT = -((pX[i] * dRelVelX) + (pY[i] * dRelVelY)) / (dSpeedSq + 1.0e-12);
+        dT = (dT < 0.0) ? 0.0 : ((dT > AdvisoryTime) ? AdvisoryTime : dT);
+        dCPAX = pX[i] + (dRelVelX * dT);
+        dCPAY = pY[i] + (dRelVelY * dT);
+        dCPAZ = (pAlt[i] - dOwnAlt) + ((pVertSpeed[i] - dOwnVertSpeed) * dT);
+        pTCPA[i] = dT;
+        pDCPA[i] = sqrt( (dCPAX * dCPAX) + (dCPAY * dCPAY) );
+        pVCPA[i] = fabs( dCPAZ );
+    }
+
+    threats.resize( 0 );
+    for( int i = 0; i < iCount; i++ )
+    {
+        if( (pDCPA[i] > AdvisoryHoriz) || (pVCPA[i] > AdvisoryVert) || (pTCPA[i] >= AdvisoryTime) || (pFixTime[i] < iOldestFix) )
+            continue;
+        threat.iICAO = m_icao.at( i );
+        threat.dX = pX[i];
+        threat.dY = pY[i];
+        threat.dTCPA = pTCPA[i];
+        threat.dDCPA = pDCPA[i];
+        threat.dVCPA = pVCPA[i];
+        threat.bAlert = (pTCPA[i] <= AlertTime) && (pDCPA[i] <= AlertHoriz) && (pVCPA[i] <= AlertVert);
+        threats.append( threat );
+    }
+    std::sort( threats.begin(), threats.end(), threatFirst );
+}
+
+
+// Drop every aircraft that hasn't been heard from in too long
+// Ages go by when a report was last received here rather than the age the report carries, which is always
+// zero for GDL90 and doesn't move at all once the reports stop coming.
+void TrafficStore::expire( qint64 iNow )
+{
+    QMap<int, StratuxTraffic>::const_iterator it;
+    int                                       iFirst = m_dropped.count();
+
+    for( it = m_trafficMap.constBegin(); it != m_trafficMap.constEnd(); ++it )
+    {
+        if( (it.value().fAge > MaxTrafficAge) || ((iNow - m_received.value( it.key() )) > static_cast<qint64>( MaxTrafficAge * 1000.0 )) )
+            m_dropped.append( it.key() );
+    }
+    for( int i = iFirst; i < m_dropped.count(); i++ )
+        remove( m_dropped.at( i ) );
+}
+
+
+// Take an aircraft out of the map and the grid
+void TrafficStore::remove( int iICAO )
+{
+    m_trafficMap.remove( iICAO );
+    m_received.remove( iICAO );
+    unplace( iICAO );
+}
+
+
+// Take an aircraft out of the grid and the position arrays
+// The last slot is moved into the hole so the arrays stay packed.
+void TrafficStore::unplace( int iICAO )
+{
+    QHash<int, int>::iterator it = m_slotOf.find( iICAO );
+    int                       iSlot, iLast;
+
+    if( it == m_slotOf.end() )
+        return;
+
+    iSlot = it.value();
+    iLast = m_icao.count() - 1;
+    m_slotOf.erase( it );
+
+    QHash<quint32, QVector<int> >::iterator cell = m_grid.find( m_cell.at( iSlot ) );
+
+    if( cell != m_grid.end() )
+    {
+        removeSlot( cell.value(), iSlot );
+        if( cell.value().isEmpty() )
+            m_grid.erase( cell );
+    }
+
+    if( iSlot != iLast )
+    {
+        m_icao[iSlot] = m_icao.at( iLast );
+        m_fixTime[iSlot] = m_fixTime.at( iLast );
+        m_fixX[iSlot] = m_fixX.at( iLast );
+        m_fixY[iSlot] = m_fixY.at( iLast );
+        m_velX[iSlot] = m_velX.at( iLast );
+        m_velY[iSlot] = m_velY.at( iLast );
+        m_alt[iSlot] = m_alt.at( iLast );
+        m_vertSpeed[iSlot] = m_vertSpeed.at( iLast );
+        m_x[iSlot] = m_x.at( iLast );
+        m_y[iSlot] = m_y.at( iLast );
+        m_dist[iSlot] = m_dist.at( iLast );
+        m_cell[iSlot] = m_cell.at( iLast );
+        m_slotOf.insert( m_icao.at( iSlot ), iSlot );
+
+        QVector<int> &lastCell = m_grid[m_cell.at( iSlot )];
+
+        lastCell[lastCell.indexOf( iLast )] = iSlot;
+    }
+
+    m_icao.resize( iLast );
+    m_fixTime.resize( iLast );
+    m_fixX.resize( iLast );
+    m_fixY.resize( iLast );
+    m_velX.resize( iLast );
+    m_velY.resize( iLast );
+    m_alt.resize( iLast );
+    m_vertSpeed.resize( iLast );
+    m_x.resize( iLast );
+    m_y.resize( iLast );
+    m_dist.resize( iLast );
+    m_cell.resize( iLast );
+}
+
+
+// Record an aircraft's fix and velocity and put it in the grid cell for its position relative to ownship
+// Only aircraft that had their bearing and distance calculated have a position.
+void TrafficStore::place( int iICAO, const StratuxTraffic &traffic, qint64 iFixTime )
+{
+    QHash<int, int>::const_iterator it = m_slotOf.constFind( iICAO );
+    int                             iSlot;
+    double                          dSpeed = traffic.bOnGround ? 0.0 : (traffic.fSpeed / 3600.0);
+    double                          dX = traffic.fDist * sin( traffic.fBearing * ToRad );
+    double                          dY = traffic.fDist * cos( traffic.fBearing * ToRad );
+    quint32                         uiKey = cellKey( cellIndex( dX ), cellIndex( dY ) );
+
+    if( !traffic.bHasADSB )
+    {
+        unplace( iICAO );
+        return;
+    }
+
+    if( it == m_slotOf.constEnd() )
+    {
+        iSlot = m_icao.count();
+        m_icao.append( iICAO );
+        m_fixTime.append( iFixTime );
+        m_fixX.append( dX );
+        m_fixY.append( dY );
+        m_velX.append( 0.0 );
+        m_velY.append( 0.0 );
+        m_alt.append( 0.0 );
+        m_vertSpeed.append( 0.0 );
+        m_x.append( dX );
+        m_y.append( dY );
+        m_dist.append( traffic.fDist );
+        m_cell.append( uiKey );
+        m_slotOf.insert( iICAO, iSlot );
+        m_grid[uiKey].append( iSlot );
+    }
+    else
+    {
+        iSlot = it.value();
+        m_fixTime[iSlot] = iFixTime;
+        m_fixX[iSlot] = dX;
+        m_fixY[iSlot] = dY;
+        m_x[iSlot] = dX;
+        m_y[iSlot] = dY;
+        m_dist[iSlot] = traffic.fDist;
+        if( m_cell.at( iSlot ) != uiKey )
+            moveToCell( iSlot, uiKey );
+    }
+    m_velX[iSlot] = dSpeed * sin( traffic.fTrack * ToRad );
+    m_velY[iSlot] = dSpeed * cos( traffic.fTrack * ToRad );
+    m_alt[iSlot] = traffic.fAlt;
+    m_vertSpeed[iSlot] = traffic.bOnGround ? 0.0 : (traffic.fVertSpeed / 60.0);
+}
+
+
+// Move a slot from its current grid cell to another one
+void TrafficStore::moveToCell( int iSlot, quint32 uiKey )
+{
+    QHash<quint32, QVector<int> >::iterator cell = m_grid.find( m_cell.at( iSlot ) );
+
+    if( cell != m_grid.end() )
+    {
+        removeSlot( cell.value(), iSlot );
+        if( cell.value().isEmpty() )
+            m_grid.erase( cell );
+    }
+    m_grid[uiKey].append( iSlot );
+    m_cell[iSlot] = uiKey;
+}
+
+
+// Current position of the aircraft in a slot
+void TrafficStore::target( int iSlot, Target &t ) const
+{
+    t.iICAO = m_icao.at( iSlot );
+    t.dX = m_x.at( iSlot );
+    t.dY = m_y.at( iSlot );
+    t.dDist = m_dist.at( iSlot );
+}
+
+
+// Pack signed cell indices into a hash key
+quint32 TrafficStore::cellKey( int iCellX, int iCellY ) const
+{
+    return (static_cast<quint32>( iCellX & 0xFFFF ) << 16) | static_cast<quint32>( iCellY & 0xFFFF );
+}
+
+
+// Which cell along one axis a position falls in
+int TrafficStore::cellIndex( double dPos ) const
+{
+    return static_cast<int>( floor( dPos / GridCellNM ) );
+}
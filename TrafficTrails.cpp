@@ -0,0 +1,181 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <math.h>
+
+#include "TrafficTrails.h"
+
+
+#define ToRad         0.017453292519943296
+#define MaxTrails     64        // Aircraft with a trail at any one time
+#define TrailPoints   32        // Positions kept per aircraft
+#define TrailSpacing  2000      // Milliseconds between recorded positions
+#define TrailSpan     300000    // Positions older than this (milliseconds) are dropped
+
+
+TrafficTrails::TrafficTrails()
+{
+    Trail trail;
+
+    trail.iICAO = -1;
+    trail.iStart = 0;
+    trail.iCount = 0;
+    trail.iLastTime = 0;
+
+    m_trails.fill( trail, MaxTrails );
+    m_pool.resize( MaxTrails * TrailPoints );
+    m_trailOf.reserve( MaxTrails );
+    m_free.reserve( MaxTrails );
+    clear();
+}
+
+
+// Record a position for an aircraft; the time is in milliseconds
+// Positions closer together than the trail spacing are ignored so a trail covers a useful length of time.
+void TrafficTrails::add( int iICAO, const StratuxTraffic &traffic, qint64 iTime )
+{
+    QHash<int, int>::const_iterator it = m_trailOf.constFind( iICAO );
+    int                             iTrail;
+
+    if( (!traffic.bPosValid) || traffic.bOnGround )
+        return;
+
+    if( it == m_trailOf.constEnd() )
+        iTrail = allocate( iICAO );
+    else
+        iTrail = it.value();
+
+    Trail &trail = m_trails[iTrail];
+
+    if( (trail.iCount > 0) && ((iTime - point( iTrail, trail.iCount - 1 ).iTime) < TrailSpacing) )
+        return;
+
+    // Age off the oldest end of the ring
+    while( (trail.iCount > 0) && ((iTime - point( iTrail, 0 ).iTime) > TrailSpan) )
+    {
+        trail.iStart = (trail.iStart + 1) % TrailPoints;
+        trail.iCount--;
+    }
+
+    if( trail.iCount == TrailPoints )
+        decimate( iTrail );
+
+    TrailPoint &newPoint = point( iTrail, trail.iCount );
+
+    newPoint.iTime = iTime;
+    newPoint.dLat = traffic.dLat;
+    newPoint.dLong = traffic.dLong;
+    trail.iCount++;
+    trail.iLastTime = iTime;
+}
+
+
+// Free up an aircraft's trail
+void TrafficTrails::remove( int iICAO )
+{
+    QHash<int, int>::iterator it = m_trailOf.find( iICAO );
+
+    if( it == m_trailOf.end() )
+        return;
+
+    m_trails[it.value()].iICAO = -1;
+    m_trails[it.value()].iCount = 0;
+    m_free.append( it.value() );
+    m_trailOf.erase( it );
+}
+
+
+void TrafficTrails::clear()
+{
+    m_trailOf.clear();
+    m_free.resize( 0 );
+    for( int i = MaxTrails - 1; i >= 0; i-- )
+    {
+        m_trails[i].iICAO = -1;
+        m_trails[i].iCount = 0;
+        m_free.append( i );
+    }
+}
+
+
+// An aircraft's trail, oldest first, as nautical miles east (X) and north (Y) of ownship
+// Returns false if there's no trail for the aircraft.
+bool TrafficTrails::relative( int iICAO, double dOwnLat, double dOwnLong, QVector<QPointF> &points ) const
+{
+    QHash<int, int>::const_iterator it = m_trailOf.constFind( iICAO );
+    double                          dLongScale = 60.0 * cos( dOwnLat * ToRad );
+
+    points.resize( 0 );
+    if( it == m_trailOf.constEnd() )
+        return false;
+
+    const Trail &trail = m_trails.at( it.value() );
+    const TrailPoint *pPoints = m_pool.constData() + (it.value() * TrailPoints);
+    int               iIndex;
+
+    // Flat earth is plenty accurate over the range of the heading indicator
+    for( int i = 0; i < trail.iCount; i++ )
+    {
+        iIndex = (trail.iStart + i) % TrailPoints;
+        points.append( QPointF( (pPoints[iIndex].dLong - dOwnLong) * dLongScale, (pPoints[iIndex].dLat - dOwnLat) * 60.0 ) );
+    }
+
+    return (trail.iCount > 0);
+}
+
+
+// Hand out a free trail for an aircraft, taking over the stalest one if there are none left
+int TrafficTrails::allocate( int iICAO )
+{
+    int iTrail = 0;
+
+    if( m_free.isEmpty() )
+    {
+        for( int i = 1; i < MaxTrails; i++ )
+        {
+            if( m_trails.at( i ).iLastTime < m_trails.at( iTrail ).iLastTime )
+                iTrail = i;
+        }
+        m_trailOf.remove( m_trails.at( iTrail ).iICAO );
+    }
+    else
+    {
+        iTrail = m_free.last();
+        m_free.resize( m_free.count() - 1 );
+    }
+
+    m_trails[iTrail].iICAO = iICAO;
+    m_trails[iTrail].iStart = 0;
+    m_trails[iTrail].iCount = 0;
+    m_trailOf.insert( iICAO, iTrail );
+
+    return iTrail;
+}
+
+
+// Drop every other point in the older half of a full trail to make room
+// Applied over and over the older track ends up sparser the older it gets.
+void TrafficTrails::decimate( int iTrail )
+{
+    int iCount = m_trails.at( iTrail ).iCount;
+    int iKeep = 0;
+
+    for( int i = 0; i < iCount; i++ )
+    {
+        if( (i < (TrailPoints / 2)) && ((i % 2) == 1) )
+            continue;
+        if( iKeep != i )
+            point( iTrail, iKeep ) = point( iTrail, i );
+        iKeep++;
+    }
+    m_trails[iTrail].iCount = iKeep;
+}
+
+
+// Point by position in a trail where zero is the oldest
+TrafficTrails::TrailPoint &TrafficTrails::point( int iTrail, int iIndex )
+{
+    return m_pool[(iTrail * TrailPoints) + ((m_trails.at( iTrail ).iStart + iIndex) % TrailPoints)];
+}
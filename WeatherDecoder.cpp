@@ -0,0 +1,258 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <string.h>
+
+#include "WeatherDecoder.h"
+
+
+#define MetersPerSM 1609.344
+#define KtsPerMPS   1.943844
+
+
+// Whether a run of characters are all digits
+static bool allDigits( const char *pStart, int iLength )
+{
+    if( iLength <= 0 )
+        return false;
+    for( int i = 0; i < iLength; i++ )
+    {
+        if( (pStart[i] < '0') || (pStart[i] > '9') )
+            return false;
+    }
+
+    return true;
+}
+
+
+// Value of a run of digits (the caller has already checked they are digits)
+static int digits( const char *pStart, int iLength )
+{
+    int iVal = 0;
+
+    for( int i = 0; i < iLength; i++ )
+        iVal = (iVal * 10) + (pStart[i] - '0');
+
+    return iVal;
+}
+
+
+// Whether a group starts with a given prefix
+static bool startsWith( const char *pGroup, int iLength, const char *pPrefix )
+{
+    int iPrefixLen = static_cast<int>( strlen( pPrefix ) );
+
+    return (iLength >= iPrefixLen) && (strncmp( pGroup, pPrefix, iPrefixLen ) == 0);
+}
+
+
+void WeatherDecoder::decode( const QByteArray &data, Decoded &decoded )
+{
+    decode( data.constData(), data.size(), decoded );
+}
+
+
+// Walk the groups and pick out the ones we care about
+// A lone whole number is held on to in case the next group is the fraction of a visibility like "1 1/2SM".
+void WeatherDecoder::decode( const char *pData, int iLength, Decoded &decoded )
+{
+    const char *pGroup;
+    int         iPos = 0, iGroupLen;
+    double      dWhole = 0.0;
+    bool        bFirst = true;
+
+    decoded.bValid = false;
+    decoded.iWindDir = -1;
+    decoded.iWindSpeed = -1;
+    decoded.iWindGust = -1;
+    decoded.dVisibility = -1.0;
+    decoded.iCeiling = -1;
+    decoded.eCategory = UnknownCategory;
+
+    while( iPos < iLength )
+    {
+        while( (iPos < iLength) && ((pData[iPos] == ' ') || (pData[iPos] == '\n') || (pData[iPos] == '\r')) )
+            iPos++;
+        pGroup = pData + iPos;
+        while( (iPos < iLength) && (pData[iPos] != ' ') && (pData[iPos] != '\n') && (pData[iPos] != '\r') )
+            iPos++;
+        iGroupLen = static_cast<int>( (pData + iPos) - pGroup );
+        if( iGroupLen == 0 )
+            break;
+
+        // Remarks end the observation and change groups end the TAF base forecast
+        if( startsWith( pGroup, iGroupLen, "RMK" ) || startsWith( pGroup, iGroupLen, "FM" ) ||
+            startsWith( pGroup, iGroupLen, "BECMG" ) || startsWith( pGroup, iGroupLen, "TEMPO" ) ||
+            startsWith( pGroup, iGroupLen, "PROB" ) )
+        {
+            // Except FM as the station identifier of, say, a Malagasy airport
+            if( !bFirst )
+                break;
+        }
+        bFirst = false;
+
+        if( (iGroupLen == 1) && allDigits( pGroup, 1 ) )
+        {
+            dWhole = digits( pGroup, 1 );
+            continue;
+        }
+        if( (iGroupLen == 5) && (strncmp( pGroup, "CAVOK", 5 ) == 0) )
+        {
+            decoded.dVisibility = 10.0;
+            decoded.bValid = true;
+        }
+        else if( wind( pGroup, iGroupLen, decoded ) || visibility( pGroup, iGroupLen, dWhole, decoded ) || cloud( pGroup, iGroupLen, decoded ) )
+            decoded.bValid = true;
+        dWhole = 0.0;
+    }
+
+    categorize( decoded );
+}
+
+
+// dddssKT, dddssGggKT, VRBssKT or the same in MPS
+bool WeatherDecoder::wind( const char *pGroup, int iLength, Decoded &decoded )
+{
+    double dScale = 1.0;
+    int    iUnitLen = 2;
+    int    iGust;
+
+    if( (iLength >= 7) && (strncmp( pGroup + iLength - 2, "KT", 2 ) == 0) )
+        dScale = 1.0;
+    else if( (iLength >= 8) && (strncmp( pGroup + iLength - 3, "MPS", 3 ) == 0) )
+    {
+        dScale = KtsPerMPS;
+        iUnitLen = 3;
+    }
+    else
+        return false;
+
+    if( (!allDigits( pGroup, 3 )) && (strncmp( pGroup, "VRB", 3 ) != 0) )
+        return false;
+
+    // Speed is two or three digits, then maybe a G and the gust
+    iGust = 3;
+    while( (iGust < (iLength - iUnitLen)) && (pGroup[iGust] != 'G') )
+        iGust++;
+    if( ((iGust - 3) < 2) || ((iGust - 3) > 3) || (!allDigits( pGroup + 3, iGust - 3 )) )
+        return false;
+
+    decoded.iWindDir = allDigits( pGroup, 3 ) ? digits( pGroup, 3 ) : -1;
+    decoded.iWindSpeed = static_cast<int>( (digits( pGroup + 3, iGust - 3 ) * dScale) + 0.5 );
+    if( iGust < (iLength - iUnitLen) )
+    {
+        if( !allDigits( pGroup + iGust + 1, iLength - iUnitLen - iGust - 1 ) )
+            return false;
+        decoded.iWindGust = static_cast<int>( (digits( pGroup + iGust + 1, iLength - iUnitLen - iGust - 1 ) * dScale) + 0.5 );
+    }
+
+    return true;
+}
+
+
+// 10SM, P6SM, M1/4SM, 1/2SM (after an optional whole number group) or four digits of meters
+bool WeatherDecoder::visibility( const char *pGroup, int iLength, double dWhole, Decoded &decoded )
+{
+    const char *pSlash;
+    int         iNumLen;
+
+    if( (iLength == 4) && allDigits( pGroup, 4 ) )
+    {
+        // 9999 means 10 km or more which is as good as unlimited
+        decoded.dVisibility = (digits( pGroup, 4 ) == 9999) ? 10.0 : (digits( pGroup, 4 ) / MetersPerSM);
+        return true;
+    }
+
+    if( (iLength < 3) || (strncmp( pGroup + iLength - 2, "SM", 2 ) != 0) )
+        return false;
+
+    // Plus or minus just mean more or less than what follows
+    if( (pGroup[0] == 'P') || (pGroup[0] == 'M') )
+    {
+        pGroup++;
+        iLength--;
+    }
+    iNumLen = iLength - 2;
+
+    pSlash = static_cast<const char *>( memchr( pGroup, '/', iNumLen ) );
+    if( pSlash == 0 )
+    {
+        if( !allDigits( pGroup, iNumLen ) )
+            return false;
+        decoded.dVisibility = digits( pGroup, iNumLen );
+    }
+    else
+    {
+        int iNumLenTop = static_cast<int>( pSlash - pGroup );
+        int iNumLenBottom = iNumLen - iNumLenTop - 1;
+
+        if( (!allDigits( pGroup, iNumLenTop )) || (!allDigits( pSlash + 1, iNumLenBottom )) || (digits( pSlash + 1, iNumLenBottom ) == 0) )
+            return false;
+        decoded.dVisibility = dWhole + (static_cast<double>( digits( pGroup, iNumLenTop ) ) / digits( pSlash + 1, iNumLenBottom ));
+    }
+
+    return true;
+}
+
+
+// Cloud layers; only broken, overcast and vertical visibility make a ceiling
+bool WeatherDecoder::cloud( const char *pGroup, int iLength, Decoded &decoded )
+{
+    int iHeight;
+
+    if( (iLength == 3) && ((strncmp( pGroup, "SKC", 3 ) == 0) || (strncmp( pGroup, "CLR", 3 ) == 0) || (strncmp( pGroup, "NSC", 3 ) == 0)) )
+        return true;
+
+    if( (iLength >= 5) && (strncmp( pGroup, "VV", 2 ) == 0) && allDigits( pGroup + 2, 3 ) )
+        iHeight = digits( pGroup + 2, 3 ) * 100;
+    else if( (iLength >= 6) && allDigits( pGroup + 3, 3 ) &&
+             ((strncmp( pGroup, "BKN", 3 ) == 0) || (strncmp( pGroup, "OVC", 3 ) == 0)) )
+        iHeight = digits( pGroup + 3, 3 ) * 100;
+    else if( (iLength >= 6) && allDigits( pGroup + 3, 3 ) &&
+             ((strncmp( pGroup, "FEW", 3 ) == 0) || (strncmp( pGroup, "SCT", 3 ) == 0)) )
+        return true;
+    else
+        return false;
+
+    if( (decoded.iCeiling < 0) || (iHeight < decoded.iCeiling) )
+        decoded.iCeiling = iHeight;
+
+    return true;
+}
+
+
+// FAA flight categories; whichever of ceiling or visibility is worse decides
+void WeatherDecoder::categorize( Decoded &decoded )
+{
+    FlightCategory eCeiling = VFR;
+    FlightCategory eVis = VFR;
+
+    if( (decoded.dVisibility < 0.0) && (decoded.iCeiling < 0) )
+    {
+        decoded.eCategory = UnknownCategory;
+        return;
+    }
+
+    if( decoded.iCeiling >= 0 )
+    {
+        if( decoded.iCeiling < 500 )
+            eCeiling = LIFR;
+        else if( decoded.iCeiling < 1000 )
+            eCeiling = IFR;
+        else if( decoded.iCeiling <= 3000 )
+            eCeiling = MVFR;
+    }
+    if( decoded.dVisibility >= 0.0 )
+    {
+        if( decoded.dVisibility < 1.0 )
+            eVis = LIFR;
+        else if( decoded.dVisibility < 3.0 )
+            eVis = IFR;
+        else if( decoded.dVisibility <= 5.0 )
+            eVis = MVFR;
+    }
+
+    decoded.eCategory = (eCeiling > eVis) ? eCeiling : eVis;
+}
@@ -0,0 +1,223 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <algorithm>
+
+#include "WeatherStore.h"
+
+
+#define MaxProducts   1000      // Most products held at once
+#define MaxProductAge 7200000   // Products not heard in this long (milliseconds) are dropped when room is needed
+
+
+// Sort order for station lists
+static bool productBefore( const WeatherStore::Product *pProduct1, const WeatherStore::Product *pProduct2 )
+{
+    return pProduct1->location < pProduct2->location;
+}
+
+
+WeatherStore::WeatherStore()
+    : m_iLatest( -1 ),
+      m_iDuplicates( 0 )
+{
+    m_products.reserve( MaxProducts );
+    m_index.reserve( MaxProducts );
+}
+
+
+// Add a product or replace the one held for the same type and station if this one is newer
+// The receive time is in milliseconds since the epoch.
+WeatherStore::InsertResult WeatherStore::insert( const StratuxWeather &weather, qint64 iReceived )
+{
+    QByteArray                             type( weather.qsType.toLatin1() );
+    QByteArray                             location( weather.qsLocation.toLatin1() );
+    QByteArray                             data( weather.qsData.toLatin1() );
+    qint64                                 iProdTime = weather.prodTime.toMSecsSinceEpoch();
+    uint                                   uiDataHash = qHash( data );
+    QHash<QByteArray, int>::const_iterator it = m_index.constFind( key( type, location ) );
+    Product                               *pProduct;
+
+    if( it != m_index.constEnd() )
+    {
+        pProduct = &m_products[it.value()];
+        if( (iProdTime == pProduct->iProdTime) && (uiDataHash == pProduct->uiDataHash) && (data == pProduct->data) )
+        {
+            pProduct->iReceived = iReceived;
+            m_iDuplicates++;
+            return Duplicate;
+        }
+        if( iProdTime < pProduct->iProdTime )
+            return Older;
+
+        pProduct->data = data;
+        pProduct->iProdTime = iProdTime;
+        pProduct->iReceived = iReceived;
+        pProduct->uiDataHash = uiDataHash;
+        decode( *pProduct );
+        m_iLatest = it.value();
+        return Replaced;
+    }
+
+    if( m_products.count() >= MaxProducts )
+        evict();
+
+    Product product;
+
+    product.type = type;
+    product.location = location;
+    product.data = data;
+    product.iProdTime = iProdTime;
+    product.iReceived = iReceived;
+    product.uiDataHash = uiDataHash;
+    decode( product );
+    m_products.append( product );
+    m_iLatest = m_products.count() - 1;
+    m_index.insert( key( type, location ), m_iLatest );
+
+    return Added;
+}
+
+
+void WeatherStore::clear()
+{
+    m_products.clear();
+    m_index.clear();
+    m_iLatest = -1;
+    m_iDuplicates = 0;
+}
+
+
+// The product held for a type and station or null if there isn't one
+const WeatherStore::Product *WeatherStore::find( const QString &qsType, const QString &qsLocation ) const
+{
+    QHash<QByteArray, int>::const_iterator it = m_index.constFind( key( qsType.toLatin1(), qsLocation.toLatin1() ) );
+
+    if( it == m_index.constEnd() )
+        return 0;
+
+    return &m_products.at( it.value() );
+}
+
+
+// The product most recently added or updated (not just heard again) or null if there are none
+const WeatherStore::Product *WeatherStore::latest() const
+{
+    if( m_iLatest < 0 )
+        return 0;
+
+    return &m_products.at( m_iLatest );
+}
+
+
+// Every product of one type, in no particular order
+void WeatherStore::products( const QString &qsType, ProductList &products ) const
+{
+    QByteArray type( qsType.toLatin1() );
+
+    products.resize( 0 );
+    for( int i = 0; i < m_products.count(); i++ )
+    {
+        if( m_products.at( i ).type == type )
+            products.append( &m_products.at( i ) );
+    }
+}
+
+
+// The latest decoded METAR or SPECI for every station sorted by station
+void WeatherStore::observations( ProductList &products ) const
+{
+    QHash<QByteArray, int>::const_iterator other;
+
+    products.resize( 0 );
+    for( int i = 0; i < m_products.count(); i++ )
+    {
+        const Product &product = m_products.at( i );
+
+        if( (!product.decoded.bValid) || ((product.type != "METAR") && (product.type != "SPECI")) )
+            continue;
+
+        // Only the newer of the routine and special observation for a station
+        other = m_index.constFind( key( (product.type == "METAR") ? "SPECI" : "METAR", product.location ) );
+        if( (other != m_index.constEnd()) && m_products.at( other.value() ).decoded.bValid )
+        {
+            const Product &otherProduct = m_products.at( other.value() );
+
+            if( (otherProduct.iProdTime > product.iProdTime) || ((otherProduct.iProdTime == product.iProdTime) && (product.type == "METAR")) )
+                continue;
+        }
+        products.append( &product );
+    }
+    std::sort( products.begin(), products.end(), productBefore );
+}
+
+
+// Take a product out; the last product is moved into the hole so the list stays packed
+void WeatherStore::remove( int iIndex )
+{
+    int iLast = m_products.count() - 1;
+
+    m_index.remove( key( m_products.at( iIndex ).type, m_products.at( iIndex ).location ) );
+    if( iIndex != iLast )
+    {
+        m_products[iIndex] = m_products.at( iLast );
+        m_index.insert( key( m_products.at( iIndex ).type, m_products.at( iIndex ).location ), iIndex );
+    }
+    m_products.resize( iLast );
+
+    if( m_iLatest == iIndex )
+        m_iLatest = -1;
+    else if( m_iLatest == iLast )
+        m_iLatest = iIndex;
+}
+
+
+// Make room when the store is full
+// Everything that hasn't been heard in a long time goes; if nothing has gone stale the product heard
+// least recently is dropped instead.
+void WeatherStore::evict()
+{
+    qint64 iNewest = 0;
+    int    iOldest = 0;
+
+    for( int i = 0; i < m_products.count(); i++ )
+        iNewest = qMax( iNewest, m_products.at( i ).iReceived );
+
+    for( int i = m_products.count() - 1; i >= 0; i-- )
+    {
+        if( (iNewest - m_products.at( i ).iReceived) > MaxProductAge )
+            remove( i );
+    }
+
+    if( m_products.count() < MaxProducts )
+        return;
+
+    for( int i = 1; i < m_products.count(); i++ )
+    {
+        if( m_products.at( i ).iReceived < m_products.at( iOldest ).iReceived )
+            iOldest = i;
+    }
+    remove( iOldest );
+}
+
+
+// Decode the text of the products that have a decoder
+void WeatherStore::decode( Product &product ) const
+{
+    if( (product.type == "METAR") || (product.type == "SPECI") || product.type.startsWith( "TAF" ) )
+        WeatherDecoder::decode( product.data, product.decoded );
+    else
+    {
+        product.decoded.bValid = false;
+        product.decoded.eCategory = WeatherDecoder::UnknownCategory;
+    }
+}
+
+
+// Hash key for a type and station
+QByteArray WeatherStore::key( const QByteArray &type, const QByteArray &location ) const
+{
+    return type + '/' + location;
+}
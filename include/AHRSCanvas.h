@@ -9,16 +9,38 @@ Stratux AHRS Display
 #include <QWidget>
 #include <QPixmap>
 #include <QMap>
+#include <QVector>
+#include <QPointF>
+#include <QPolygon>
+#include <QPolygonF>
+#include <QElapsedTimer>
+#include <QFont>
+#include <QPen>
+#include <QBrush>
+#include <QImage>
+#include <QTransform>
 
 #include "StratuxStreams.h"
 #include "Canvas.h"
+#include "TrafficStore.h"
+#include "TrafficTrails.h"
+#include "WeatherStore.h"
+#include "NexradCache.h"
+#include "AttitudePredictor.h"
+#include "MetricsServer.h"
+#include "GlyphAtlas.h"
 #include "AppDefs.h"
 
 
+// Number of altitude color bands traffic is sorted into
+#define TRAFFIC_ALT_BANDS 11
+
+
 class QDial;
+class QPainter;
 
 
-class AHRSCanvas : public QWidget
+class AHRSCanvas : public QWidget, public MetricsSource
 {
     Q_OBJECT
 
@@ -29,12 +51,18 @@ public:
     void trafficToggled( AHRS::TrafficDisp eDispType );
     void weatherToggled();
     void suspend( bool bSuspend );
+    void metrics( MetricsWriter &writer ) const;
+    void paintFrame( QPainter *pAhrs );
+    void setClock( qint64 iTime ) { m_iClock = iTime; }
+    void setAttitudeHorizon( int iHorizonMs ) { m_predictor.setHorizon( iHorizonMs ); }
+    bool isInitialized() const { return m_bInitialized; }
 
 public slots:
     void init();
-    void situation( StratuxSituation s );
-    void traffic( int iICAO, StratuxTraffic t );
-    void weather( StratuxWeather w );
+    void situation( SituationSnapshot pSituation );
+    void traffic( TrafficSnapshot pBatch );
+    void weather( WeatherSnapshot pWeather );
+    void nexrad( NexradBlock block );
 
 protected:
     void resizeEvent( QResizeEvent *pEvent );
@@ -45,18 +73,28 @@ protected:
 
 private:
     void   updateTraffic( QPainter *pAhrs, double dListPos );
+    void   updateFrameTimer();
+    qint64 now() const;
+    void   initPaintTools();
+    void   buildWeatherText();
+    void   buildGPSText();
+    void   buildIdentText();
 
     Canvas *m_pCanvas;
 
     bool                      m_bInitialized;
     StratuxSituation          m_situation;
-    StratuxWeather            m_weather;
-    QMap<int, StratuxTraffic> m_trafficMap;
+    WeatherStore              m_weatherStore;
+    NexradCache               m_nexrad;
+    TrafficStore              m_trafficStore;
+    TrafficTrails             m_trafficTrails;
+    AttitudePredictor         m_predictor;
     QPixmap                   m_planeIcon;
     QPixmap                   m_headIcon;
     QPixmap                   m_windIcon;
     int                       m_iHeadBugAngle;
     int                       m_iWindBugAngle;
+    int                       m_iAltBug;
     QPixmap                  *m_pRollIndicator;
     QPixmap                  *m_pHeadIndicator;
     QPixmap                  *m_pAltTape;
@@ -65,10 +103,87 @@ private:
     QPixmap                   m_trafficAltKey;
     AHRS::TrafficDisp         m_eTrafficDisp;
     bool                      m_bHideGPSLocation;
-    bool                      m_iDispTimer;
+    int                       m_iDispTimer;
+    int                       m_iFrameTimer;
     bool                      m_bUpdated;
     bool                      m_bShowWeather;
     bool                      m_bShowGPSDetails;
+    int                       m_iIdentICAO;
+    QVector<QPointF>          m_trafficPoints[TRAFFIC_ALT_BANDS];
+    QVector<QPointF>          m_trafficMarkers[TRAFFIC_ALT_BANDS];
+    TrafficStore::TargetList  m_visibleTraffic;
+    TrafficStore::ThreatList  m_threats;
+    QVector<QPointF>          m_trailPoints;
+    QPolygonF                 m_trailLine;
+    WeatherStore::ProductList m_weatherList;
+
+    // Recent AHRS samples replayed at other leads on the GPS details page
+    AttitudePredictor::SampleList m_replaySamples;
+
+    // Paint timing for the metrics endpoint
+    QElapsedTimer             m_frameTime;
+    qint64                    m_iFrames;
+    qint64                    m_iFrameNs;
+    qint64                    m_iMaxFrameNs;
+    qint64                    m_iFrameAllocs;   // Only counted when built with alloc_tracking
+    qint64                    m_iMaxFrameAllocs;
+    qint64                    m_iClock;         // Fixed time in ms since the epoch for offscreen rendering; 0 for the real time
+
+    // Fonts, pens, brushes and scratch geometry built once and reused so a frame doesn't allocate
+    // The painter holds on to whatever it was last given so these are never modified while painting.
+    QFont                     m_tinyFont;
+    QFont                     m_smallFont;
+    QFont                     m_medFont;
+    QFont                     m_largeFont;
+    QFont                     m_trafficFont;
+    QPen                      m_blackPen;
+    QPen                      m_linePen;        // Black 3 px; horizon and overlay borders
+    QPen                      m_skyLadderPen;
+    QPen                      m_groundLadderPen;
+    QPen                      m_framePen;       // White 5 px; boxes around the tapes and readouts
+    QPen                      m_alertPen;
+    QPen                      m_advisoryPen;
+    QPen                      m_bandTrailPens[TRAFFIC_ALT_BANDS];
+    QPen                      m_bandDotPens[TRAFFIC_ALT_BANDS];
+    QPen                      m_bandMarkerPens[TRAFFIC_ALT_BANDS];
+    QPen                      m_categoryPens[WeatherDecoder::LIFR + 1];
+    QBrush                    m_blackBrush;
+    QBrush                    m_whiteBrush;
+    QBrush                    m_yellowBrush;
+    QBrush                    m_cloudyBrush;
+    QBrush                    m_skyBrush;       // Vertical gradients from 0 to 1; stretched over the area to fill
+    QBrush                    m_groundBrush;
+    QBrush                    m_trafficListBrush;
+    QImage                    m_radarDial;      // NEXRAD turned onto the dial; clear outside the circle
+    QTransform                m_dial;           // NM east/north of ownship to the screen over the heading indicator
+    QPolygon                  m_shape;
+    QPolygonF                 m_arrow;
+    int                       m_iTrafficListWidth;
+
+    // Text drawn on every frame comes from glyphs rendered once for each font and color it's drawn in
+    GlyphAtlas                m_largeGlyphs;    // White
+    GlyphAtlas                m_smallGlyphs;    // White
+    GlyphAtlas                m_positionGlyphs; // Green; lat/long
+    GlyphAtlas                m_tinyGlyphs;     // White
+    GlyphAtlas                m_alertGlyphs;
+    GlyphAtlas                m_advisoryGlyphs;
+    GlyphAtlas                m_bandGlyphs[TRAFFIC_ALT_BANDS];
+
+    // Readouts are formatted in place into strings with room reserved up front
+    QString                   m_qsHead;
+    QString                   m_qsAlt;
+    QString                   m_qsSpeed;
+    QString                   m_qsLat;
+    QString                   m_qsLong;
+    QString                   m_qsThreat;
+    int                       m_iHead;
+    int                       m_iHeadWidth;
+
+    // Overlay page text, built when what a page shows changes rather than every frame it's up
+    QVector<QString>          m_weatherText;
+    QVector<int>              m_weatherCategories;  // Flight category of each weather line
+    QVector<QString>          m_gpsText;
+    QVector<QString>          m_identText;
 
 signals:
     void simpleStatus( bool, bool, bool, bool ); // Stratux connected, Weather available, AHRS situation available, Traffic available, GPS position available
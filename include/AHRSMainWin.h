@@ -14,6 +14,7 @@ Stratux AHRS Display
 
 
 class StreamReader;
+class MetricsServer;
 
 
 class AHRSMainWin : public QMainWindow, public Ui::AHRSMainWin
@@ -26,22 +27,23 @@ public:
 
 protected:
     void keyReleaseEvent( QKeyEvent *pEvent );
-    void timerEvent( QTimerEvent *pEvent );
 
 private:
 #if defined( Q_OS_ANDROID )
     void androidToggleScreenLock();
 #endif
+    void diagnostics();
 
-    StreamReader *m_pStratuxStream;
-    bool          m_bStartup;
-    QDateTime     m_lastStatusUpdate;
+    StreamReader  *m_pStratuxStream;
+    bool           m_bStartup;
+    MetricsServer *m_pMetrics;
 
 private slots:
     void appStateChanged( Qt::ApplicationState eState );
     void statusUpdate( bool bStratux, bool bAHRS, bool bGPS, bool bTraffic, bool bWeather );
     void menu();
     void weather();
+    void startupTimeout();
 };
 
 #endif // __AHRSMAINWIN_H__
@@ -0,0 +1,25 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __ALLOCCOUNTER_H__
+#define __ALLOCCOUNTER_H__
+
+#include <QtGlobal>
+
+
+// Process wide count of heap allocations for finding code that allocates when it shouldn't.
+// The allocator hooks are only compiled in with CONFIG+=alloc_tracking (which defines ALLOC_TRACKING);
+// otherwise isEnabled() is false and the counts stay at zero.
+// Take count() before and after a stretch of code to see how many allocations it made. Allocations
+// from every thread are included.
+class AllocCounter
+{
+public:
+    static bool   isEnabled();
+    static qint64 count();
+    static qint64 bytes();
+};
+
+#endif // __ALLOCCOUNTER_H__
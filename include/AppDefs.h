@@ -15,6 +15,39 @@ namespace AHRS
         ADSBOnlyTraffic,
         NoTraffic
     };
+
+    enum StreamSource
+    {
+        WebSocketSource,    // JSON over the Stratux websockets
+        GDL90Source         // Binary GDL90 over UDP
+    };
+
+    // Where stream messages come in; each keeps its own arrival statistics
+    enum StreamEndpoint
+    {
+        SituationEndpoint,
+        TrafficEndpoint,
+        StatusEndpoint,
+        WeatherEndpoint,
+        GDL90Endpoint,
+        EndpointCount
+    };
+
+    // Groups of situation fields for the change mask that comes with each situation
+    enum SituationChange
+    {
+        AttitudeChanged   = 0x0001,     // Pitch, roll and slip/skid
+        HeadingChanged    = 0x0002,     // AHRS heading and turn rate
+        BaroChanged       = 0x0004,     // Pressure altitude, vertical speed and temperature
+        GPSPosChanged     = 0x0008,     // Latitude, longitude and altitudes
+        GPSTrackChanged   = 0x0010,     // Course, ground speed, turn rate and vertical speed
+        GPSStatusChanged  = 0x0020,     // Fix quality, satellites and accuracy
+        GLoadChanged      = 0x0040,     // G load and its min/max
+        AHRSStatusChanged = 0x0080,
+        TimesChanged      = 0x0100,     // Any of the timestamps or the last NMEA message
+        AllChanged        = 0x01FF,
+        DisplayedChanges  = AllChanged & (~TimesChanged)
+    };
 };
 
 
@@ -0,0 +1,99 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __ATTITUDEPREDICTOR_H__
+#define __ATTITUDEPREDICTOR_H__
+
+#include <QVector>
+
+#include "StratuxStreams.h"
+
+
+// Smooths out the steps between AHRS samples and hides some of the Wi-Fi latency by presenting the
+// attitude expected at (now + horizon) every frame instead of whatever sample arrived last.
+// A positive horizon predicts ahead from the roll/pitch rates and the AHRS turn rate, a negative one
+// renders slightly in the past and interpolates between the last two samples.
+// With a positive horizon each prediction made from the newest sample is held until the samples that
+// bracket its target time arrive and is then scored against them, so the accuracy of looking that far
+// ahead is always known. Recent samples are kept so other horizons can be tried against the same data
+// with replay().
+class AttitudePredictor
+{
+public:
+    struct Attitude
+    {
+        double dRoll;
+        double dPitch;
+        double dHeading;
+    };
+
+    struct Sample
+    {
+        qint64 iTime;       // Milliseconds
+        double dRoll;
+        double dPitch;
+        double dHeading;
+        double dTurnRate;   // Degrees per second
+    };
+    typedef QVector<Sample> SampleList;
+
+    struct Accuracy
+    {
+        int    iSamples;
+        double dRollRMS;
+        double dPitchRMS;
+        double dHeadingRMS;
+        double dRollMax;
+        double dPitchMax;
+        double dHeadingMax;
+    };
+
+    AttitudePredictor();
+
+    void     setHorizon( int iHorizonMs );
+    int      horizon() const { return m_iHorizonMs; }
+    void     addSample( const StratuxSituation &situation, qint64 iReceived );
+    Attitude predict( qint64 iNow ) const;
+    bool     isLive( qint64 iNow ) const;
+    Accuracy accuracy() const;
+    void     resetAccuracy();
+    void     history( SampleList &samples ) const;
+
+    static Accuracy replay( const SampleList &samples, int iHorizonMs );
+
+private:
+    struct Pending
+    {
+        qint64   iTarget;
+        Attitude att;
+    };
+
+    void addSample( const Sample &sample );
+    void score( const Sample &sample );
+
+    int             m_iHorizonMs;
+    int             m_iCount;
+    Sample          m_last;
+    Sample          m_prev;
+    double          m_dRollRate;
+    double          m_dPitchRate;
+    double          m_dHeadingRate;
+
+    // Running error totals for accuracy()
+    int             m_iScored;
+    double          m_dRollSq;
+    double          m_dPitchSq;
+    double          m_dHeadingSq;
+    double          m_dRollMax;
+    double          m_dPitchMax;
+    double          m_dHeadingMax;
+    QVector<Pending> m_pending;
+
+    // Ring of recent samples for replay()
+    QVector<Sample> m_history;
+    int             m_iHistoryNext;
+};
+
+#endif // __ATTITUDEPREDICTOR_H__
@@ -6,6 +6,13 @@ Stratux AHRS Display
 #ifndef __BUILDER_H__
 #define __BUILDER_H__
 
+#include <QVector>
+#include <QLineF>
+
+
+// Bump this whenever the output of any of the build functions changes so stale cached pixmaps get discarded
+#define BUILDER_VERSION 2
+
 
 class Canvas;
 
@@ -20,6 +27,8 @@ public:
     static void buildAltTape( QPixmap *pAltTape, Canvas *pCanvas, int iBug = -1 );
     static void buildSpeedTape( QPixmap *pSpeedTape, Canvas *pCanvas );
     static void buildVertSpeedTape( QPixmap *pVertTape, Canvas *pCanvas );
+
+    static void arcTicks( QVector<QLineF> &ticks, const QPointF &center, double dOuter, double dInner, double dStart, double dStep, int iCount );
 };
 
 #endif // __BUILDER_H__
@@ -0,0 +1,48 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __DIAGNOSTICSDIALOG_H__
+#define __DIAGNOSTICSDIALOG_H__
+
+#include <QDialog>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "ui_DiagnosticsDialog.h"
+#include "AppDefs.h"
+#include "StreamStats.h"
+
+
+class StreamReader;
+
+
+// Stream diagnostics page
+// Shows message and byte rates, inter-arrival jitter, gaps and parse times for each endpoint along with the
+// websocket connection and queue counters, refreshed once a second. Timing is only switched on while it's up.
+class DiagnosticsDialog : public QDialog, public Ui::DiagnosticsDialogBase
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog( QWidget *pParent, StreamReader *pStream );
+    ~DiagnosticsDialog();
+
+protected:
+    void keyReleaseEvent( QKeyEvent *pEvent );
+
+private:
+    void sample();
+
+    StreamReader          *m_pStream;
+    QTimer                 m_refreshTimer;
+    QElapsedTimer          m_sinceSample;
+    StreamStats::Counters  m_prev[AHRS::EndpointCount];
+
+private slots:
+    void refresh();
+    void reset();
+};
+
+#endif // __DIAGNOSTICSDIALOG_H__
@@ -0,0 +1,46 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __FISBDECODER_H__
+#define __FISBDECODER_H__
+
+#include <QtGlobal>
+#include <QVector>
+
+
+#define NEXRAD_BINS_X 32
+#define NEXRAD_BINS_Y 4
+
+
+// One NEXRAD global block; a 32 x 4 grid of precipitation intensity bins
+struct NexradBlock
+{
+    int   iBlock;           // Block number (rings of 450 going east then north from 0N 0E)
+    bool  bSouth;           // Southern hemisphere
+    int   iScale;           // Scale factor code (0, 1 or 2 for 1x, 5x and 9x)
+    bool  bCONUS;           // From the CONUS (product 64) rather than the regional (product 63) composite
+    uchar bins[NEXRAD_BINS_X * NEXRAD_BINS_Y];     // Intensity 0 - 7, row 0 is the north edge
+};
+typedef QVector<NexradBlock> NexradBlockList;
+
+
+// Pulls NEXRAD blocks out of the FIS-B uplinks carried in GDL90 uplink messages
+// Layout follows DO-267A/DO-358 as implemented in dump978: a GDL90 uplink message carries the three byte
+// time of reception and the 432 byte UAT uplink payload. The payload has an eight byte UAT header and then
+// information frames; FIS-B frames hold an APDU whose header gives the product ID and a time that can be in
+// one of four formats. NEXRAD products are either run-length encoded bins for one block or a bitmap of
+// blocks that are empty.
+class FISBDecoder
+{
+public:
+    static int  uplink( const uchar *pMsg, int iLength, NexradBlockList &blocks );
+    static void blockLocation( int iBlock, bool bSouth, int iScale, double &dLatN, double &dLongW, double &dLatSize, double &dLongSize );
+
+private:
+    static void apdu( const uchar *pData, int iLength, NexradBlockList &blocks );
+    static void nexrad( const uchar *pData, int iLength, bool bCONUS, NexradBlockList &blocks );
+};
+
+#endif // __FISBDECODER_H__
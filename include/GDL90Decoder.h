@@ -0,0 +1,46 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __GDL90DECODER_H__
+#define __GDL90DECODER_H__
+
+#include <QtGlobal>
+
+#include "StratuxStreams.h"
+
+
+// Decodes the binary GDL90 messages the Stratux sends on UDP port 4000 into the same structs the
+// websocket JSON streams fill in
+// See the GDL 90 Data Interface Specification (560-1058-00) and the Stratux AHRS extension in
+// https://github.com/cyoung/stratux/blob/master/notes/app-vendor-integration.md
+// Messages are passed in already unframed and CRC checked (see GDL90Framer), starting at the message ID byte.
+class GDL90Decoder
+{
+public:
+    enum MessageID
+    {
+        Heartbeat = 0x00,
+        Uplink = 0x07,
+        OwnshipReport = 0x0A,
+        OwnshipGeoAlt = 0x0B,
+        TrafficReport = 0x14,
+        StratuxAHRS = 0x4C
+    };
+
+    struct Status
+    {
+        bool bGPSValid;
+        int  iUplinkCount;      // Messages received by the radios in the last second
+        int  iBasicLongCount;
+    };
+
+    static bool heartbeat( const uchar *pMsg, int iLength, Status &status );
+    static bool report( const uchar *pMsg, int iLength, int &iICAO, StratuxTraffic &traffic );
+    static bool ownship( const uchar *pMsg, int iLength, StratuxSituation &situation );
+    static bool ownshipGeoAlt( const uchar *pMsg, int iLength, StratuxSituation &situation );
+    static bool ahrs( const uchar *pMsg, int iLength, StratuxSituation &situation );
+};
+
+#endif // __GDL90DECODER_H__
@@ -0,0 +1,29 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __GDL90FRAMER_H__
+#define __GDL90FRAMER_H__
+
+#include <QtGlobal>
+
+
+// GDL90 framing: flag bytes around each message, 0x7D escapes inside it and a CRC-CCITT on the end
+// Everything works in place on the caller's buffer so framing a datagram never allocates, and the CRC
+// runs eight bytes at a time through precomputed tables (slicing-by-8).
+class GDL90Framer
+{
+public:
+    static int     nextFrame( uchar *pData, int iLength, int &iPos, uchar **ppMsg );
+    static int     unstuff( uchar *pFrame, int iLength );
+    static quint16 crc( const uchar *pData, int iLength );
+
+private:
+    static void buildTables();
+
+    static quint16 m_crcTables[8][256];
+    static bool    m_bTablesBuilt;
+};
+
+#endif // __GDL90FRAMER_H__
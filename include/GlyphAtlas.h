@@ -0,0 +1,51 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __GLYPHATLAS_H__
+#define __GLYPHATLAS_H__
+
+#include <QPixmap>
+#include <QString>
+
+
+// Printable ASCII, space to tilde
+#define ATLAS_GLYPHS 95
+
+
+class QFont;
+class QColor;
+class QPainter;
+
+
+// Printable ASCII in one font and color rendered once into a strip so text drawn every frame is one pixmap
+// blit per character rather than a text layout and a font change on the painter, both of which allocate.
+// Characters are placed by their advances without kerning, which the readouts and tail numbers this is used
+// for don't have any of to speak of. Anything outside printable ASCII is drawn as a '?'.
+class GlyphAtlas
+{
+public:
+    GlyphAtlas();
+
+    void build( const QFont &font, const QColor &color );
+    void draw( QPainter *pPainter, double dX, double dBaseline, const QString &qsText ) const;
+    int  width( const QString &qsText ) const;
+
+private:
+    struct Glyph
+    {
+        int    iCell;       // Left edge of the glyph's cell in the strip
+        int    iCellWidth;
+        int    iLeft;       // Left edge of the cell from the pen position
+        double dAdvance;
+    };
+
+    const Glyph &glyph( QChar ch ) const;
+
+    QPixmap m_strip;
+    Glyph   m_glyphs[ATLAS_GLYPHS];
+    int     m_iAscent;      // Top of the strip to the baseline
+};
+
+#endif // __GLYPHATLAS_H__
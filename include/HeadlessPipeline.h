@@ -0,0 +1,85 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __HEADLESSPIPELINE_H__
+#define __HEADLESSPIPELINE_H__
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <QPointF>
+#include <QElapsedTimer>
+
+#include "StratuxStreams.h"
+#include "TrafficStore.h"
+#include "TrafficTrails.h"
+#include "WeatherStore.h"
+#include "NexradCache.h"
+#include "AttitudePredictor.h"
+#include "MetricsServer.h"
+#include "AppDefs.h"
+
+
+class StreamReader;
+
+
+// The whole ingest and traffic pipeline without the widgets, for soak testing on a server or in a container
+// It takes the same stream updates the canvas does and runs the same derived work on the same frame timer (attitude
+// prediction, traffic extrapolation, range culling, trails, threats and the NEXRAD raster) minus the painting, and
+// logs throughput, timing and memory to stdout every so often.
+class HeadlessPipeline : public QObject, public MetricsSource
+{
+    Q_OBJECT
+
+public:
+    explicit HeadlessPipeline( QObject *parent = 0 );
+    ~HeadlessPipeline();
+
+    void start( AHRS::StreamSource eSource, int iLogSecs );
+    void metrics( MetricsWriter &writer ) const;
+
+    StreamReader *streamReader() { return m_pStream; }
+
+private:
+    StreamReader             *m_pStream;
+    StratuxSituation          m_situation;
+    TrafficStore              m_trafficStore;
+    TrafficTrails             m_trafficTrails;
+    WeatherStore              m_weatherStore;
+    NexradCache               m_nexrad;
+    AttitudePredictor         m_predictor;
+    TrafficStore::TargetList  m_visibleTraffic;
+    TrafficStore::ThreatList  m_threats;
+    QVector<QPointF>          m_trailPoints;
+    QTimer                    m_tickTimer;
+    QTimer                    m_logTimer;
+    QElapsedTimer             m_tickTime;
+    QElapsedTimer             m_sinceLog;
+    QElapsedTimer             m_uptime;
+    bool                      m_bStratux;
+    qint64                    m_iSituations;
+    qint64                    m_iTrafficBatches;
+    qint64                    m_iTrafficUpdates;
+    qint64                    m_iWeather;
+    qint64                    m_iNexradBlocks;
+    qint64                    m_iTicks;
+    qint64                    m_iTickNs;
+    qint64                    m_iMaxTickNs;
+    qint64                    m_iLastSituations;
+    qint64                    m_iLastTrafficUpdates;
+    qint64                    m_iLastTicks;
+    qint64                    m_iLastTickNs;
+
+private slots:
+    void situation( SituationSnapshot pSituation );
+    void traffic( TrafficSnapshot pBatch );
+    void weather( WeatherSnapshot pWeather );
+    void nexrad( NexradBlock block );
+    void status( bool bStratux, bool bAHRS, bool bGPS, bool bTraffic, bool bWeather );
+    void tick();
+    void log();
+};
+
+#endif // __HEADLESSPIPELINE_H__
@@ -0,0 +1,30 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __ISOTIME_H__
+#define __ISOTIME_H__
+
+#include <QString>
+#include <QStringRef>
+
+
+// Fixed-format RFC 3339 / ISO 8601 timestamp parser for the times Stratux sends
+// ("2018-05-06T17:04:05.123456789Z", optionally with a +HH:MM offset instead of the Z) that goes straight
+// to seconds and nanoseconds since the epoch, UTC, without allocating anything. Stratux (being Go) sends
+// year 1 for a time that was never set; the millisecond and nanosecond conversions return 0 for that
+// as well as for anything that doesn't parse.
+class ISOTime
+{
+public:
+    static bool   parse( const QString &qsTime, qint64 &iSecs, int &iNanos );
+    static bool   parse( const QStringRef &time, qint64 &iSecs, int &iNanos );
+    static bool   parse( const char *szTime, int iLength, qint64 &iSecs, int &iNanos );
+    static qint64 toMSecs( const QString &qsTime );
+    static qint64 toMSecs( const QStringRef &time );
+    static qint64 toNSecs( const QString &qsTime );
+    static qint64 toNSecs( const QStringRef &time );
+};
+
+#endif // __ISOTIME_H__
@@ -0,0 +1,40 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __JSONFIELDS_H__
+#define __JSONFIELDS_H__
+
+#include <QString>
+#include <QStringRef>
+
+
+// Walks the "tag":value pairs of a websocket message in place; the tags and values are references into the
+// message so nothing is copied out of it unless the caller keeps it, and the message has to outlive the walk.
+// Objects and arrays are flattened so the fields inside them come out in order with the rest and the tag that
+// holds one comes out with an empty value. String values come without their quotes (commas and all) and with
+// any escapes left as they are; anything in an array that isn't a tagged field is skipped.
+class JsonFields
+{
+public:
+    explicit JsonFields( const QString &qsMessage );
+
+    bool next();
+
+    const QStringRef &tag() const { return m_tag; }
+    const QStringRef &value() const { return m_value; }
+
+private:
+    bool quoted( QStringRef &text );
+    void skipSpace();
+
+    const QString *m_pMessage;
+    const QChar   *m_pText;
+    int            m_iLength;
+    int            m_iPos;
+    QStringRef     m_tag;
+    QStringRef     m_value;
+};
+
+#endif // __JSONFIELDS_H__
@@ -18,6 +18,8 @@ class MenuDialog : public QDialog, public Ui::MenuDialogBase
     Q_OBJECT
 
 public:
+    enum { Diagnostics = 2 };   // Result when the diagnostics page was asked for
+
     explicit MenuDialog( QWidget *pParent );
     ~MenuDialog();
 
@@ -26,14 +28,18 @@ protected:
 
 private:
     void updateTrafficButton();
+    void updateStreamButton();
 
     AHRS::TrafficDisp      m_eTrafficDisp;
+    AHRS::StreamSource     m_eStreamSource;
     QNetworkAccessManager *m_pNetMan;
 
 private slots:
     void traffic();
+    void streamSource();
     void garminToggle();
     void resetLevel();
+    void diagnostics();
     void exit();
 };
 
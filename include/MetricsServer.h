@@ -0,0 +1,72 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __METRICSSERVER_H__
+#define __METRICSSERVER_H__
+
+#include <QObject>
+#include <QTcpServer>
+#include <QByteArray>
+#include <QList>
+
+
+class QTcpSocket;
+
+
+// Builds a page of metrics in the Prometheus text exposition format
+class MetricsWriter
+{
+public:
+    explicit MetricsWriter( QByteArray &page );
+
+    void family( const char *szName, const char *szType, const char *szHelp );
+    void value( const char *szName, double dValue );
+    void value( const char *szName, const char *szLabel, const char *szLabelValue, double dValue );
+
+private:
+    QByteArray &m_page;
+};
+
+
+// Anything with counters worth scraping
+class MetricsSource
+{
+public:
+    virtual ~MetricsSource() {}
+
+    virtual void metrics( MetricsWriter &writer ) const = 0;
+};
+
+
+// Optional local HTTP endpoint serving the metrics of every registered source on GET /metrics
+// Meant for scraping long bench and replay runs, so it only listens on the loopback interface (use adb forward to reach
+// it on a device) and only answers the one request per connection.
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsServer( QObject *parent = 0 );
+
+    bool listen( quint16 uiPort );
+    void addSource( const MetricsSource *pSource );
+
+    static bool memoryUsage( qint64 &iVirtual, qint64 &iResident );
+
+private:
+    void       respond( QTcpSocket *pClient, const QByteArray &request );
+    QByteArray page() const;
+
+    QTcpServer                    m_server;
+    QList<const MetricsSource *>  m_sources;
+    qint64                        m_iScrapes;
+    qint64                        m_iStartTime;
+
+private slots:
+    void newClient();
+    void clientData();
+};
+
+#endif // __METRICSSERVER_H__
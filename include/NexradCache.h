@@ -0,0 +1,71 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __NEXRADCACHE_H__
+#define __NEXRADCACHE_H__
+
+#include <QHash>
+#include <QVector>
+#include <QImage>
+
+#include "FISBDecoder.h"
+
+
+// Keeps every NEXRAD block (tile) received along with when it arrived, and an ownship-centred, north-up
+// raster of the ones around ownship for drawing on the heading dial.
+// The raster is only updated for the tile that just arrived, so drawing it costs one pass over the dial
+// no matter how many blocks there are. It is only rebuilt from all the tiles when ownship has moved far
+// enough from its centre, the range changes, tiles age out or the display switches between the regional
+// and CONUS composites (regional is used whenever it's being received since it's five times finer).
+class NexradCache
+{
+public:
+    NexradCache();
+
+    void add( const NexradBlock &block, qint64 iReceived );
+    void setView( double dLat, double dLong, double dRangeNM );
+    bool expire( qint64 iNow );
+    void clear();
+
+    const QImage &image() const { return m_raster; }
+    int           count() const { return m_tiles.count(); }
+    bool          isEmpty() const { return m_tiles.isEmpty() || (!m_bCentered); }
+    bool          isRegional() const { return m_bRegional; }
+    double        rangeNM() const { return m_dRangeNM; }
+    void          offset( double dLat, double dLong, double &dX, double &dY ) const;
+    void          drawDial( QImage &dial, double dLat, double dLong, double dHeading, double dPixPerNM ) const;
+
+private:
+    struct Tile
+    {
+        quint32 uiKey;
+        qint64  iReceived;
+        bool    bCONUS;
+        double  dLatN;
+        double  dLongW;
+        double  dLatSize;
+        double  dLongSize;
+        uchar   bins[NEXRAD_BINS_X * NEXRAD_BINS_Y];
+    };
+
+    void recomposite();
+    void rasterize( const Tile &tile );
+    void remove( int iTile );
+
+    QHash<quint32, int> m_index;        // Block key to its slot in m_tiles
+    QVector<Tile>       m_tiles;
+    QImage              m_raster;
+    bool                m_bCentered;
+    bool                m_bRegional;
+    qint64              m_iLastRegional;
+    qint64              m_iLastExpire;
+    double              m_dCenterLat;
+    double              m_dCenterLong;
+    double              m_dLongScale;   // Cosine of the centre latitude
+    double              m_dRangeNM;     // Distance from the centre to each edge of the raster
+    QRgb                m_colors[8];    // Premultiplied colour for each intensity level
+};
+
+#endif // __NEXRADCACHE_H__
@@ -0,0 +1,36 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __PIXMAPCACHE_H__
+#define __PIXMAPCACHE_H__
+
+#include <QString>
+
+
+class QPixmap;
+class Canvas;
+
+
+// On-disk cache of the pixmaps the Builder generates so they don't have to be
+// re-rasterized on every start, resume or resize.
+// Entries are keyed on everything that affects the Builder output (screen geometry, DPI,
+// font metrics and the builder version) so a stale entry is never picked up.
+class PixmapCache
+{
+public:
+    explicit PixmapCache( Canvas *pCanvas, int iDPI, double dPixelRatio );
+
+    bool load( const QString &qsName, QPixmap *pPixmap );
+    void save( const QString &qsName, const QPixmap *pPixmap );
+
+private:
+    QString fileName( const QString &qsName );
+    void    purge( const QString &qsName );
+
+    QString m_qsKey;
+    QString m_qsCacheDir;
+};
+
+#endif // __PIXMAPCACHE_H__
@@ -0,0 +1,81 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __RENDERHARNESS_H__
+#define __RENDERHARNESS_H__
+
+#include <QString>
+#include <QVector>
+#include <QImage>
+
+#include "AHRSCanvas.h"
+#include "StreamReader.h"
+#include "AppDefs.h"
+
+
+// Frames that may allocate while the canvas and Qt fill their caches before the budget applies
+#define ALLOC_WARMUP_FRAMES 10
+
+
+// Renders the display offscreen into images from a fixed input sequence for benchmarking and golden image checks
+// The canvas runs on a fixed clock that steps by the frame interval so every run of the same inputs at the same size
+// produces the same frames; nothing moves on its own. The inputs are either a built-in synthetic flight (a turning,
+// climbing aircraft with traffic circling around it) or a recorded session of websocket messages, one per line as
+// "<milliseconds> <situation|traffic|status|weather> <message>".
+// Each frame's paint time is reported along with a summary, frames can be written out as PNGs and each one can be
+// compared against a golden PNG of the same name.
+// In an alloc_tracking build the heap allocations made painting each frame are reported as well and held to a
+// budget once the first few frames have filled the caches; by default none at all. That's the core display
+// (attitude, tapes, dial, traffic and radar); the weather, GPS and traffic detail pages lay out text when
+// they're up and aren't part of it.
+class RenderHarness
+{
+public:
+    struct Options
+    {
+        int     iWidth;
+        int     iHeight;
+        int     iFrames;
+        int     iFrameMs;       // Scenario time between frames
+        int     iTolerance;     // Largest per channel difference from the golden image that still counts as a match
+        int     iAllocBudget;   // Most allocations a frame past the warm-up may make; -1 for no limit
+        QString qsScenario;     // Recorded session; the synthetic flight if empty
+        QString qsOutDir;
+        QString qsGoldenDir;
+    };
+
+    explicit RenderHarness( const Options &options );
+
+    int run();
+
+    const QVector<qint64> &frameAllocs() const;
+
+    static void defaultOptions( Options &options );
+
+private:
+    struct Record
+    {
+        qint64               iTime;
+        AHRS::StreamEndpoint eEndpoint;
+        QString              qsMessage;
+    };
+
+    bool loadScenario();
+    void feed( qint64 iTime );
+    void syntheticSituation( qint64 iTime );
+    void syntheticTraffic( qint64 iTime );
+    int  compare( const QImage &frame, const QString &qsName, int &iMaxDiff );
+
+    Options         m_options;
+    AHRSCanvas      m_canvas;
+    StreamReader    m_reader;
+    QVector<Record> m_records;
+    QVector<qint64> m_frameAllocs;  // Allocations painting each frame of the last run
+    int             m_iNextRecord;
+    qint64          m_iNextSituation;
+    qint64          m_iNextTraffic;
+};
+
+#endif // __RENDERHARNESS_H__
@@ -8,8 +8,13 @@ Stratux AHRS Display
 
 #include <QDateTime>
 #include <QString>
+#include <QtGlobal>
+#include <QVector>
+#include <QSharedPointer>
+#include <QMetaType>
 
 
+// Times are milliseconds since the epoch (UTC), 0 if Stratux hasn't got one
 struct StratuxSituation
 {
     double    dLastGPSFixSinceMidnight;
@@ -26,20 +31,20 @@ struct StratuxSituation
     double    dGPSAltMSL;
     double    dGPSVertAccuracy;
     double    dGPSVertSpeed;
-    QDateTime lastGPSFixTime;
+    qint64    iLastGPSFixTime;
     double    dGPSTrueCourse;
     double    dGPSTurnRate;
     double    dGPSGroundSpeed;
-    QDateTime lastGPSGroundTrackTime;
-    QDateTime gpsDateTime;
-    QDateTime lastGPSTimeStratuxTime;
-    QDateTime lastValidNMEAMessageTime;
+    qint64    iLastGPSGroundTrackTime;
+    qint64    iGPSDateTime;
+    qint64    iLastGPSTimeStratuxTime;
+    qint64    iLastValidNMEAMessageTime;
     QString   qsLastNMEAMsg;
     int       iGPSPosSampleRate;
     double    dBaroTemp;
     double    dBaroPressAlt;
     double    dBaroVertSpeed;
-    QDateTime lastBaroMeasTime;
+    qint64    iLastBaroMeasTime;
     double    dAHRSpitch;
     double    dAHRSroll;
     double    dAHRSGyroHeading;
@@ -49,35 +54,40 @@ struct StratuxSituation
     double    dAHRSGLoad;
     double    dAHRSGLoadMin;
     double    dAHRSGLoadMax;
-    QDateTime lastAHRSAttTime;
+    qint64    iLastAHRSAttTime;
     int       iAHRSStatus;
+    uint      uiChanged;        // AHRS::SituationChange bits for what differs from the previous situation
 };
 
 
 // Traffic struct
 // NOTE ICAO is deliberately missing since it's used in a map in a higher level class to differentiate aircraft
+// This is plain old data so it can be copied, queued and stored in bulk with memcpy; times are milliseconds
+// since the epoch, the registration and tail are StringTable indices and anything that doesn't need double
+// precision (everything but the position) is a float.
 struct StratuxTraffic
 {
-    QString   qsReg;
-    double    dSigLevel;
-    int       iSquawk;
-    bool      bOnGround;
-    double    dLat;
-    double    dLong;
-    bool      bPosValid;
-    double    dAlt;
-    double    dTrack;
-    double    dSpeed;
-    double    dVertSpeed;
-    QString   qsTail;
-    QDateTime lastSeen;
-    QDateTime timestamp;
-    int       iLastSource;
-    double    dBearing;
-    double    dDist;
-    double    dAge;
-    bool      bHasADSB;
+    qint64 iLastSeen;
+    qint64 iTimestamp;
+    double dLat;
+    double dLong;
+    float  fSigLevel;
+    float  fAlt;
+    float  fTrack;
+    float  fSpeed;
+    float  fVertSpeed;
+    float  fBearing;
+    float  fDist;
+    float  fAge;
+    int    iSquawk;
+    int    iLastSource;
+    int    iReg;
+    int    iTail;
+    bool   bOnGround;
+    bool   bPosValid;
+    bool   bHasADSB;
 };
+Q_DECLARE_TYPEINFO( StratuxTraffic, Q_PRIMITIVE_TYPE );
 
 
 struct StratuxStatus
@@ -103,4 +113,25 @@ struct StratuxWeather
     QString   qsLastMessage;    // This is for testing only
 };
 
+
+// One aircraft in a batch of traffic updates
+struct StratuxTrafficUpdate
+{
+    int            iICAO;
+    StratuxTraffic traffic;
+};
+Q_DECLARE_TYPEINFO( StratuxTrafficUpdate, Q_PRIMITIVE_TYPE );
+typedef QVector<StratuxTrafficUpdate> TrafficBatch;
+
+
+// Immutable, reference counted snapshots as handed out by the stream reader
+// Passing one on to any number of consumers, or to another thread over a queued connection, only copies the pointer.
+typedef QSharedPointer<const StratuxSituation> SituationSnapshot;
+typedef QSharedPointer<const TrafficBatch>     TrafficSnapshot;
+typedef QSharedPointer<const StratuxWeather>   WeatherSnapshot;
+
+Q_DECLARE_METATYPE( SituationSnapshot )
+Q_DECLARE_METATYPE( TrafficSnapshot )
+Q_DECLARE_METATYPE( WeatherSnapshot )
+
 #endif // __STRATUXSTREAMS_H__
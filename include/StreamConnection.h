@@ -0,0 +1,86 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __STREAMCONNECTION_H__
+#define __STREAMCONNECTION_H__
+
+#include <QObject>
+#include <QWebSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QUrl>
+
+
+// One websocket stream and the state machine that keeps it connected
+// Once opened it stays wanted until closed: a drop or error goes straight back to connecting with no delay
+// the first time and then with a jittered, doubling backoff so a Wi-Fi blip costs well under a second. An attempt
+// that hasn't connected within a second is given up on rather than left to the OS connect timeout. While
+// connected it pings the Stratux and if nothing at all (messages or pongs) has been heard for a while the
+// connection is taken to be dead and restarted, since a Wi-Fi drop doesn't always close the socket.
+class StreamConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State
+    {
+        Closed,         // Not wanted
+        Connecting,
+        Connected,
+        Waiting         // Backing off before the next attempt
+    };
+
+    struct Counters
+    {
+        int    iConnects;
+        int    iReconnects;         // Connects after the first one
+        int    iFailures;           // Errors, drops, connect and liveness timeouts
+        int    iConnectTimeouts;    // Attempts given up on for taking too long to connect
+        int    iLivenessTimeouts;
+        int    iDuplicateConnects;  // Attempts to connect the same message slot more than once
+        qint64 iDowntimeMs;         // Total time wanted but not connected
+        qint64 iRoundTripMs;        // Latest ping round trip
+    };
+
+    explicit StreamConnection( QObject *parent = 0 );
+
+    void     open( const QUrl &url );
+    void     close();
+    bool     connectMessages( QObject *pReceiver, const char *szSlot );
+    State    state() const { return m_eState; }
+    bool     isConnected() const { return (m_eState == Connected); }
+    QUrl     url() const { return m_url; }
+    Counters counters() const;
+
+private:
+    void connectionLost();
+
+    QWebSocket    m_socket;
+    QUrl          m_url;
+    State         m_eState;
+    QTimer        m_retryTimer;
+    QTimer        m_connectTimer;
+    QTimer        m_livenessTimer;
+    QElapsedTimer m_lastHeard;
+    QElapsedTimer m_downSince;
+    int           m_iBackoffMs;
+    bool          m_bEverConnected;
+    Counters      m_counters;
+
+private slots:
+    void socketConnected();
+    void socketDisconnected();
+    void socketError( QAbstractSocket::SocketError eError );
+    void messageReceived();
+    void pongReceived( quint64 uiElapsed, const QByteArray &payload );
+    void retry();
+    void connectTimeout();
+    void checkLiveness();
+
+signals:
+    void connectionChanged( bool );     // Connected
+};
+
+#endif // __STREAMCONNECTION_H__
@@ -0,0 +1,56 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __STREAMQUEUE_H__
+#define __STREAMQUEUE_H__
+
+#include <QString>
+#include <QVector>
+
+
+// Bounded queue of raw stream messages between the sockets and the parser
+// Messages are only queued as they arrive and parsed later in one go, so if the display falls behind a burst
+// is absorbed here instead of growing Qt's event queue. What happens when it's full depends on the stream:
+// KeepLatest holds just the newest message (older ones are superseded and counted as coalesced) and KeepAll
+// holds up to the capacity and then drops the oldest (counted as dropped).
+class StreamQueue
+{
+public:
+    enum Policy
+    {
+        KeepLatest,
+        KeepAll
+    };
+
+    struct Counters
+    {
+        qint64 iReceived;
+        qint64 iDelivered;
+        qint64 iDropped;
+        qint64 iCoalesced;
+        int    iHighWater;      // Most messages waiting at once
+    };
+
+    StreamQueue( Policy ePolicy, int iCapacity );
+
+    void push( const QString &qsMessage );
+    bool pop( QString &qsMessage );
+    void clear();
+
+    bool            isEmpty() const { return (m_iCount == 0); }
+    int             count() const { return m_iCount; }
+    int             capacity() const { return m_ring.count(); }
+    Policy          policy() const { return m_ePolicy; }
+    const Counters &counters() const { return m_counters; }
+
+private:
+    Policy           m_ePolicy;
+    QVector<QString> m_ring;
+    int              m_iHead;       // Oldest message
+    int              m_iCount;
+    Counters         m_counters;
+};
+
+#endif // __STREAMQUEUE_H__
@@ -7,15 +7,24 @@ Stratux AHRS Display
 #define __STREAMREADER_H__
 
 #include <QObject>
-#include <QWebSocket>
+#include <QUdpSocket>
+#include <QByteArray>
+#include <QTimer>
+#include <QHash>
 
 #include "StratuxStreams.h"
+#include "AppDefs.h"
+#include "FISBDecoder.h"
+#include "StreamQueue.h"
+#include "StreamConnection.h"
+#include "StreamStats.h"
+#include "MetricsServer.h"
 
 
 class QCoreApplication;
 
 
-class StreamReader : public QObject
+class StreamReader : public QObject, public MetricsSource
 {
     Q_OBJECT
 
@@ -24,42 +33,100 @@ public:
     ~StreamReader();
 
     void connectStreams();
+    void connectStreams( AHRS::StreamSource eSource );
     void disconnectStreams();
+    void inject( AHRS::StreamEndpoint eEndpoint, const QString &qsMessage );
     bool isConnected() { return m_bConnected; }
+    AHRS::StreamSource source() { return m_eSource; }
+
+    // Ingest queue counters
+    const StreamQueue &situationQueue() const { return m_situationQueue; }
+    const StreamQueue &trafficQueue() const { return m_trafficQueue; }
+    const StreamQueue &weatherQueue() const { return m_weatherQueue; }
+    qint64             situationsCoalesced() const { return m_iSituationsCoalesced; }
+    qint64             trafficCoalesced() const { return m_iTrafficCoalesced; }
+
+    // Websocket connection state and counters
+    const StreamConnection &situationConnection() const { return m_stratuxSituation; }
+    const StreamConnection &trafficConnection() const { return m_stratuxTraffic; }
+    const StreamConnection &statusConnection() const { return m_stratuxStatus; }
+    const StreamConnection &weatherConnection() const { return m_stratuxWeather; }
+
+    // Arrival and parse statistics
+    const StreamStats &stats( AHRS::StreamEndpoint eEndpoint ) const { return m_stats[eEndpoint]; }
+    void               resetStats();
+
+    void metrics( MetricsWriter &writer ) const;
 
     static void initTraffic( StratuxTraffic &traffic );
     static void initSituation( StratuxSituation &situation );
     static void initStatus( StratuxStatus &status );
     static void initWeather( StratuxWeather &weather );
+    static uint situationChanges( const StratuxSituation &prev, const StratuxSituation &cur );
 
 private:
-    bool          m_bHaveMyPos;
-    bool          m_bAHRSStatus;
-    bool          m_bStratuxStatus;
-    bool          m_bGPSStatus;
-    bool          m_bWeatherStatus;
-    bool          m_bTrafficStatus;
-    QWebSocket    m_stratuxSituation;
-    QWebSocket    m_stratuxTraffic;
-    QWebSocket    m_stratuxStatus;
-    QWebSocket    m_stratuxWeather;
-    double        m_dMyLat;
-    double        m_dMyLong;
-    bool          m_bConnected;
+    void gdl90Message( const uchar *pMsg, int iLength );
+    void parseSituation( const QString &qsMessage );
+    void parseTraffic( const QString &qsMessage );
+    void parseWeather( const QString &qsMessage );
+    void parseStatus( const QString &qsMessage );
+    void queueSituation( const StratuxSituation &situation );
+    void queueTraffic( int iICAO, const StratuxTraffic &traffic );
+    void scheduleDrain();
+    void trafficPosition( StratuxTraffic &traffic );
+    void myPosition( const StratuxSituation &situation );
+
+    bool               m_bHaveMyPos;
+    bool               m_bAHRSStatus;
+    bool               m_bStratuxStatus;
+    bool               m_bGPSStatus;
+    bool               m_bWeatherStatus;
+    bool               m_bTrafficStatus;
+    StreamConnection   m_stratuxSituation;
+    StreamConnection   m_stratuxTraffic;
+    StreamConnection   m_stratuxStatus;
+    StreamConnection   m_stratuxWeather;
+    QUdpSocket         m_stratuxGDL90;
+    QTimer             m_gdl90RebindTimer;
+    QTimer             m_gdl90SilenceTimer;  // Restarted by every datagram
+    AHRS::StreamSource m_eSource;
+    QByteArray         m_gdl90Datagram;
+    StratuxSituation   m_gdl90Situation;     // Built up from the ownship, geometric altitude and AHRS messages
+    NexradBlockList    m_nexradBlocks;       // Scratch for the blocks in each uplink
+    StreamQueue        m_situationQueue;     // Raw websocket messages waiting to be parsed
+    StreamQueue        m_trafficQueue;
+    StreamQueue        m_weatherQueue;
+    StratuxSituation   m_lastSituation;      // Newest parsed situation; sent on the next drain if pending
+    bool               m_bHaveLastSituation;
+    bool               m_bSituationPending;
+    uint               m_uiPendingChanges;   // Change mask over every situation since the last one sent
+    TrafficBatch       m_trafficBatch;       // Traffic waiting for the next drain, one entry per aircraft
+    QHash<int, int>    m_trafficBatchIndex;  // ICAO to its entry in the batch
+    qint64             m_iSituationsCoalesced;
+    qint64             m_iTrafficCoalesced;
+    QTimer             m_drainTimer;
+    StreamStats        m_stats[AHRS::EndpointCount];
+    double             m_dMyLat;
+    double             m_dMyLong;
+    bool               m_bConnected;
 
 private slots:
     void situationUpdate( const QString &qsMessage );
     void trafficUpdate( const QString &qsMessage );
     void statusUpdate( const QString &qsMessage );
     void weatherUpdate( const QString &qsMessage );
-    void stratuxConnected();
-    void stratuxDisconnected();
+    void gdl90Update();
+    void stratuxConnectionChanged( bool bConnected );
+    void gdl90Bind();
+    void gdl90Silent();
+    void drainQueues();
 
 signals:
-    void newSituation( StratuxSituation );
-    void newTraffic( int, StratuxTraffic );             // ICAO, Rest of traffic struct
+    void newSituation( SituationSnapshot );
+    void newTraffic( TrafficSnapshot );                 // Every aircraft updated since the last batch
     void newStatus( bool, bool, bool, bool, bool );     // Stratux available, AHRS available, GPS available, Traffic available, Weather available
-    void newWeather( StratuxWeather );
+    void newWeather( WeatherSnapshot );
+    void newNexrad( NexradBlock );                      // NEXRAD block from a FIS-B uplink (GDL90 source only)
 };
 
 #endif // __STREAMREADER_H__
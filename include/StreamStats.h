@@ -0,0 +1,67 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __STREAMSTATS_H__
+#define __STREAMSTATS_H__
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+
+
+// Arrival and parse statistics for one stream endpoint
+// Everything is kept in atomics so the diagnostics page can read a consistent-enough picture without taking a lock
+// on the receive path. Message and byte counts are always kept since they only cost two adds; the clock reads for
+// inter-arrival jitter, gaps and parse time are only made while timing is turned on (the diagnostics page is up or
+// metrics are being served).
+// Jitter is the difference between each inter-arrival gap and the smoothed gap before it, binned by size.
+class StreamStats
+{
+public:
+    enum { JitterBins = 8 };    // Jitter histogram bins; the upper edges are in jitterBinLimit()
+
+    struct Counters
+    {
+        qint64 iMessages;
+        qint64 iBytes;
+        qint64 iTimedMessages;          // Messages that arrived while timing was on
+        int    iMaxGapMs;               // Longest time between two messages
+        int    iJitterUs;               // Smoothed inter-arrival jitter
+        int    histogram[JitterBins];
+        qint64 iParsed;                 // Messages timed through the parser
+        qint64 iParseNs;
+        qint64 iMaxParseNs;
+    };
+
+    StreamStats();
+
+    void arrived( int iBytes );
+    void parsed( qint64 iStart, int iMessages = 1 );
+    void counters( Counters &counters ) const;
+    void reset();
+
+    static void   setTiming( bool bTiming );
+    static bool   isTiming() { return (s_timing.load() > 0); }
+    static qint64 startTiming();
+    static int    jitterBinLimit( int iBin );
+
+private:
+    QAtomicInteger<qint64> m_iMessages;
+    QAtomicInteger<qint64> m_iBytes;
+    QAtomicInteger<qint64> m_iTimedMessages;
+    QAtomicInt             m_iMaxGapMs;
+    QAtomicInt             m_iJitterUs;
+    QAtomicInt             m_histogram[JitterBins];
+    QAtomicInteger<qint64> m_iParsed;
+    QAtomicInteger<qint64> m_iParseNs;
+    QAtomicInteger<qint64> m_iMaxParseNs;
+
+    // Only touched on the receive path
+    qint64                 m_iLastArrivalUs;
+    qint64                 m_iMeanGapUs;
+
+    static QAtomicInt      s_timing;
+};
+
+#endif // __STREAMSTATS_H__
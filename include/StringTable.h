@@ -0,0 +1,40 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __STRINGTABLE_H__
+#define __STRINGTABLE_H__
+
+#include <QString>
+#include <QStringRef>
+#include <QLatin1String>
+#include <QHash>
+#include <QVector>
+
+
+// Interns the short strings that come with every traffic update (registration and tail/callsign) so the
+// traffic record can carry a small index instead of a QString and stay plain old data.
+// Index 0 is always the empty string. The same few strings repeat for as long as an aircraft is tracked so
+// the table stays small; once it's full anything new maps to the empty string. Looking up a string that's
+// already in the table doesn't allocate, whether it comes as a QString, part of a message or Latin-1 bytes.
+// GUI thread only.
+class StringTable
+{
+public:
+    static int            intern( const QString &qs );
+    static int            intern( const QStringRef &text );
+    static int            intern( QLatin1String text );
+    static const QString &string( int iIndex );
+    static int            count() { return m_strings.count(); }
+
+private:
+    template <typename T>
+    static int find( const T &text, uint uiHash );
+    static int add( const QString &qs, uint uiHash );
+
+    static QMultiHash<uint, int> m_index;     // Hash of each string to its index; collisions are told apart by comparing
+    static QVector<QString>      m_strings;
+};
+
+#endif // __STRINGTABLE_H__
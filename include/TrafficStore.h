@@ -0,0 +1,110 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __TRAFFICSTORE_H__
+#define __TRAFFICSTORE_H__
+
+#include <QMap>
+#include <QHash>
+#include <QVector>
+
+#include "StratuxStreams.h"
+
+
+// Holds the latest state of every tracked aircraft along with a coarse spatial grid over the
+// positions relative to ownship so range culling, nearest-N and hit testing only look at the
+// cells that matter instead of every tracked aircraft.
+// Positions are nautical miles east (X) and north (Y) of ownship. Aircraft with a position are also
+// kept in flat per-field arrays so they can all be dead-reckoned forward from their last fix, and checked
+// for closest point of approach, in one pass.
+// dropped() lists the aircraft the last update() or extrapolate() removed or took the position away from so
+// anything kept alongside (like the trails) can let go of them too.
+class TrafficStore
+{
+public:
+    struct Target
+    {
+        int    iICAO;
+        double dX;
+        double dY;
+        double dDist;
+    };
+    typedef QVector<Target> TargetList;
+
+    // Closest point of approach to ownship if both hold their current track, speed and vertical speed
+    struct Threat
+    {
+        int    iICAO;
+        double dX;
+        double dY;
+        double dTCPA;       // Seconds until closest approach (zero if already diverging)
+        double dDCPA;       // Horizontal separation at closest approach in nautical miles
+        double dVCPA;       // Vertical separation at closest approach in feet
+        bool   bAlert;      // Close enough soon enough to call out rather than just advise
+    };
+    typedef QVector<Threat> ThreatList;
+
+    TrafficStore();
+
+    void update( int iICAO, const StratuxTraffic &traffic, qint64 iFixTime );
+    void setOwnship( double dTrack, double dSpeed, double dAlt, double dVertSpeed );
+    void extrapolate( qint64 iNow );
+    void clear();
+
+    const QMap<int, StratuxTraffic> &traffic() const { return m_trafficMap; }
+    int                              count() const { return m_trafficMap.count(); }
+    int                              positionCount() const { return m_icao.count(); }
+    bool                             hasPosition( int iICAO ) const { return m_slotOf.contains( iICAO ); }
+    const QVector<int>              &dropped() const { return m_dropped; }
+
+    void inRange( double dRangeNM, TargetList &targets ) const;
+    void nearest( int iCount, TargetList &targets ) const;
+    int  hitTest( double dX, double dY, double dRadiusNM ) const;
+    void threats( ThreatList &threats );
+
+private:
+    void    expire( qint64 iNow );
+    void    remove( int iICAO );
+    void    unplace( int iICAO );
+    void    place( int iICAO, const StratuxTraffic &traffic, qint64 iFixTime );
+    void    moveToCell( int iSlot, quint32 uiKey );
+    void    target( int iSlot, Target &t ) const;
+    quint32 cellKey( int iCellX, int iCellY ) const;
+    int     cellIndex( double dPos ) const;
+
+    QMap<int, StratuxTraffic>     m_trafficMap;
+    QHash<int, qint64>            m_received;   // When each aircraft was last reported, on the fix time clock
+
+    // Positioned aircraft, one slot per aircraft in each array
+    QHash<int, int>               m_slotOf;
+    QVector<int>                  m_icao;
+    QVector<qint64>               m_fixTime;
+    QVector<double>               m_fixX;
+    QVector<double>               m_fixY;
+    QVector<double>               m_velX;
+    QVector<double>               m_velY;
+    QVector<double>               m_alt;
+    QVector<double>               m_vertSpeed;
+    QVector<double>               m_x;
+    QVector<double>               m_y;
+    QVector<double>               m_dist;
+    QVector<quint32>              m_cell;
+
+    // Scratch for threats() so the CPA pass doesn't allocate every frame
+    QVector<double>               m_tcpa;
+    QVector<double>               m_dcpa;
+    QVector<double>               m_vcpa;
+
+    QHash<quint32, QVector<int> > m_grid;     // Grid cell to the slots in it
+    QVector<int>                  m_dropped;
+
+    qint64                        m_iExtrapolated;  // Time of the last extrapolate()
+    double                        m_dOwnVelX;
+    double                        m_dOwnVelY;
+    double                        m_dOwnAlt;
+    double                        m_dOwnVertSpeed;
+};
+
+#endif // __TRAFFICSTORE_H__
@@ -0,0 +1,57 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __TRAFFICTRAILS_H__
+#define __TRAFFICTRAILS_H__
+
+#include <QHash>
+#include <QVector>
+#include <QPointF>
+
+#include "StratuxStreams.h"
+
+
+// Recent positions of each aircraft for drawing where it's been
+// Every trail is a fixed size ring of points carved out of one pool allocated up front, so the memory
+// used never changes no matter how many aircraft come and go. When a trail fills up the older half is
+// thinned out to make room, so the recent track stays detailed and the older track gets coarser.
+// When every trail is in use the one that has gone longest without an update is taken over.
+class TrafficTrails
+{
+public:
+    struct TrailPoint
+    {
+        qint64 iTime;       // Milliseconds
+        double dLat;
+        double dLong;
+    };
+
+    TrafficTrails();
+
+    void add( int iICAO, const StratuxTraffic &traffic, qint64 iTime );
+    void remove( int iICAO );
+    void clear();
+    bool relative( int iICAO, double dOwnLat, double dOwnLong, QVector<QPointF> &points ) const;
+
+private:
+    struct Trail
+    {
+        int    iICAO;       // -1 if the trail is free
+        int    iStart;
+        int    iCount;
+        qint64 iLastTime;
+    };
+
+    int         allocate( int iICAO );
+    void        decimate( int iTrail );
+    TrailPoint &point( int iTrail, int iIndex );
+
+    QVector<Trail>      m_trails;
+    QVector<TrailPoint> m_pool;
+    QHash<int, int>     m_trailOf;     // ICAO to trail index
+    QVector<int>        m_free;
+};
+
+#endif // __TRAFFICTRAILS_H__
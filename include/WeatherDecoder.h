@@ -0,0 +1,48 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __WEATHERDECODER_H__
+#define __WEATHERDECODER_H__
+
+#include <QByteArray>
+
+
+// Pulls the wind, visibility, ceiling and flight category out of METAR and TAF text
+// Works straight on the Latin-1 bytes one space separated group at a time so decoding doesn't allocate.
+// For a TAF only the base forecast (before the first FM, BECMG, TEMPO or PROB group) is decoded.
+class WeatherDecoder
+{
+public:
+    enum FlightCategory
+    {
+        UnknownCategory = 0,
+        VFR,
+        MVFR,
+        IFR,
+        LIFR
+    };
+
+    struct Decoded
+    {
+        bool           bValid;          // Set if anything at all was decoded
+        int            iWindDir;        // Degrees true, -1 if variable or unknown
+        int            iWindSpeed;      // Knots, -1 if unknown
+        int            iWindGust;       // Knots, -1 if none
+        double         dVisibility;     // Statute miles, -1 if unknown
+        int            iCeiling;        // Feet AGL of the lowest broken, overcast or obscured layer, -1 if none
+        FlightCategory eCategory;
+    };
+
+    static void decode( const QByteArray &data, Decoded &decoded );
+    static void decode( const char *pData, int iLength, Decoded &decoded );
+
+private:
+    static bool wind( const char *pGroup, int iLength, Decoded &decoded );
+    static bool visibility( const char *pGroup, int iLength, double dWhole, Decoded &decoded );
+    static bool cloud( const char *pGroup, int iLength, Decoded &decoded );
+    static void categorize( Decoded &decoded );
+};
+
+#endif // __WEATHERDECODER_H__
@@ -0,0 +1,72 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#ifndef __WEATHERSTORE_H__
+#define __WEATHERSTORE_H__
+
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+
+#include "StratuxStreams.h"
+#include "WeatherDecoder.h"
+
+
+// Holds the latest of each weather product (METAR, TAF, PIREP, etc.) per station
+// Products are keyed on type and location so a lookup is a single hash probe. A product only replaces the
+// one already held if it's newer, and the identical rebroadcasts FIS-B repeats every few minutes are
+// recognized and dropped. Text is kept as Latin-1 byte arrays (the FIS-B character set) at half the size
+// of a QString, and the number of products held is capped so memory doesn't grow over a long flight.
+// METARs and TAFs are decoded once as they're stored so nothing drawing them has to parse the text.
+class WeatherStore
+{
+public:
+    enum InsertResult
+    {
+        Added = 0,
+        Replaced,
+        Duplicate,
+        Older
+    };
+
+    struct Product
+    {
+        QByteArray              type;
+        QByteArray              location;
+        QByteArray              data;
+        qint64                  iProdTime;      // Milliseconds since the epoch (UTC)
+        qint64                  iReceived;      // Milliseconds since the epoch when it was last heard
+        uint                    uiDataHash;
+        WeatherDecoder::Decoded decoded;        // Only valid for METAR, SPECI and TAF
+    };
+    typedef QVector<const Product *> ProductList;
+
+    WeatherStore();
+
+    InsertResult insert( const StratuxWeather &weather, qint64 iReceived );
+    void         clear();
+
+    // Pointers returned are only good until the next insert() or clear()
+    const Product *find( const QString &qsType, const QString &qsLocation ) const;
+    const Product *latest() const;
+    int            count() const { return m_products.count(); }
+    int            duplicates() const { return m_iDuplicates; }
+    void           products( const QString &qsType, ProductList &products ) const;
+    void           observations( ProductList &products ) const;
+
+private:
+    void       remove( int iIndex );
+    void       evict();
+    void       decode( Product &product ) const;
+    QByteArray key( const QByteArray &type, const QByteArray &location ) const;
+
+    QVector<Product>       m_products;
+    QHash<QByteArray, int> m_index;        // Type and location to the product index
+    int                    m_iLatest;      // Most recently added or replaced product
+    int                    m_iDuplicates;
+};
+
+#endif // __WEATHERSTORE_H__
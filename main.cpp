@@ -4,23 +4,160 @@ Stratux AHRS Display
 */
 
 #include <QGuiApplication>
+#include <QCoreApplication>
 #include <QFontDatabase>
 #include <QDesktopWidget>
+#include <QSettings>
+#include <QTimer>
+
+#include <string.h>
 
 #include "AHRSMainWin.h"
+#include "HeadlessPipeline.h"
+#include "RenderHarness.h"
+#include "StreamReader.h"
 
 bool g_bEmulated = false;
 
 
+// Names QSettings uses to find the configuration so they have to be set before anything reads it
+static void setAppNames()
+{
+    QCoreApplication::setOrganizationName( "Unexploded Minds" );
+    QCoreApplication::setOrganizationDomain( "unexplodedminds.com" );
+    QCoreApplication::setApplicationName( "Rosco" );
+}
+
+
+// Run just the stream pipeline with no display for soak testing
+// Arguments after "headless":
+//     gdl90 | websockets   stream source (defaults to the configured one)
+//     log=<seconds>        how often to log a line of stats (default 10, 0 for never)
+//     run=<seconds>        quit after this long (default is to run until killed)
+// Metrics are served the same way as the display if Global/MetricsPort is set.
+static int headlessMain( int argc, char *argv[] )
+{
+    QCoreApplication   coreApp( argc, argv );
+    QStringList        args( coreApp.arguments() );
+    QString            qsArg;
+    QSettings          config;
+    AHRS::StreamSource eSource;
+    int                iLogSecs = 10;
+    int                iRunSecs = 0;
+    int                iMetricsPort;
+
+    config.beginGroup( "Global" );
+    eSource = static_cast<AHRS::StreamSource>( config.value( "StreamSource", static_cast<int>( AHRS::WebSocketSource ) ).toInt() );
+    iMetricsPort = config.value( "MetricsPort", 0 ).toInt();
+    config.endGroup();
+
+    foreach( qsArg, args )
+    {
+        if( qsArg == "gdl90" )
+            eSource = AHRS::GDL90Source;
+        else if( qsArg == "websockets" )
+            eSource = AHRS::WebSocketSource;
+        else if( qsArg.startsWith( "log=" ) )
+            iLogSecs = qsArg.mid( 4 ).toInt();
+        else if( qsArg.startsWith( "run=" ) )
+            iRunSecs = qsArg.mid( 4 ).toInt();
+    }
+
+    HeadlessPipeline pipeline;
+    MetricsServer    metrics;
+
+    if( iMetricsPort > 0 )
+    {
+        metrics.addSource( pipeline.streamReader() );
+        metrics.addSource( &pipeline );
+        if( metrics.listen( static_cast<quint16>( iMetricsPort ) ) )
+            StreamStats::setTiming( true );
+    }
+
+    pipeline.start( eSource, iLogSecs );
+    if( iRunSecs > 0 )
+        QTimer::singleShot( iRunSecs * 1000, &coreApp, SLOT( quit() ) );
+
+    return coreApp.exec();
+}
+
+
+// Render frames offscreen from a fixed input sequence for benchmarking and golden image checks
+// Arguments after "render":
+//     size=<w>x<h>         frame size (default 733x1100, the emulated display)
+//     frames=<n>           number of frames (default 200)
+//     step=<ms>            scenario time between frames (default 50)
+//     scenario=<file>      recorded websocket session to play instead of the built-in flight
+//     out=<dir>            write each frame there as a PNG
+//     golden=<dir>         compare each frame to the PNG of the same name there; exits with 1 on any difference
+//     tolerance=<n>        per channel difference still treated as a match (default 0)
+//     allocs=<n>           most heap allocations a frame past the warm-up may make; exits with 3 if one makes more
+//                          (needs a CONFIG+=alloc_tracking build, where it defaults to 0; -1 for no limit)
+// Uses the offscreen platform unless another one is asked for so it runs without a display or GPU.
+static int renderMain( int argc, char *argv[] )
+{
+    if( qgetenv( "QT_QPA_PLATFORM" ).isEmpty() )
+        qputenv( "QT_QPA_PLATFORM", "offscreen" );
+
+    QApplication           guiApp( argc, argv );
+    QStringList            args( guiApp.arguments() );
+    QString                qsArg;
+    RenderHarness::Options options;
+
+    RenderHarness::defaultOptions( options );
+    foreach( qsArg, args )
+    {
+        if( qsArg.startsWith( "size=" ) )
+        {
+            QStringList qslSize( qsArg.mid( 5 ).split( 'x' ) );
+
+            if( qslSize.count() == 2 )
+            {
+                options.iWidth = qMax( qslSize.at( 0 ).toInt(), 100 );
+                options.iHeight = qMax( qslSize.at( 1 ).toInt(), 100 );
+            }
+        }
+        else if( qsArg.startsWith( "frames=" ) )
+            options.iFrames = qMax( qsArg.mid( 7 ).toInt(), 1 );
+        else if( qsArg.startsWith( "step=" ) )
+            options.iFrameMs = qMax( qsArg.mid( 5 ).toInt(), 1 );
+        else if( qsArg.startsWith( "scenario=" ) )
+            options.qsScenario = qsArg.mid( 9 );
+        else if( qsArg.startsWith( "out=" ) )
+            options.qsOutDir = qsArg.mid( 4 );
+        else if( qsArg.startsWith( "golden=" ) )
+            options.qsGoldenDir = qsArg.mid( 7 );
+        else if( qsArg.startsWith( "tolerance=" ) )
+            options.iTolerance = qsArg.mid( 10 ).toInt();
+        else if( qsArg.startsWith( "allocs=" ) )
+            options.iAllocBudget = qMax( qsArg.mid( 7 ).toInt(), -1 );
+    }
+
+    RenderHarness harness( options );
+
+    return harness.run();
+}
+
+
 int main( int argc, char *argv[] )
 {
+    int i;
+
+    setAppNames();
+
+    // These modes have to be decided before any application object exists since they need a different one
+    for( i = 1; i < argc; i++ )
+    {
+        if( strcmp( argv[i], "headless" ) == 0 )
+            return headlessMain( argc, argv );
+        else if( strcmp( argv[i], "render" ) == 0 )
+            return renderMain( argc, argv );
+    }
+
     QApplication guiApp( argc, argv );
     QStringList  args( guiApp.arguments() );
     AHRSMainWin  mainWin;
 
-    QCoreApplication::setOrganizationName( "Unexploded Minds" );
-    QCoreApplication::setOrganizationDomain( "unexplodedminds.com" );
-    QCoreApplication::setApplicationName( "Rosco" );
     QGuiApplication::setApplicationDisplayName( "Rosco" );
 
 //  guiApp.setAttribute( Qt::AA_EnableHighDpiScaling );
@@ -0,0 +1,10 @@
+include( ../tests.pri )
+
+TARGET = tst_gdl90framer
+
+SOURCES += \
+    tst_GDL90Framer.cpp \
+    GDL90Framer.cpp
+
+HEADERS += \
+    GDL90Framer.h
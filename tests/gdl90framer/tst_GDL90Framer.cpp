@@ -0,0 +1,264 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QtTest>
+#include <QByteArray>
+
+#include "GDL90Framer.h"
+
+
+class TestGDL90Framer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void crcCheckValues();
+    void crcMatchesBitwise();
+    void unstuff();
+    void heartbeatFrame();
+    void escapedFrame();
+    void backToBackFlags();
+    void truncatedFrame();
+    void badFrames();
+    void crcBenchmark();
+    void datagramBenchmark();
+};
+
+
+// The spec's CRC step (crc = T[crc >> 8] ^ (crc << 8) ^ byte) with the table entry worked out a bit at a
+// time; what the sliced tables have to agree with
+static quint16 bitwiseCRC( const QByteArray &data )
+{
+    quint16 uiCRC = 0;
+    quint16 uiEntry;
+
+    for( int i = 0; i < data.size(); i++ )
+    {
+        uiEntry = static_cast<quint16>( uiCRC & 0xFF00 );
+        for( int iBit = 0; iBit < 8; iBit++ )
+            uiEntry = static_cast<quint16>( (uiEntry << 1) ^ ((uiEntry & 0x8000) ? 0x1021 : 0) );
+        uiCRC = static_cast<quint16>( uiEntry ^ (uiCRC << 8) ^ static_cast<uchar>( data.at( i ) ) );
+    }
+
+    return uiCRC;
+}
+
+
+// Wrap a message the way the Stratux sends it: CRC low byte first, escapes, and a flag at each end
+static QByteArray frame( const QByteArray &msg )
+{
+    QByteArray body( msg );
+    QByteArray framed;
+    quint16    uiCRC = bitwiseCRC( msg );
+
+    body.append( static_cast<char>( uiCRC & 0xFF ) );
+    body.append( static_cast<char>( uiCRC >> 8 ) );
+    framed.append( static_cast<char>( 0x7E ) );
+    for( int i = 0; i < body.size(); i++ )
+    {
+        if( (body.at( i ) == static_cast<char>( 0x7E )) || (body.at( i ) == static_cast<char>( 0x7D )) )
+        {
+            framed.append( static_cast<char>( 0x7D ) );
+            framed.append( static_cast<char>( body.at( i ) ^ 0x20 ) );
+        }
+        else
+            framed.append( body.at( i ) );
+    }
+    framed.append( static_cast<char>( 0x7E ) );
+
+    return framed;
+}
+
+
+static const uchar *bytes( const QByteArray &data )
+{
+    return reinterpret_cast<const uchar *>( data.constData() );
+}
+
+
+// The heartbeat example from the GDL90 spec and the usual "123456789" check string
+// The spec folds each byte in after the table lookup rather than before so the check value isn't XMODEM's 0x31C3.
+void TestGDL90Framer::crcCheckValues()
+{
+    QByteArray check( "123456789" );
+    QByteArray heartbeat( QByteArray::fromHex( "008141DBD00802" ) );
+
+    QCOMPARE( GDL90Framer::crc( bytes( check ), check.size() ), static_cast<quint16>( 0xBEEF ) );
+    QCOMPARE( GDL90Framer::crc( bytes( heartbeat ), heartbeat.size() ), static_cast<quint16>( 0x8BB3 ) );
+    QCOMPARE( GDL90Framer::crc( bytes( check ), 0 ), static_cast<quint16>( 0 ) );
+}
+
+
+// Every length either side of the eight byte blocks, so the tail loop is covered as well
+void TestGDL90Framer::crcMatchesBitwise()
+{
+    QByteArray data;
+
+    for( int i = 0; i < 67; i++ )
+    {
+        QCOMPARE( GDL90Framer::crc( bytes( data ), data.size() ), bitwiseCRC( data ) );
+        data.append( static_cast<char>( (i * 37) + 11 ) );
+    }
+}
+
+
+void TestGDL90Framer::unstuff()
+{
+    QByteArray plain( QByteArray::fromHex( "0102030405" ) );
+    QByteArray escaped( QByteArray::fromHex( "017D5E027D5D03" ) );
+    QByteArray trailing( QByteArray::fromHex( "01027D" ) );
+
+    QCOMPARE( GDL90Framer::unstuff( reinterpret_cast<uchar *>( plain.data() ), plain.size() ), 5 );
+    QCOMPARE( plain, QByteArray::fromHex( "0102030405" ) );
+    QCOMPARE( GDL90Framer::unstuff( reinterpret_cast<uchar *>( escaped.data() ), escaped.size() ), 5 );
+    QCOMPARE( escaped.left( 5 ), QByteArray::fromHex( "017E027D03" ) );
+    QCOMPARE( GDL90Framer::unstuff( reinterpret_cast<uchar *>( trailing.data() ), trailing.size() ), -1 );
+}
+
+
+void TestGDL90Framer::heartbeatFrame()
+{
+    QByteArray datagram( QByteArray::fromHex( "7E008141DBD00802B38B7E" ) );
+    int        iPos = 0;
+    uchar     *pMsg = 0;
+
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), 7 );
+    QCOMPARE( QByteArray( reinterpret_cast<const char *>( pMsg ), 7 ), QByteArray::fromHex( "008141DBD00802" ) );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), 0 );
+}
+
+
+// Flag and escape bytes in the message (and possibly the CRC) come back out after unstuffing
+void TestGDL90Framer::escapedFrame()
+{
+    QByteArray msg( QByteArray::fromHex( "0A7E7D7E0B7D" ) );
+    QByteArray datagram( frame( msg ) );
+    int        iPos = 0;
+    uchar     *pMsg = 0;
+
+    QVERIFY( datagram.size() > (msg.size() + 4) );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), msg.size() );
+    QCOMPARE( QByteArray( reinterpret_cast<const char *>( pMsg ), msg.size() ), msg );
+}
+
+
+// One flag between frames, doubled flags and garbage before the first flag all split the same way
+void TestGDL90Framer::backToBackFlags()
+{
+    QByteArray first( QByteArray::fromHex( "0A0102" ) );
+    QByteArray second( QByteArray::fromHex( "14AABBCC" ) );
+    QByteArray shared( frame( first ) );
+    QByteArray datagram;
+    int        iPos = 0;
+    uchar     *pMsg = 0;
+
+    // Closing flag of the first doubles as the opening flag of the second
+    shared.chop( 1 );
+    datagram = QByteArray::fromHex( "3132" ) + shared + frame( second ) + frame( first ) + QByteArray::fromHex( "7E7E" ) + frame( second );
+
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), first.size() );
+    QCOMPARE( static_cast<int>( pMsg[0] ), 0x0A );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), second.size() );
+    QCOMPARE( static_cast<int>( pMsg[0] ), 0x14 );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), first.size() );
+    QCOMPARE( static_cast<int>( pMsg[0] ), 0x0A );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), second.size() );
+    QCOMPARE( static_cast<int>( pMsg[0] ), 0x14 );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), 0 );
+    QCOMPARE( iPos, datagram.size() );
+}
+
+
+// A frame with no closing flag is the end of the datagram, not a message
+void TestGDL90Framer::truncatedFrame()
+{
+    QByteArray whole( frame( QByteArray::fromHex( "0A0102" ) ) );
+    QByteArray datagram( whole + frame( QByteArray::fromHex( "14AABBCC" ) ).left( 5 ) );
+    int        iPos = 0;
+    uchar     *pMsg = 0;
+
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), 3 );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), 0 );
+    QCOMPARE( iPos, datagram.size() );
+
+    // Nothing but an opening flag
+    datagram = QByteArray::fromHex( "7E" );
+    iPos = 0;
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), 0 );
+}
+
+
+// A bad CRC, a frame too short to hold one and an escape at the end are all skipped over
+void TestGDL90Framer::badFrames()
+{
+    QByteArray corrupt( frame( QByteArray::fromHex( "0A0102" ) ) );
+    QByteArray datagram;
+    int        iPos = 0;
+    uchar     *pMsg = 0;
+
+    corrupt[2] = static_cast<char>( 0x03 );
+    datagram = corrupt + QByteArray::fromHex( "7E01027E" ) + QByteArray::fromHex( "7E0A01027D7E" ) + frame( QByteArray::fromHex( "14AABBCC" ) );
+
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), -1 );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), -1 );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), -1 );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), 4 );
+    QCOMPARE( static_cast<int>( pMsg[0] ), 0x14 );
+    QCOMPARE( GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg ), 0 );
+}
+
+
+// CRC over a message the size of a long uplink
+void TestGDL90Framer::crcBenchmark()
+{
+    QByteArray data( 436, 0 );
+    quint16    uiCRC = 0;
+
+    for( int i = 0; i < data.size(); i++ )
+        data[i] = static_cast<char>( (i * 73) + 5 );
+
+    QBENCHMARK
+    {
+        uiCRC ^= GDL90Framer::crc( bytes( data ), data.size() );
+    }
+    Q_UNUSED( uiCRC );
+}
+
+
+// Splitting a datagram of traffic reports, about what one UDP packet from the Stratux carries
+void TestGDL90Framer::datagramBenchmark()
+{
+    QByteArray report( QByteArray::fromHex( "1400AB45491FEF15A889780F09A907B00120014E38323556202020007D7E" ) );
+    QByteArray pristine;
+    QByteArray datagram;
+    int        iFrames = 0;
+
+    for( int i = 0; i < 40; i++ )
+    {
+        report[1] = static_cast<char>( i );
+        pristine += frame( report );
+    }
+
+    QBENCHMARK
+    {
+        int    iPos = 0;
+        int    iLen;
+        uchar *pMsg = 0;
+
+        // Framing works in place so every pass starts from a fresh copy
+        datagram = pristine;
+        while( (iLen = GDL90Framer::nextFrame( reinterpret_cast<uchar *>( datagram.data() ), datagram.size(), iPos, &pMsg )) != 0 )
+        {
+            if( iLen > 0 )
+                iFrames++;
+        }
+    }
+    QVERIFY( iFrames > 0 );
+}
+
+
+QTEST_APPLESS_MAIN( TestGDL90Framer )
+
+#include "tst_GDL90Framer.moc"
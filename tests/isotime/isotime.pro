@@ -0,0 +1,10 @@
+include( ../tests.pri )
+
+TARGET = tst_isotime
+
+SOURCES += \
+    tst_ISOTime.cpp \
+    ISOTime.cpp
+
+HEADERS += \
+    ISOTime.h
@@ -0,0 +1,213 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QtTest>
+#include <QString>
+#include <QDateTime>
+
+#include "ISOTime.h"
+
+
+class TestISOTime : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+    void latin1_data();
+    void latin1();
+    void reference_data();
+    void reference();
+    void conversions();
+    void matchesQDateTime_data();
+    void matchesQDateTime();
+    void parseBenchmark();
+    void qDateTimeBenchmark();
+};
+
+
+// Seconds since the epoch and nanoseconds for everything that should parse; the times are ignored for the rest
+void TestISOTime::parse_data()
+{
+    QTest::addColumn<QString>( "text" );
+    QTest::addColumn<bool>( "valid" );
+    QTest::addColumn<qint64>( "secs" );
+    QTest::addColumn<int>( "nanos" );
+
+    QTest::newRow( "nanoseconds" ) << QString( "2018-05-06T17:04:05.123456789Z" ) << true << Q_INT64_C( 1525626245 ) << 123456789;
+    QTest::newRow( "milliseconds" ) << QString( "2018-05-06T17:04:05.123Z" ) << true << Q_INT64_C( 1525626245 ) << 123000000;
+    QTest::newRow( "past nanoseconds" ) << QString( "2018-05-06T17:04:05.1234567891Z" ) << true << Q_INT64_C( 1525626245 ) << 123456789;
+    QTest::newRow( "no fraction" ) << QString( "2018-05-06T17:04:05Z" ) << true << Q_INT64_C( 1525626245 ) << 0;
+    QTest::newRow( "no zone" ) << QString( "2018-05-06T17:04:05" ) << true << Q_INT64_C( 1525626245 ) << 0;
+    QTest::newRow( "lower case" ) << QString( "2018-05-06t17:04:05z" ) << true << Q_INT64_C( 1525626245 ) << 0;
+    QTest::newRow( "space separator" ) << QString( "2018-05-06 17:04:05Z" ) << true << Q_INT64_C( 1525626245 ) << 0;
+    QTest::newRow( "negative offset" ) << QString( "2018-05-06T12:04:05.5-05:00" ) << true << Q_INT64_C( 1525626245 ) << 500000000;
+    QTest::newRow( "offset without colon" ) << QString( "2018-05-06T19:04:05+0200" ) << true << Q_INT64_C( 1525626245 ) << 0;
+    QTest::newRow( "zero offset" ) << QString( "2018-05-06T17:04:05+00:00" ) << true << Q_INT64_C( 1525626245 ) << 0;
+    QTest::newRow( "hours only offset" ) << QString( "2018-05-06T18:04:05+01" ) << true << Q_INT64_C( 1525626245 ) << 0;
+    QTest::newRow( "before the epoch" ) << QString( "1969-12-31T23:59:59.999Z" ) << true << Q_INT64_C( -1 ) << 999000000;
+    QTest::newRow( "leap day" ) << QString( "2000-02-29T00:00:00Z" ) << true << Q_INT64_C( 951782400 ) << 0;
+    QTest::newRow( "leap second" ) << QString( "2016-12-31T23:59:60Z" ) << true << Q_INT64_C( 1483228800 ) << 0;
+    QTest::newRow( "Go zero time" ) << QString( "0001-01-01T00:00:00Z" ) << true << Q_INT64_C( -62135596800 ) << 0;
+
+    QTest::newRow( "empty" ) << QString() << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "date only" ) << QString( "2018-05-06" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "no seconds" ) << QString( "2018-05-06T17:04Z" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "month 13" ) << QString( "2018-13-06T17:04:05Z" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "day 0" ) << QString( "2018-05-00T17:04:05Z" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "hour 24" ) << QString( "2018-05-06T24:04:05Z" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "letter in date" ) << QString( "2018-O5-06T17:04:05Z" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "wrong separator" ) << QString( "2018/05/06T17:04:05Z" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "empty fraction" ) << QString( "2018-05-06T17:04:05.Z" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "junk after" ) << QString( "2018-05-06T17:04:05.1X" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "junk after zone" ) << QString( "2018-05-06T17:04:05ZZ" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "short offset" ) << QString( "2018-05-06T17:04:05+5" ) << false << Q_INT64_C( 0 ) << 0;
+    QTest::newRow( "short offset minutes" ) << QString( "2018-05-06T17:04:05+05:3" ) << false << Q_INT64_C( 0 ) << 0;
+}
+
+
+void TestISOTime::parse()
+{
+    QFETCH( QString, text );
+    QFETCH( bool, valid );
+    QFETCH( qint64, secs );
+    QFETCH( int, nanos );
+
+    qint64 iSecs = 0;
+    int    iNanos = 0;
+
+    QCOMPARE( ISOTime::parse( text, iSecs, iNanos ), valid );
+    if( valid )
+    {
+        QCOMPARE( iSecs, secs );
+        QCOMPARE( iNanos, nanos );
+    }
+}
+
+
+// The message buffer version has to agree with the QString one
+void TestISOTime::latin1_data()
+{
+    parse_data();
+}
+
+
+void TestISOTime::latin1()
+{
+    QFETCH( QString, text );
+    QFETCH( bool, valid );
+    QFETCH( qint64, secs );
+    QFETCH( int, nanos );
+
+    QByteArray latin1( text.toLatin1() );
+    qint64     iSecs = 0;
+    int        iNanos = 0;
+
+    QCOMPARE( ISOTime::parse( latin1.constData(), latin1.size(), iSecs, iNanos ), valid );
+    if( valid )
+    {
+        QCOMPARE( iSecs, secs );
+        QCOMPARE( iNanos, nanos );
+    }
+}
+
+
+// A time in the middle of a message, as StreamReader hands them over, has to stop at the end of its field
+void TestISOTime::reference_data()
+{
+    parse_data();
+}
+
+
+void TestISOTime::reference()
+{
+    QFETCH( QString, text );
+    QFETCH( bool, valid );
+    QFETCH( qint64, secs );
+    QFETCH( int, nanos );
+
+    QString qsMessage( "{\"Time\":\"" + text + "1Z\"}" );
+    qint64  iSecs = 0;
+    int     iNanos = 0;
+
+    QCOMPARE( ISOTime::parse( QStringRef( &qsMessage, 9, text.length() ), iSecs, iNanos ), valid );
+    if( valid )
+    {
+        QCOMPARE( iSecs, secs );
+        QCOMPARE( iNanos, nanos );
+        QCOMPARE( ISOTime::toMSecs( QStringRef( &qsMessage, 9, text.length() ) ), ISOTime::toMSecs( text ) );
+    }
+}
+
+
+// Go's zero time and anything that doesn't parse come out as 0, as does a nanosecond count past 2262
+void TestISOTime::conversions()
+{
+    QCOMPARE( ISOTime::toMSecs( QString( "2018-05-06T17:04:05.123456789Z" ) ), Q_INT64_C( 1525626245123 ) );
+    QCOMPARE( ISOTime::toNSecs( QString( "2018-05-06T17:04:05.123456789Z" ) ), Q_INT64_C( 1525626245123456789 ) );
+    QCOMPARE( ISOTime::toMSecs( QString( "1969-12-31T23:59:59.999Z" ) ), Q_INT64_C( -1 ) );
+    QCOMPARE( ISOTime::toMSecs( QString( "0001-01-01T00:00:00Z" ) ), Q_INT64_C( 0 ) );
+    QCOMPARE( ISOTime::toNSecs( QString( "0001-01-01T00:00:00Z" ) ), Q_INT64_C( 0 ) );
+    QCOMPARE( ISOTime::toMSecs( QString( "not a time" ) ), Q_INT64_C( 0 ) );
+    QCOMPARE( ISOTime::toNSecs( QString( "not a time" ) ), Q_INT64_C( 0 ) );
+    QCOMPARE( ISOTime::toMSecs( QString( "2300-01-01T00:00:00Z" ) ), Q_INT64_C( 10413792000000 ) );
+    QCOMPARE( ISOTime::toNSecs( QString( "2300-01-01T00:00:00Z" ) ), Q_INT64_C( 0 ) );
+}
+
+
+// Times QDateTime reads the same way (no more than millisecond fractions, which it rounds rather than truncates)
+void TestISOTime::matchesQDateTime_data()
+{
+    QTest::addColumn<QString>( "text" );
+
+    QTest::newRow( "Z" ) << QString( "2018-05-06T17:04:05Z" );
+    QTest::newRow( "milliseconds" ) << QString( "2018-05-06T17:04:05.123Z" );
+    QTest::newRow( "positive offset" ) << QString( "2018-05-06T19:04:05.250+02:00" );
+    QTest::newRow( "negative offset" ) << QString( "2018-05-06T12:04:05-05:00" );
+    QTest::newRow( "before the epoch" ) << QString( "1969-07-20T20:17:40Z" );
+    QTest::newRow( "leap day" ) << QString( "2024-02-29T23:59:59.999Z" );
+}
+
+
+void TestISOTime::matchesQDateTime()
+{
+    QFETCH( QString, text );
+
+    QCOMPARE( ISOTime::toMSecs( text ), QDateTime::fromString( text, Qt::ISODateWithMs ).toMSecsSinceEpoch() );
+}
+
+
+// A time the way the situation stream sends them
+void TestISOTime::parseBenchmark()
+{
+    QString qsTime( "2018-05-06T17:04:05.123Z" );
+    qint64  iTotal = 0;
+
+    QBENCHMARK
+    {
+        iTotal += ISOTime::toMSecs( qsTime );
+    }
+    QVERIFY( iTotal != 0 );
+}
+
+
+// The same time through QDateTime for comparison
+void TestISOTime::qDateTimeBenchmark()
+{
+    QString qsTime( "2018-05-06T17:04:05.123Z" );
+    qint64  iTotal = 0;
+
+    QBENCHMARK
+    {
+        iTotal += QDateTime::fromString( qsTime, Qt::ISODateWithMs ).toMSecsSinceEpoch();
+    }
+    QVERIFY( iTotal != 0 );
+}
+
+
+QTEST_APPLESS_MAIN( TestISOTime )
+
+#include "tst_ISOTime.moc"
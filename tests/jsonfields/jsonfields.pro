@@ -0,0 +1,10 @@
+include( ../tests.pri )
+
+TARGET = tst_jsonfields
+
+SOURCES += \
+    tst_JsonFields.cpp \
+    JsonFields.cpp
+
+HEADERS += \
+    JsonFields.h
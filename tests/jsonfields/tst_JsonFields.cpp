@@ -0,0 +1,157 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QtTest>
+#include <QString>
+#include <QStringList>
+
+#include "JsonFields.h"
+
+
+class TestJsonFields : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fields_data();
+    void fields();
+    void referencesMessage();
+    void situationBenchmark();
+    void splitBenchmark();
+};
+
+
+// A situation message the way the Stratux sends it
+static const char *szSituation =
+    "{\"GPSLastFixSinceMidnightUTC\":61445.6,\"GPSLatitude\":45.1234,\"GPSLongitude\":-93.5678,\"GPSFixQuality\":2,"
+    "\"GPSHeightAboveEllipsoid\":1032.8,\"GPSGeoidSep\":-95.1,\"GPSSatellites\":9,\"GPSSatellitesTracked\":14,"
+    "\"GPSSatellitesSeen\":12,\"GPSHorizontalAccuracy\":3.2,\"GPSNACp\":10,\"GPSAltitudeMSL\":1127.9,"
+    "\"GPSVerticalAccuracy\":6.4,\"GPSVerticalSpeed\":0.2,\"GPSLastFixLocalTime\":\"0001-01-01T00:06:44.23Z\","
+    "\"GPSTrueCourse\":271.3,\"GPSTurnRate\":0,\"GPSGroundSpeed\":103.5,\"GPSLastGroundTrackTime\":\"0001-01-01T00:06:44.23Z\","
+    "\"GPSTime\":\"2018-05-06T17:04:05.6Z\",\"GPSLastGPSTimeStratuxTime\":\"0001-01-01T00:06:43.65Z\","
+    "\"GPSLastValidNMEAMessageTime\":\"0001-01-01T00:06:44.23Z\","
+    "\"GPSLastValidNMEAMessage\":\"$PUBX,00,170405.60,4507.40400,N,09334.06800,W,343.793,G3,2.1,3.4,191.7,271.3,0.1,,0.92,1.36,0.88,9,0,0*4A\","
+    "\"GPSPositionSampleRate\":10,\"BaroTemperature\":28.5,\"BaroPressureAltitude\":1105.2,\"BaroVerticalSpeed\":-12.3,"
+    "\"BaroLastMeasurementTime\":\"0001-01-01T00:06:44.25Z\",\"AHRSPitch\":2.4,\"AHRSRoll\":-10.7,\"AHRSGyroHeading\":272.1,"
+    "\"AHRSMagHeading\":268.4,\"AHRSSlipSkid\":-0.8,\"AHRSTurnRate\":-1.5,\"AHRSGLoad\":1.02,\"AHRSGLoadMin\":0.97,"
+    "\"AHRSGLoadMax\":1.11,\"AHRSLastAttitudeTime\":\"0001-01-01T00:06:44.28Z\",\"AHRSStatus\":7}";
+
+
+// Each row is a message and the tag=value pairs that should come out of it in order
+void TestJsonFields::fields_data()
+{
+    QTest::addColumn<QString>( "message" );
+    QTest::addColumn<QStringList>( "expected" );
+
+    QTest::newRow( "scalars" ) << QString( "{\"Alt\":4500,\"Lat\":45.1234,\"OnGround\":false,\"Tail\":null}" )
+                               << (QStringList() << "Alt=4500" << "Lat=45.1234" << "OnGround=false" << "Tail=null");
+    QTest::newRow( "strings" ) << QString( "{\"Reg\":\"N123RS\",\"Tail\":\"\",\"Timestamp\":\"2018-05-06T17:04:05Z\"}" )
+                               << (QStringList() << "Reg=N123RS" << "Tail=" << "Timestamp=2018-05-06T17:04:05Z");
+    QTest::newRow( "commas in a string" ) << QString( "{\"GPSLastValidNMEAMessage\":\"$GPGGA,170405,4507.404,N\",\"GPSSatellites\":9}" )
+                                          << (QStringList() << "GPSLastValidNMEAMessage=$GPGGA,170405,4507.404,N" << "GPSSatellites=9");
+    QTest::newRow( "braces and colons in a string" ) << QString( "{\"Data\":\"KSEA {x}: [y]\",\"Type\":\"METAR\"}" )
+                                                     << (QStringList() << "Data=KSEA {x}: [y]" << "Type=METAR");
+    QTest::newRow( "white space" ) << QString( "{ \"Alt\" : 4500 ,\n \"Reg\" :\t\"N1\" }" )
+                                   << (QStringList() << "Alt=4500" << "Reg=N1");
+    QTest::newRow( "nested object" ) << QString( "{\"A\":1,\"B\":{\"C\":\"x\",\"D\":2},\"E\":3}" )
+                                     << (QStringList() << "A=1" << "B=" << "C=x" << "D=2" << "E=3");
+    QTest::newRow( "arrays" ) << QString( "{\"Errors\":[\"no GPS\",\"low power\"],\"Counts\":[1,2,3],\"Devices\":[{\"Id\":4}],\"Up\":true}" )
+                              << (QStringList() << "Errors=" << "Counts=" << "Devices=" << "Id=4" << "Up=true");
+    QTest::newRow( "escaped quote" ) << QString( "{\"Data\":\"say \\\"again\\\"\",\"Type\":\"PIREP\"}" )
+                                     << (QStringList() << "Data=say \\\"again\\\"" << "Type=PIREP");
+    QTest::newRow( "unterminated string" ) << QString( "{\"Alt\":4500,\"Reg\":\"N12" )
+                                           << (QStringList() << "Alt=4500" << "Reg=N12");
+    QTest::newRow( "unterminated tag" ) << QString( "{\"Alt\":4500,\"Re" )
+                                        << (QStringList() << "Alt=4500");
+    QTest::newRow( "no value" ) << QString( "{\"Alt\":" )
+                                << (QStringList() << "Alt=");
+    QTest::newRow( "empty" ) << QString() << QStringList();
+    QTest::newRow( "not JSON" ) << QString( "garbage, more garbage" ) << QStringList();
+}
+
+
+void TestJsonFields::fields()
+{
+    QFETCH( QString, message );
+    QFETCH( QStringList, expected );
+
+    JsonFields  fields( message );
+    QStringList found;
+
+    while( fields.next() )
+        found.append( fields.tag().toString() + "=" + fields.value().toString() );
+    QCOMPARE( found, expected );
+    QVERIFY( !fields.next() );
+}
+
+
+// The tags and values point into the message itself rather than into copies of it
+void TestJsonFields::referencesMessage()
+{
+    QString    qsMessage( "{\"Reg\":\"N123RS\"}" );
+    JsonFields fields( qsMessage );
+
+    QVERIFY( fields.next() );
+    QVERIFY( fields.tag().string() == &qsMessage );
+    QCOMPARE( fields.tag().position(), 2 );
+    QVERIFY( fields.value().string() == &qsMessage );
+    QCOMPARE( fields.value().position(), 8 );
+    QCOMPARE( fields.value().length(), 6 );
+}
+
+
+// Walking a full situation message and reading every value as a number the way StreamReader does
+void TestJsonFields::situationBenchmark()
+{
+    QString qsMessage( QString::fromLatin1( szSituation ) );
+    double  dTotal = 0.0;
+    int     iFields = 0;
+
+    QBENCHMARK
+    {
+        JsonFields fields( qsMessage );
+
+        while( fields.next() )
+        {
+            dTotal += fields.value().toDouble();
+            iFields++;
+        }
+    }
+    QVERIFY( iFields > 0 );
+    Q_UNUSED( dTotal );
+}
+
+
+// The same message through the split() parsing StreamReader used before, for comparison
+void TestJsonFields::splitBenchmark()
+{
+    QString qsMessage( QString::fromLatin1( szSituation ) );
+    double  dTotal = 0.0;
+    int     iFields = 0;
+
+    QBENCHMARK
+    {
+        QStringList qslFields( qsMessage.split( ',' ) );
+        QStringList qslThisField;
+        QString     qsVal;
+
+        foreach( const QString &qsField, qslFields )
+        {
+            qslThisField = qsField.split( "\":" );
+            if( qslThisField.count() != 2 )
+                continue;
+            qsVal = qslThisField.last().trimmed().remove( '\"' ).remove( '}' );
+            dTotal += qsVal.toDouble();
+            iFields++;
+        }
+    }
+    QVERIFY( iFields > 0 );
+    Q_UNUSED( dTotal );
+}
+
+
+QTEST_APPLESS_MAIN( TestJsonFields )
+
+#include "tst_JsonFields.moc"
@@ -0,0 +1,87 @@
+include( ../tests.pri )
+
+# The whole display is built in with its allocator hooks so every allocation painting a frame is counted
+QT += gui widgets websockets network
+
+DEFINES += ALLOC_TRACKING
+
+TARGET = tst_renderallocs
+
+VPATH += $$PWD/../../ui
+
+SOURCES += \
+    tst_RenderAllocs.cpp \
+    RenderHarness.cpp \
+    AllocCounter.cpp \
+    StreamReader.cpp \
+    AHRSCanvas.cpp \
+    AHRSMainWin.cpp \
+    BugSelector.cpp \
+    Keypad.cpp \
+    TrafficMath.cpp \
+    Canvas.cpp \
+    MenuDialog.cpp \
+    Builder.cpp \
+    PixmapCache.cpp \
+    GlyphAtlas.cpp \
+    TrafficStore.cpp \
+    AttitudePredictor.cpp \
+    TrafficTrails.cpp \
+    WeatherStore.cpp \
+    WeatherDecoder.cpp \
+    GDL90Decoder.cpp \
+    GDL90Framer.cpp \
+    FISBDecoder.cpp \
+    NexradCache.cpp \
+    StringTable.cpp \
+    ISOTime.cpp \
+    JsonFields.cpp \
+    StreamQueue.cpp \
+    StreamConnection.cpp \
+    StreamStats.cpp \
+    DiagnosticsDialog.cpp \
+    MetricsServer.cpp
+
+HEADERS += \
+    RenderHarness.h \
+    AllocCounter.h \
+    StratuxStreams.h \
+    StreamReader.h \
+    AHRSCanvas.h \
+    AHRSMainWin.h \
+    BugSelector.h \
+    Keypad.h \
+    TrafficMath.h \
+    Canvas.h \
+    AppDefs.h \
+    MenuDialog.h \
+    Builder.h \
+    PixmapCache.h \
+    GlyphAtlas.h \
+    TrafficStore.h \
+    AttitudePredictor.h \
+    TrafficTrails.h \
+    WeatherStore.h \
+    WeatherDecoder.h \
+    GDL90Decoder.h \
+    GDL90Framer.h \
+    FISBDecoder.h \
+    NexradCache.h \
+    StringTable.h \
+    ISOTime.h \
+    JsonFields.h \
+    StreamQueue.h \
+    StreamConnection.h \
+    StreamStats.h \
+    DiagnosticsDialog.h \
+    MetricsServer.h
+
+FORMS += \
+    AHRSMainWin.ui \
+    BugSelector.ui \
+    Keypad.ui \
+    MenuDialog.ui \
+    DiagnosticsDialog.ui
+
+RESOURCES += \
+    $$PWD/../../AHRSResources.qrc
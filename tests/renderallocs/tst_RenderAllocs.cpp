@@ -0,0 +1,72 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QtTest>
+#include <QApplication>
+#include <QVector>
+
+#include <algorithm>
+
+#include "RenderHarness.h"
+#include "AllocCounter.h"
+
+// Normally defined by main.cpp, which isn't part of the test
+bool g_bEmulated = false;
+
+
+#define SteadyFrames 100    // Frames checked after the warm-up; five seconds of the synthetic flight at the default step
+
+
+class TestRenderAllocs : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void steadyFrames();
+};
+
+
+// The core display painted from the synthetic flight shouldn't touch the heap once it's warmed up
+void TestRenderAllocs::steadyFrames()
+{
+    RenderHarness::Options options;
+    int                    iResult;
+
+    QVERIFY( AllocCounter::isEnabled() );
+
+    RenderHarness::defaultOptions( options );
+    options.iFrames = ALLOC_WARMUP_FRAMES + SteadyFrames;
+    options.iAllocBudget = 0;
+
+    RenderHarness harness( options );
+
+    iResult = harness.run();
+    QVERIFY( iResult != 2 );
+
+    const QVector<qint64> &allocs = harness.frameAllocs();
+    QVector<qint64>        expected( allocs );
+
+    // The warm-up frames may allocate; compared as lists so a failure names the first frame after them that did
+    QCOMPARE( allocs.count(), options.iFrames );
+    std::fill( expected.begin() + ALLOC_WARMUP_FRAMES, expected.end(), Q_INT64_C( 0 ) );
+    QCOMPARE( allocs.toList(), expected.toList() );
+    QCOMPARE( iResult, 0 );
+}
+
+
+// The canvas needs a GUI application; the offscreen platform lets it run without a display
+int main( int argc, char *argv[] )
+{
+    if( qgetenv( "QT_QPA_PLATFORM" ).isEmpty() )
+        qputenv( "QT_QPA_PLATFORM", "offscreen" );
+
+    QApplication     app( argc, argv );
+    TestRenderAllocs test;
+
+    QTEST_SET_MAIN_SOURCE_PATH
+    return QTest::qExec( &test, argc, argv );
+}
+
+#include "tst_RenderAllocs.moc"
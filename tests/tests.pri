@@ -0,0 +1,15 @@
+# Common settings for each of the test projects
+# Benchmarks run along with the tests; pass -iterations or -tickcounter to a test for steadier numbers.
+
+QT += testlib
+QT -= gui
+
+CONFIG += testcase console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += $$PWD/../include
+
+VPATH += $$PWD/.. \
+         $$PWD/../include
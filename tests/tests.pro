@@ -0,0 +1,17 @@
+#-------------------------------------------------
+#
+# Unit tests and benchmarks for Rosco that don't need a display or a Stratux;
+# build and run them all with "qmake && make check"
+# renderallocs paints the display on the offscreen platform and fails if a
+# frame past the warm-up allocates
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    weatherdecoder \
+    gdl90framer \
+    isotime \
+    jsonfields \
+    renderallocs
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+#
+# Stratux AHRS Display
+# (c) 2018 Allen K. Lair, Unexploded Minds
+#
+# Writes reports.txt, the corpus the WeatherDecoder throughput benchmark runs over.
+# The reports are generated (seeded, so the file is the same every run) in the shape of the US METARs, SPECIs
+# and TAFs that come off the Stratux weather stream: real station identifiers, KT winds, SM visibilities and
+# the usual remarks. A capture of the weather stream's Data fields, one report per line, can replace the file
+# as it is.
+
+import random
+
+random.seed( 1018 )
+
+STATIONS = """KSEA KBFI KPAE KOLM KPDX KEUG KMFR KBOI KGEG KSFF KYKM KPSC KBLI KAWO KRNT KTIW KHQM KUAO KSLE KRDM
+KSFO KOAK KSJC KSMF KSAC KFAT KBFL KLAX KBUR KVNY KSNA KLGB KSAN KCRQ KPSP KRNO KLAS KVGT KPHX KSDL
+KTUS KABQ KSAF KELP KDEN KAPA KBJC KCOS KPUB KGJT KSLC KOGD KPVU KBIL KBZN KMSO KGTF KHLN KCPR KJAC
+KRAP KFSD KBIS KFAR KGFK KMSP KSTP KDLH KRST KDSM KCID KOMA KLNK KICT KMCI KMKC KSTL KSUS KCOU KSGF
+KTUL KOKC KPWA KDFW KDAL KAFW KFTW KIAH KHOU KSAT KAUS KCRP KLBB KAMA KMAF KELD KLIT KXNA KMEM KBNA
+KTYS KCHA KMSY KBTR KLFT KJAN KBHM KHSV KMOB KPNS KATL KPDK KSAV KJAX KMCO KORL KTPA KPIE KMIA KFLL
+KPBI KRSW KEYW KTLH KCHS KCAE KGSP KCLT KRDU KGSO KILM KORF KRIC KIAD KDCA KBWI KPHL KEWR KTEB KLGA
+KJFK KISP KHPN KBDL KPVD KBOS KBED KPWM KBTV KMHT KALB KSYR KROC KBUF KPIT KCLE KCMH KCVG KDAY KIND
+KSDF KLEX KDTW KGRR KFNT KLAN KORD KMDW KPIA KSPI KMKE KMSN KGRB KATW""".split()
+
+WEATHER = { 'clear': [ '', '', '', 'HZ' ],
+            'rain': [ '-RA', 'RA', '+RA', '-RA BR', 'RA BR', '-DZ', 'VCSH', 'TSRA', '-TSRA', 'VCTS' ],
+            'snow': [ '-SN', 'SN', '-SN BR', '+SN', 'BLSN', '-FZRA' ],
+            'fog': [ 'BR', 'FG', 'FZFG', 'MIFG', 'BCFG', 'BR' ] }
+
+
+def wind():
+    r = random.random()
+    if r < 0.08:
+        return '00000KT'
+    if r < 0.18:
+        return 'VRB%02dKT' % random.randint( 2, 6 )
+    direction = random.randrange( 10, 370, 10 )
+    speed = random.choice( [ 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 17, 18, 20, 22, 25 ] )
+    group = '%03d%02d' % (direction, speed)
+    if (speed >= 12) and (random.random() < 0.45):
+        group += 'G%02d' % (speed + random.randint( 6, 15 ))
+    group += 'KT'
+    if (speed >= 6) and (random.random() < 0.1):
+        group += ' %03dV%03d' % ((direction - 40) % 360 or 360, (direction + 40) % 360 or 360)
+    return group
+
+
+def visibility( kind ):
+    if kind == 'clear':
+        return random.choice( [ '10SM', '10SM', '10SM', '10SM', '9SM', '8SM', '7SM', '6SM' ] )
+    if kind == 'fog':
+        return random.choice( [ 'M1/4SM', '1/4SM', '1/2SM', '3/4SM', '1SM', '1 1/4SM', '1 1/2SM', '2SM', '3SM', '4SM', '5SM' ] )
+    return random.choice( [ '1/2SM', '3/4SM', '1SM', '1 1/2SM', '2SM', '2 1/2SM', '3SM', '4SM', '5SM', '6SM', '7SM', '10SM' ] )
+
+
+def clouds( kind ):
+    if kind == 'fog' and random.random() < 0.35:
+        return 'VV%03d' % random.choice( [ 1, 2, 3, 4, 5, 6, 8 ] )
+    if kind == 'clear' and random.random() < 0.35:
+        return random.choice( [ 'CLR', 'SKC' ] )
+    layers = []
+    base = random.choice( [ 3, 5, 7, 8, 10, 12, 15, 18, 20, 25, 30, 35, 40, 45, 50, 60, 70, 80, 120, 250 ] )
+    if kind != 'clear':
+        base = min( base, random.choice( [ 4, 6, 8, 9, 11, 14, 17, 22, 28 ] ) )
+    for i in range( random.choice( [ 1, 1, 2, 2, 3 ] ) ):
+        cover = random.choice( [ 'FEW', 'SCT', 'BKN', 'OVC' ] if kind != 'clear' else [ 'FEW', 'FEW', 'SCT', 'SCT', 'BKN' ] )
+        layers.append( '%s%03d' % (cover, base) )
+        if cover == 'OVC':
+            break
+        base += random.choice( [ 5, 10, 15, 20, 40, 60 ] )
+    return ' '.join( layers )
+
+
+def temps( kind ):
+    t = random.randint( -25, 38 ) if kind != 'snow' else random.randint( -18, 1 )
+    d = t - (random.randint( 0, 2 ) if kind in ( 'fog', 'rain' ) else random.randint( 2, 20 ))
+    fmt = lambda v: ('M%02d' % -v) if v < 0 else '%02d' % v
+    return '%s/%s' % (fmt( t ), fmt( d )), t, d
+
+
+def metar( station, day, hour, minute ):
+    kind = random.choice( [ 'clear' ] * 6 + [ 'rain' ] * 2 + [ 'snow', 'fog' ] )
+    group, t, d = temps( kind )
+    altimeter = random.randint( 2920, 3065 )
+    parts = [ station, '%02d%02d%02dZ' % (day, hour, minute) ]
+    if random.random() < 0.2:
+        parts.append( 'AUTO' )
+    parts += [ wind(), visibility( kind ) ]
+    weather = random.choice( WEATHER[kind] )
+    if weather:
+        parts.append( weather )
+    parts += [ clouds( kind ), group, 'A%04d' % altimeter, 'RMK', random.choice( [ 'AO2', 'AO2', 'AO1' ] ) ]
+    if random.random() < 0.3:
+        parts.append( 'PK WND %03d%02d/%02d%02d' % (random.randrange( 10, 370, 10 ), random.randint( 26, 45 ), hour, random.randint( 0, 59 )) )
+    if kind == 'rain' and random.random() < 0.5:
+        parts.append( 'RAB%02d' % random.randint( 0, 59 ) )
+    parts.append( 'SLP%03d' % ((altimeter * 338639 // 10000 - 10000 + 10000) % 1000) )
+    if kind in ( 'rain', 'snow' ) and random.random() < 0.6:
+        parts.append( 'P%04d' % random.randint( 0, 35 ) )
+    tenths = lambda v: ('1' if v < 0 else '0') + '%03d' % (abs( v ) * 10 + random.randint( 0, 9 ))
+    parts.append( 'T%s%s' % (tenths( t ), tenths( d )) )
+    if random.random() < 0.1:
+        parts.append( '$' )
+    return ' '.join( parts )
+
+
+def taf( station, day, hour ):
+    start = hour - (hour % 6)
+    parts = [ station, '%02d%02d%02dZ' % (day, hour, 20 + random.randint( 0, 30 )), '%02d%02d/%02d%02d' % (day, start, day + 1, start) ]
+    kind = random.choice( [ 'clear' ] * 5 + [ 'rain' ] * 3 + [ 'snow', 'fog' ] )
+    parts += [ wind(), 'P6SM' if kind == 'clear' else visibility( kind ) ]
+    weather = random.choice( WEATHER[kind] )
+    if weather:
+        parts.append( weather )
+    parts.append( clouds( kind ) )
+    change = start
+    for i in range( random.randint( 1, 5 ) ):
+        change += random.choice( [ 2, 3, 4, 5, 6 ] )
+        kind = random.choice( [ 'clear' ] * 5 + [ 'rain' ] * 3 + [ 'snow', 'fog' ] )
+        indicator = random.choice( [ 'FM', 'FM', 'FM', 'TEMPO', 'BECMG', 'PROB30' ] )
+        when = '%02d%02d' % (day + change // 24, change % 24)
+        if indicator == 'FM':
+            parts.append( 'FM%s00' % when )
+            parts.append( wind() )
+        else:
+            parts += [ indicator, '%s/%02d%02d' % (when, day + (change + 3) // 24, (change + 3) % 24) ]
+        parts.append( 'P6SM' if kind == 'clear' else visibility( kind ) )
+        weather = random.choice( WEATHER[kind] )
+        if weather:
+            parts.append( weather )
+        parts.append( clouds( kind ) )
+    return ' '.join( parts )
+
+
+with open( 'reports.txt', 'w' ) as out:
+    out.write( '# Generated by make_reports.py: 3000 METARs and SPECIs and 600 TAFs, one report per line as the Data\n' )
+    out.write( '# field of the weather stream carries it; lines starting with # are skipped.\n' )
+    for i in range( 3600 ):
+        station = random.choice( STATIONS )
+        day = random.randint( 1, 27 )
+        hour = random.randint( 0, 23 )
+        if i % 6 == 5:
+            out.write( taf( station, day, hour ) + '\n' )
+        else:
+            out.write( metar( station, day, hour, 53 if random.random() < 0.85 else random.randint( 0, 59 ) ) + '\n' )
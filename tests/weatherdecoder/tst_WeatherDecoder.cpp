@@ -0,0 +1,128 @@
+/*
+Stratux AHRS Display
+(c) 2018 Allen K. Lair, Unexploded Minds
+*/
+
+#include <QtTest>
+#include <QByteArray>
+#include <QVector>
+#include <QFile>
+
+#include "WeatherDecoder.h"
+
+
+class TestWeatherDecoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void decode_data();
+    void decode();
+    void throughput();
+};
+
+
+// Each row is a report and what should come out of it
+// Visibility is in statute miles, wind in knots and the ceiling in feet; -1 is unknown (or none for gusts and ceiling).
+void TestWeatherDecoder::decode_data()
+{
+    QTest::addColumn<QByteArray>( "report" );
+    QTest::addColumn<bool>( "valid" );
+    QTest::addColumn<int>( "windDir" );
+    QTest::addColumn<int>( "windSpeed" );
+    QTest::addColumn<int>( "windGust" );
+    QTest::addColumn<double>( "visibility" );
+    QTest::addColumn<int>( "ceiling" );
+    QTest::addColumn<int>( "category" );
+
+    QTest::newRow( "whole and fraction SM" ) << QByteArray( "KBFI 251653Z VRB03KT 1 1/2SM BR OVC008 10/09 A3001" )
+                                             << true << -1 << 3 << -1 << 1.5 << 800 << static_cast<int>( WeatherDecoder::IFR );
+    QTest::newRow( "less than 1/4 SM" ) << QByteArray( "KXYZ 251653Z 00000KT M1/4SM FG VV002 A2990" )
+                                        << true << 0 << 0 << -1 << 0.25 << 200 << static_cast<int>( WeatherDecoder::LIFR );
+    QTest::newRow( "fraction SM" ) << QByteArray( "KXYZ 251653Z 18005KT 1/2SM FG VV004 A2990" )
+                                   << true << 180 << 5 << -1 << 0.5 << 400 << static_cast<int>( WeatherDecoder::LIFR );
+    QTest::newRow( "10 km or more" ) << QByteArray( "EGLL 251650Z 24012MPS 9999 SCT030 15/08 Q1012" )
+                                     << true << 240 << 23 << -1 << 10.0 << -1 << static_cast<int>( WeatherDecoder::VFR );
+    QTest::newRow( "metres" ) << QByteArray( "EGLL 251650Z 24010G20MPS 4000 BKN012 15/08 Q1012" )
+                              << true << 240 << 19 << 39 << 2.4855 << 1200 << static_cast<int>( WeatherDecoder::IFR );
+    QTest::newRow( "variable MPS" ) << QByteArray( "EGLL 251650Z VRB02MPS 9999 FEW030 15/08 Q1012" )
+                                    << true << -1 << 4 << -1 << 10.0 << -1 << static_cast<int>( WeatherDecoder::VFR );
+    QTest::newRow( "CAVOK" ) << QByteArray( "LFPG 251650Z 27010KT CAVOK 18/09 Q1015" )
+                             << true << 270 << 10 << -1 << 10.0 << -1 << static_cast<int>( WeatherDecoder::VFR );
+    QTest::newRow( "gusts KT" ) << QByteArray( "KPAE 251653Z 22015G25KT 3SM -RA BKN015 OVC025 A2990" )
+                                << true << 220 << 15 << 25 << 3.0 << 1500 << static_cast<int>( WeatherDecoder::MVFR );
+    QTest::newRow( "TAF stops at FM" ) << QByteArray( "KSEA 251720Z 2518/2624 18010KT P6SM OVC030 FM252200 20012KT 2SM OVC005" )
+                                       << true << 180 << 10 << -1 << 6.0 << 3000 << static_cast<int>( WeatherDecoder::MVFR );
+    QTest::newRow( "TAF stops at BECMG" ) << QByteArray( "KSEA 251720Z 2518/2624 18010KT P6SM SCT030 BECMG 2520/2522 20012KT 2SM OVC005" )
+                                          << true << 180 << 10 << -1 << 6.0 << -1 << static_cast<int>( WeatherDecoder::VFR );
+    QTest::newRow( "TAF stops at TEMPO" ) << QByteArray( "KSEA 251720Z 2518/2624 18010KT P6SM SCT030 TEMPO 2520/2522 2SM OVC005" )
+                                          << true << 180 << 10 << -1 << 6.0 << -1 << static_cast<int>( WeatherDecoder::VFR );
+    QTest::newRow( "garbage" ) << QByteArray( "garbage" )
+                               << false << -1 << -1 << -1 << -1.0 << -1 << static_cast<int>( WeatherDecoder::UnknownCategory );
+    QTest::newRow( "empty" ) << QByteArray()
+                             << false << -1 << -1 << -1 << -1.0 << -1 << static_cast<int>( WeatherDecoder::UnknownCategory );
+}
+
+
+void TestWeatherDecoder::decode()
+{
+    QFETCH( QByteArray, report );
+    QFETCH( bool, valid );
+    QFETCH( int, windDir );
+    QFETCH( int, windSpeed );
+    QFETCH( int, windGust );
+    QFETCH( double, visibility );
+    QFETCH( int, ceiling );
+    QFETCH( int, category );
+
+    WeatherDecoder::Decoded decoded;
+
+    WeatherDecoder::decode( report, decoded );
+    QCOMPARE( decoded.bValid, valid );
+    QCOMPARE( decoded.iWindDir, windDir );
+    QCOMPARE( decoded.iWindSpeed, windSpeed );
+    QCOMPARE( decoded.iWindGust, windGust );
+    QVERIFY( qAbs( decoded.dVisibility - visibility ) < 0.001 );
+    QCOMPARE( decoded.iCeiling, ceiling );
+    QCOMPARE( static_cast<int>( decoded.eCategory ), category );
+}
+
+
+// Decode rate over a corpus of METARs and TAFs the way they come off the weather stream
+// Every report in it has to decode to something or the rate would be for reports bailing out early.
+void TestWeatherDecoder::throughput()
+{
+    QFile                   corpus( QFINDTESTDATA( "data/reports.txt" ) );
+    QVector<QByteArray>     reports;
+    QByteArray              report;
+    WeatherDecoder::Decoded decoded;
+    int                     iCeilings = 0;
+
+    QVERIFY( corpus.open( QIODevice::ReadOnly ) );
+    while( !corpus.atEnd() )
+    {
+        report = corpus.readLine().trimmed();
+        if( report.isEmpty() || report.startsWith( '#' ) )
+            continue;
+        reports.append( report );
+        WeatherDecoder::decode( report, decoded );
+        QVERIFY2( decoded.bValid, report.constData() );
+    }
+    QVERIFY( reports.count() >= 1000 );
+
+    QBENCHMARK
+    {
+        for( int i = 0; i < reports.count(); i++ )
+        {
+            WeatherDecoder::decode( reports.at( i ), decoded );
+            if( decoded.iCeiling >= 0 )
+                iCeilings++;
+        }
+    }
+    QVERIFY( iCeilings > 0 );
+}
+
+
+QTEST_APPLESS_MAIN( TestWeatherDecoder )
+
+#include "tst_WeatherDecoder.moc"
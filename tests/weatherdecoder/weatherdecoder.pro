@@ -0,0 +1,14 @@
+include( ../tests.pri )
+
+TARGET = tst_weatherdecoder
+
+SOURCES += \
+    tst_WeatherDecoder.cpp \
+    WeatherDecoder.cpp
+
+HEADERS += \
+    WeatherDecoder.h
+
+DISTFILES += \
+    data/reports.txt \
+    data/make_reports.py